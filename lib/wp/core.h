@@ -126,6 +126,9 @@ gboolean wp_core_sync_finish (WpCore * self, GAsyncResult * res,
 WP_API
 void wp_core_install_object_manager (WpCore * self, WpObjectManager * om);
 
+WP_API
+gchar * wp_core_dump_object_manager_stats (WpCore * self);
+
 G_END_DECLS
 
 #endif
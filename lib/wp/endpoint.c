@@ -330,12 +330,13 @@ wp_impl_endpoint_init (WpImplEndpoint * self)
   d->iface = &self->iface;
 }
 
-static void
+/* returns TRUE if the properties are different than before */
+static gboolean
 populate_properties (WpImplEndpoint * self)
 {
   WpPwObjectMixinData *d = wp_pw_object_mixin_get_data (self);
+  g_autoptr (WpProperties) old_props = g_steal_pointer (&d->properties);
 
-  g_clear_pointer (&d->properties, wp_properties_unref);
   d->properties = wp_si_endpoint_get_properties (self->item);
   if (!d->properties)
     d->properties = wp_properties_new_empty ();
@@ -343,13 +344,16 @@ populate_properties (WpImplEndpoint * self)
   wp_properties_update (d->properties, self->immutable_props);
 
   self->info.props = (struct spa_dict *) wp_properties_peek_dict (d->properties);
+
+  return !old_props ||
+      wp_properties_diff (old_props, d->properties, NULL, NULL) > 0;
 }
 
 static void
 on_si_endpoint_properties_changed (WpSiEndpoint * item, WpImplEndpoint * self)
 {
-  populate_properties (self);
-  wp_pw_object_mixin_notify_info (self, PW_ENDPOINT_CHANGE_MASK_PROPS);
+  if (populate_properties (self))
+    wp_pw_object_mixin_notify_info (self, PW_ENDPOINT_CHANGE_MASK_PROPS);
 }
 
 static void
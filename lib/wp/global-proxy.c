@@ -34,6 +34,9 @@
  *
  * \gproperty{permissions, guint, G_PARAM_READABLE,
  *   The pipewire global permissions}
+ *
+ * \gproperty{global-id, guint, G_PARAM_READABLE,
+ *   The id of the pipewire global, available also without binding}
  */
 
 typedef struct _WpGlobalProxyPrivate WpGlobalProxyPrivate;
@@ -50,6 +53,7 @@ enum {
   PROP_FACTORY_NAME,
   PROP_GLOBAL_PROPERTIES,
   PROP_PERMISSIONS,
+  PROP_GLOBAL_ID,
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (WpGlobalProxy, wp_global_proxy, WP_TYPE_PROXY)
@@ -124,6 +128,9 @@ wp_global_proxy_get_property (GObject * object, guint property_id,
   case PROP_GLOBAL_PROPERTIES:
     g_value_take_boxed (value, wp_global_proxy_get_global_properties (self));
     break;
+  case PROP_GLOBAL_ID:
+    g_value_set_uint (value, wp_global_proxy_get_global_id (self));
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     break;
@@ -293,6 +300,11 @@ wp_global_proxy_class_init (WpGlobalProxyClass * klass)
       g_param_spec_uint ("permissions", "permissions",
           "The pipewire global permissions", 0, G_MAXUINT, 0,
           G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_GLOBAL_ID,
+      g_param_spec_uint ("global-id", "global-id",
+          "The pipewire global id", 0, G_MAXUINT, SPA_ID_INVALID,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 }
 
 /*!
@@ -341,6 +353,28 @@ wp_global_proxy_get_permissions (WpGlobalProxy * self)
   return priv->global ? priv->global->permissions : PW_PERM_ALL;
 }
 
+/*!
+ * \brief Gets the id of a pipewire global
+ *
+ * Unlike wp_proxy_get_bound_id(), this does not require the proxy to be
+ * bound, so it also works on the objects of a passive WpObjectManager.
+ *
+ * \ingroup wpglobalproxy
+ * \param self the pipewire global
+ * \returns the id of the global on the registry, or SPA_ID_INVALID if this
+ *   proxy does not represent a global that appeared on the registry
+ */
+guint32
+wp_global_proxy_get_global_id (WpGlobalProxy * self)
+{
+  g_return_val_if_fail (WP_IS_GLOBAL_PROXY (self), SPA_ID_INVALID);
+
+  WpGlobalProxyPrivate *priv =
+      wp_global_proxy_get_instance_private (self);
+
+  return priv->global ? priv->global->id : SPA_ID_INVALID;
+}
+
 /*!
  * \brief Gets the global properties of a pipewire global
  * \ingroup wpglobalproxy
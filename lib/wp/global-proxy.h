@@ -37,6 +37,9 @@ void wp_global_proxy_request_destroy (WpGlobalProxy * self);
 WP_API
 guint32 wp_global_proxy_get_permissions (WpGlobalProxy * self);
 
+WP_API
+guint32 wp_global_proxy_get_global_id (WpGlobalProxy * self);
+
 WP_API
 WpProperties * wp_global_proxy_get_global_properties (
     WpGlobalProxy * self);
@@ -14,6 +14,7 @@
 #include "log.h"
 #include "wpenums.h"
 #include "private/pipewire-object-mixin.h"
+#include "private/registry.h"
 
 #include <pipewire/impl.h>
 
@@ -99,7 +100,7 @@ static guint32 signals[N_SIGNALS] = {0};
 struct _WpNode
 {
   WpGlobalProxy parent;
-  WpObjectManager *ports_om;
+  guint32 ports_node_id;
 };
 
 static void wp_node_pw_object_mixin_priv_interface_init (
@@ -114,6 +115,7 @@ G_DEFINE_TYPE_WITH_CODE (WpNode, wp_node, WP_TYPE_GLOBAL_PROXY,
 static void
 wp_node_init (WpNode * self)
 {
+  self->ports_node_id = SPA_ID_INVALID;
 }
 
 static void
@@ -150,40 +152,53 @@ wp_node_get_property (GObject * object, guint property_id,
 }
 
 static void
-wp_node_on_ports_om_installed (WpObjectManager *ports_om, WpNode * self)
+wp_node_enable_feature_ports (WpNode * self)
 {
-  wp_object_update_features (WP_OBJECT (self), WP_NODE_FEATURE_PORTS, 0);
+  g_autoptr (WpCore) core = wp_object_get_core (WP_OBJECT (self));
+  guint32 bound_id = wp_proxy_get_bound_id (WP_PROXY (self));
+
+  wp_debug_object (self, "enabling WP_NODE_FEATURE_PORTS, bound_id:%u",
+      bound_id);
+
+  /* ports are tracked in a core-wide index that is shared by all nodes,
+     instead of having one object manager per node */
+  self->ports_node_id = bound_id;
+  wp_registry_add_ports_node (wp_core_get_registry (core), bound_id, self);
 }
 
 static void
-wp_node_emit_ports_changed (WpObjectManager *ports_om, WpNode * self)
+wp_node_disable_feature_ports (WpNode * self)
 {
-  g_signal_emit (self, signals[SIGNAL_PORTS_CHANGED], 0);
+  g_autoptr (WpCore) core = wp_object_get_core (WP_OBJECT (self));
+
+  if (core && self->ports_node_id != SPA_ID_INVALID)
+    wp_registry_remove_ports_node (wp_core_get_registry (core),
+        self->ports_node_id, self);
+  self->ports_node_id = SPA_ID_INVALID;
+  wp_object_update_features (WP_OBJECT (self), 0, WP_NODE_FEATURE_PORTS);
 }
 
-static void
-wp_node_enable_feature_ports (WpNode * self)
+static GPtrArray *
+wp_node_peek_ports (WpNode * self)
 {
   g_autoptr (WpCore) core = wp_object_get_core (WP_OBJECT (self));
-  guint32 bound_id = wp_proxy_get_bound_id (WP_PROXY (self));
-
-  wp_debug_object (self, "enabling WP_NODE_FEATURE_PORTS, bound_id:%u",
-      bound_id);
 
-  self->ports_om = wp_object_manager_new ();
-  wp_object_manager_add_interest (self->ports_om,
-      WP_TYPE_PORT,
-      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, PW_KEY_NODE_ID, "=u", bound_id,
-      NULL);
-  wp_object_manager_request_object_features (self->ports_om,
-      WP_TYPE_PORT, WP_OBJECT_FEATURES_ALL);
+  if (!core || self->ports_node_id == SPA_ID_INVALID)
+    return NULL;
+  return wp_registry_get_node_ports (wp_core_get_registry (core),
+      self->ports_node_id);
+}
 
-  g_signal_connect_object (self->ports_om, "installed",
-      G_CALLBACK (wp_node_on_ports_om_installed), self, 0);
-  g_signal_connect_object (self->ports_om, "objects-changed",
-      G_CALLBACK (wp_node_emit_ports_changed), self, 0);
+/* \param interest (transfer full) (nullable) */
+static WpIterator *
+wp_node_new_ports_iterator_internal (WpNode * self,
+    WpObjectInterest * interest)
+{
+  g_autoptr (WpCore) core = wp_object_get_core (WP_OBJECT (self));
 
-  wp_core_install_object_manager (core, self->ports_om);
+  return wp_registry_new_node_ports_iterator (
+      core ? wp_core_get_registry (core) : NULL, self->ports_node_id, self,
+      interest);
 }
 
 static WpObjectFeatures
@@ -228,11 +243,8 @@ wp_node_deactivate (WpObject * object, WpObjectFeatures features)
 {
   wp_pw_object_mixin_deactivate (object, features);
 
-  if (features & WP_NODE_FEATURE_PORTS) {
-    WpNode *self = WP_NODE (object);
-    g_clear_object (&self->ports_om);
-    wp_object_update_features (object, 0, WP_NODE_FEATURE_PORTS);
-  }
+  if (features & WP_NODE_FEATURE_PORTS)
+    wp_node_disable_feature_ports (WP_NODE (object));
 
   WP_OBJECT_CLASS (wp_node_parent_class)->deactivate (object, features);
 }
@@ -257,8 +269,7 @@ wp_node_pw_proxy_destroyed (WpProxy * proxy)
 
   wp_pw_object_mixin_handle_pw_proxy_destroyed (proxy);
 
-  g_clear_object (&self->ports_om);
-  wp_object_update_features (WP_OBJECT (self), 0, WP_NODE_FEATURE_PORTS);
+  wp_node_disable_feature_ports (self);
 
   WP_PROXY_CLASS (wp_node_parent_class)->pw_proxy_destroyed (proxy);
 }
@@ -490,7 +501,8 @@ wp_node_get_n_ports (WpNode * self)
   g_return_val_if_fail (wp_object_get_active_features (WP_OBJECT (self)) &
           WP_NODE_FEATURE_PORTS, 0);
 
-  return wp_object_manager_get_n_objects (self->ports_om);
+  GPtrArray *ports = wp_node_peek_ports (self);
+  return ports ? ports->len : 0;
 }
 
 /*!
@@ -510,7 +522,7 @@ wp_node_new_ports_iterator (WpNode * self)
   g_return_val_if_fail (wp_object_get_active_features (WP_OBJECT (self)) &
           WP_NODE_FEATURE_PORTS, NULL);
 
-  return wp_object_manager_new_iterator (self->ports_om);
+  return wp_node_new_ports_iterator_internal (self, NULL);
 }
 
 /*!
@@ -556,9 +568,9 @@ wp_node_new_ports_filtered_iterator_full (WpNode * self,
   g_return_val_if_fail (WP_IS_NODE (self), NULL);
   g_return_val_if_fail (wp_object_get_active_features (WP_OBJECT (self)) &
           WP_NODE_FEATURE_PORTS, NULL);
+  g_return_val_if_fail (interest != NULL, NULL);
 
-  return wp_object_manager_new_filtered_iterator_full (self->ports_om,
-      interest);
+  return wp_node_new_ports_iterator_internal (self, interest);
 }
 
 /*!
@@ -600,12 +612,13 @@ wp_node_lookup_port (WpNode * self, ...)
 WpPort *
 wp_node_lookup_port_full (WpNode * self, WpObjectInterest * interest)
 {
-  g_return_val_if_fail (WP_IS_NODE (self), NULL);
-  g_return_val_if_fail (wp_object_get_active_features (WP_OBJECT (self)) &
-          WP_NODE_FEATURE_PORTS, NULL);
+  g_auto (GValue) ret = G_VALUE_INIT;
+  g_autoptr (WpIterator) it =
+      wp_node_new_ports_filtered_iterator_full (self, interest);
 
-  return (WpPort *)
-      wp_object_manager_lookup_full (self->ports_om, interest);
+  if (it && wp_iterator_next (it, &ret))
+    return g_value_dup_object (&ret);
+  return NULL;
 }
 
 /*!
@@ -9,6 +9,7 @@
 #define G_LOG_DOMAIN "wp-object-interest"
 
 #include "object-interest.h"
+#include "private/object-interest.h"
 #include "global-proxy.h"
 #include "session-item.h"
 #include "proxy-interfaces.h"
@@ -30,6 +31,18 @@
  * are satisfied.
  */
 
+/* a constraint value, unpacked according to the constraint's subject_type */
+union constraint_value
+{
+  gboolean b;
+  gint32 i;
+  guint32 u;
+  gint64 x;
+  guint64 t;
+  gdouble d;
+  const gchar *s;
+};
+
 struct constraint
 {
   WpConstraintType type;
@@ -37,6 +50,17 @@ struct constraint
   gchar subject_type; /* a basic GVariantType as a single char */
   gchar *subject;
   GVariant *value;
+
+  /* compiled by _validate(), so that matching does not need to
+     unpack `value` or re-parse patterns every time */
+  union constraint_value *values; /* EQUALS, NOT_EQUALS, IN_LIST, IN_RANGE */
+  guint n_values;
+  GPatternSpec *pattern; /* MATCHES */
+  GHashTable *pspecs; /* G_PROPERTY: object GType -> GParamSpec* (nullable) */
+  WpPropKey subject_key; /* PW_PROPERTY, PW_GLOBAL_PROPERTY: well-known key */
+
+  /* the number of evaluations where this was the first constraint to fail */
+  guint64 n_rejects;
 };
 
 struct _WpObjectInterest
@@ -45,6 +69,12 @@ struct _WpObjectInterest
   gboolean valid;
   GType gtype;
   struct pw_array constraints;
+
+  /* statistics; see WpObjectInterestStats */
+  guint64 n_evaluations;
+  guint64 n_matches;
+  guint64 n_type_rejects;
+  guint64 time_ns;
 };
 
 G_DEFINE_BOXED_TYPE (WpObjectInterest, wp_object_interest,
@@ -239,6 +269,12 @@ wp_object_interest_add_constraint (WpObjectInterest * self,
   c->subject_type = '\0';
   c->subject = g_strdup (subject);
   c->value = value ? g_variant_ref_sink (value) : NULL;
+  c->values = NULL;
+  c->n_values = 0;
+  c->pattern = NULL;
+  c->pspecs = NULL;
+  c->subject_key = WP_PROP_KEY_NONE;
+  c->n_rejects = 0;
 
   /* mark as invalid to force validation */
   self->valid = FALSE;
@@ -257,6 +293,73 @@ wp_object_interest_ref (WpObjectInterest *self)
   return self;
 }
 
+static void
+constraint_clear_compiled (struct constraint * c)
+{
+  if (c->subject_type == 's') {
+    for (guint i = 0; i < c->n_values; i++)
+      g_free ((gchar *) c->values[i].s);
+  }
+  g_clear_pointer (&c->values, g_free);
+  c->n_values = 0;
+  g_clear_pointer (&c->pattern, g_pattern_spec_free);
+  g_clear_pointer (&c->pspecs, g_hash_table_unref);
+}
+
+static void
+constraint_value_from_variant (gchar subj_type, GVariant * variant,
+    union constraint_value * val)
+{
+  switch (subj_type) {
+    case 'b': val->b = g_variant_get_boolean (variant); break;
+    case 'i': val->i = g_variant_get_int32 (variant); break;
+    case 'u': val->u = g_variant_get_uint32 (variant); break;
+    case 'x': val->x = g_variant_get_int64 (variant); break;
+    case 't': val->t = g_variant_get_uint64 (variant); break;
+    case 'd': val->d = g_variant_get_double (variant); break;
+    case 's': val->s = g_variant_dup_string (variant, NULL); break;
+    default: g_return_if_reached ();
+  }
+}
+
+/* unpacks the value of a validated constraint into the form that is used
+   while matching */
+static void
+constraint_compile (struct constraint * c)
+{
+  constraint_clear_compiled (c);
+
+  switch (c->verb) {
+    case WP_CONSTRAINT_VERB_EQUALS:
+    case WP_CONSTRAINT_VERB_NOT_EQUALS:
+      c->values = g_new0 (union constraint_value, 1);
+      c->n_values = 1;
+      constraint_value_from_variant (c->subject_type, c->value, c->values);
+      break;
+    case WP_CONSTRAINT_VERB_IN_LIST:
+    case WP_CONSTRAINT_VERB_IN_RANGE: {
+      gsize n_children = g_variant_n_children (c->value);
+      c->values = g_new0 (union constraint_value, n_children);
+      for (gsize i = 0; i < n_children; i++) {
+        g_autoptr (GVariant) child = g_variant_get_child_value (c->value, i);
+        constraint_value_from_variant (c->subject_type, child, &c->values[i]);
+        c->n_values++;
+      }
+      break;
+    }
+    case WP_CONSTRAINT_VERB_MATCHES:
+      c->pattern = g_pattern_spec_new (g_variant_get_string (c->value, NULL));
+      break;
+    default:
+      break;
+  }
+
+  if (c->type == WP_CONSTRAINT_TYPE_G_PROPERTY)
+    c->pspecs = g_hash_table_new (g_direct_hash, g_direct_equal);
+  else
+    c->subject_key = wp_prop_key_from_string (c->subject);
+}
+
 static void
 wp_object_interest_free (WpObjectInterest * self)
 {
@@ -265,6 +368,7 @@ wp_object_interest_free (WpObjectInterest * self)
   g_return_if_fail (self != NULL);
 
   pw_array_for_each (c, &self->constraints) {
+    constraint_clear_compiled (c);
     g_clear_pointer (&c->subject, g_free);
     g_clear_pointer (&c->value, g_variant_unref);
   }
@@ -505,11 +609,98 @@ wp_object_interest_validate (WpObjectInterest * self, GError ** error)
     /* cache the type that the property must have */
     if (value_type)
       c->subject_type = *g_variant_type_peek_string (value_type);
+
+    constraint_compile (c);
   }
 
   return (self->valid = TRUE);
 }
 
+/* private: the GType that objects must be (a descendant of) to match */
+GType
+wp_object_interest_get_gtype (WpObjectInterest * self)
+{
+  g_return_val_if_fail (self != NULL, G_TYPE_INVALID);
+  return self->gtype;
+}
+
+/*
+ * private: the value of the first WP_CONSTRAINT_VERB_EQUALS constraint
+ * of \a type on \a subject, if there is one
+ * \returns (transfer none) (nullable): the constraint's value
+ */
+GVariant *
+wp_object_interest_find_equals_value (WpObjectInterest * self,
+    WpConstraintType type, const gchar * subject)
+{
+  struct constraint *c;
+
+  g_return_val_if_fail (self != NULL, NULL);
+
+  pw_array_for_each (c, &self->constraints) {
+    if (c->type == type && c->verb == WP_CONSTRAINT_VERB_EQUALS &&
+        !g_strcmp0 (c->subject, subject))
+      return c->value;
+  }
+  return NULL;
+}
+
+static gint
+compare_strings (gconstpointer a, gconstpointer b)
+{
+  return g_strcmp0 (*(const gchar **) a, *(const gchar **) b);
+}
+
+/*
+ * \brief Sorts \a parts and joins them after \a prefix, each one preceded
+ * by \a separator, so that the result does not depend on their order
+ *
+ * \param prefix the start of the string
+ * \param separator the character to put before each part
+ * \param parts (element-type gchar*): the parts; they are sorted in place
+ * \returns (transfer full): the joined string
+ */
+gchar *
+wp_object_interest_join_canonical (const gchar * prefix, gchar separator,
+    GPtrArray * parts)
+{
+  GString *str = g_string_new (prefix);
+
+  g_ptr_array_sort (parts, compare_strings);
+  for (guint i = 0; i < parts->len; i++) {
+    g_string_append_c (str, separator);
+    g_string_append (str, g_ptr_array_index (parts, i));
+  }
+  return g_string_free (str, FALSE);
+}
+
+/*
+ * \brief Builds a string that describes the interest canonically
+ *
+ * Two interests that produce the same string match exactly the same objects;
+ * the order of the constraints does not matter.
+ *
+ * \param self the object interest
+ * \returns (transfer full): the canonical description of \a self
+ */
+gchar *
+wp_object_interest_to_canonical_string (WpObjectInterest * self)
+{
+  g_autoptr (GPtrArray) parts = g_ptr_array_new_with_free_func (g_free);
+  struct constraint *c;
+
+  g_return_val_if_fail (self != NULL, NULL);
+
+  pw_array_for_each (c, &self->constraints) {
+    g_autofree gchar *value = c->value ? g_variant_print (c->value, TRUE) : NULL;
+    g_ptr_array_add (parts, g_strdup_printf ("%d:%c:%c:%s:%s", c->type,
+        (gchar) c->verb, c->subject_type ? c->subject_type : '-', c->subject,
+        value ? value : ""));
+  }
+  return wp_object_interest_join_canonical (g_type_name (self->gtype), '|',
+      parts);
+}
+
 G_GNUC_CONST static GType
 subject_type_to_gtype (gchar type)
 {
@@ -526,26 +717,25 @@ subject_type_to_gtype (gchar type)
 }
 
 static inline gboolean
-property_string_to_gvalue (gchar subj_type, const gchar * str, GValue * val)
+property_string_to_value (gchar subj_type, const gchar * str,
+    union constraint_value * val)
 {
-  g_value_init (val, subject_type_to_gtype (subj_type));
-
   switch (subj_type) {
     case 'b':
       if (!strcmp (str, "true") || !strcmp (str, "1"))
-        g_value_set_boolean (val, TRUE);
+        val->b = TRUE;
       else if (!strcmp (str, "false") || !strcmp (str, "0"))
-        g_value_set_boolean (val, FALSE);
+        val->b = FALSE;
       else {
         wp_trace ("failed to convert '%s' to boolean", str);
         return FALSE;
       }
       break;
     case 's':
-      g_value_set_static_string (val, str);
+      val->s = str;
       break;
 
-#define CASE_NUMBER(l, T, convert) \
+#define CASE_NUMBER(l, f, T, convert) \
     case l: { \
       g##T number; \
       errno = 0; \
@@ -554,14 +744,14 @@ property_string_to_gvalue (gchar subj_type, const gchar * str, GValue * val)
         wp_trace ("failed to convert '%s' to " #T, str); \
         return FALSE; \
       } \
-      g_value_set_##T (val, number); \
+      val->f = number; \
       break; \
     }
-    CASE_NUMBER ('i', int, strtol (str, NULL, 10))
-    CASE_NUMBER ('u', uint, strtoul (str, NULL, 10))
-    CASE_NUMBER ('x', int64, strtoll (str, NULL, 10))
-    CASE_NUMBER ('t', uint64, strtoull (str, NULL, 10))
-    CASE_NUMBER ('d', double, strtod (str, NULL))
+    CASE_NUMBER ('i', i, int, strtol (str, NULL, 10))
+    CASE_NUMBER ('u', u, uint, strtoul (str, NULL, 10))
+    CASE_NUMBER ('x', x, int64, strtoll (str, NULL, 10))
+    CASE_NUMBER ('t', t, uint64, strtoull (str, NULL, 10))
+    CASE_NUMBER ('d', d, double, strtod (str, NULL))
 #undef CASE_NUMBER
     default:
       g_return_val_if_reached (FALSE);
@@ -569,27 +759,73 @@ property_string_to_gvalue (gchar subj_type, const gchar * str, GValue * val)
   return TRUE;
 }
 
+static inline GParamSpec *
+constraint_find_pspec (struct constraint * c, GObject * object)
+{
+  gpointer type = GSIZE_TO_POINTER (G_OBJECT_TYPE (object));
+  GParamSpec *pspec = NULL;
+
+  if (!g_hash_table_lookup_extended (c->pspecs, type, NULL,
+          (gpointer *) &pspec)) {
+    pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (object),
+        c->subject);
+    g_hash_table_insert (c->pspecs, type, pspec);
+  }
+  return pspec;
+}
+
+/* \a gvalue holds the property value for as long as \a val is used */
+static inline gboolean
+object_property_to_value (gchar subj_type, GObject * object,
+    GParamSpec * pspec, GValue * gvalue, union constraint_value * val)
+{
+  GType subj_gtype = subject_type_to_gtype (subj_type);
+
+  if (pspec->value_type == subj_gtype) {
+    g_value_init (gvalue, subj_gtype);
+    g_object_get_property (object, pspec->name, gvalue);
+  }
+  /* transform if not compatible */
+  else if (g_value_type_transformable (pspec->value_type, subj_gtype)) {
+    g_auto (GValue) orig = G_VALUE_INIT;
+    g_value_init (&orig, pspec->value_type);
+    g_object_get_property (object, pspec->name, &orig);
+    g_value_init (gvalue, subj_gtype);
+    g_value_transform (&orig, gvalue);
+  }
+  else
+    return FALSE;
+
+  switch (subj_type) {
+    case 'b': val->b = g_value_get_boolean (gvalue); break;
+    case 'i': val->i = g_value_get_int (gvalue); break;
+    case 'u': val->u = g_value_get_uint (gvalue); break;
+    case 'x': val->x = g_value_get_int64 (gvalue); break;
+    case 't': val->t = g_value_get_uint64 (gvalue); break;
+    case 'd': val->d = g_value_get_double (gvalue); break;
+    case 's': val->s = g_value_get_string (gvalue); break;
+    default: g_return_val_if_reached (FALSE);
+  }
+  return TRUE;
+}
+
 static inline gboolean
-constraint_verb_equals (gchar subj_type, const GValue * subj_val,
-    GVariant * check_val)
+constraint_value_equals (gchar subj_type, const union constraint_value * subj,
+    const union constraint_value * check)
 {
   switch (subj_type) {
-    case 'd': {
-      gdouble a = g_value_get_double (subj_val);
-      gdouble b = g_variant_get_double (check_val);
-      return G_APPROX_VALUE (a, b, FLT_EPSILON);
-    }
+    case 'd':
+      return G_APPROX_VALUE (subj->d, check->d, FLT_EPSILON);
     case 's':
-      return !g_strcmp0 (g_value_get_string (subj_val),
-                         g_variant_get_string (check_val, NULL));
-#define CASE_BASIC(l, T, R) \
+      return !g_strcmp0 (subj->s, check->s);
+#define CASE_BASIC(l, f) \
     case l: \
-      return (g_value_get_##T (subj_val) == g_variant_get_##R (check_val));
-    CASE_BASIC ('b', boolean, boolean)
-    CASE_BASIC ('i', int, int32)
-    CASE_BASIC ('u', uint, uint32)
-    CASE_BASIC ('x', int64, int64)
-    CASE_BASIC ('t', uint64, uint64)
+      return (subj->f == check->f);
+    CASE_BASIC ('b', b)
+    CASE_BASIC ('i', i)
+    CASE_BASIC ('u', u)
+    CASE_BASIC ('x', x)
+    CASE_BASIC ('t', t)
 #undef CASE_BASIC
     default:
       g_return_val_if_reached (FALSE);
@@ -597,63 +833,240 @@ constraint_verb_equals (gchar subj_type, const GValue * subj_val,
 }
 
 static inline gboolean
-constraint_verb_matches (gchar subj_type, const GValue * subj_val,
-    GVariant * check_val)
+constraint_verb_equals (struct constraint * c,
+    const union constraint_value * subj)
 {
-  switch (subj_type) {
-    case 's': {
-      const gchar *check_str = g_variant_get_string (check_val, NULL);
-      const gchar *subj_str = g_value_get_string (subj_val);
-      if (!check_str || !subj_str)
+  return constraint_value_equals (c->subject_type, subj, c->values);
+}
+
+static inline gboolean
+constraint_verb_matches (struct constraint * c,
+    const union constraint_value * subj)
+{
+  switch (c->subject_type) {
+    case 's':
+      if (!subj->s)
         return FALSE;
-      return g_pattern_match_simple (check_str, subj_str);
-    }
+      return g_pattern_match_string (c->pattern, subj->s);
     default:
       g_return_val_if_reached (FALSE);
   }
-  return TRUE;
 }
 
 static inline gboolean
-constraint_verb_in_list (gchar subj_type, const GValue * subj_val,
-    GVariant * check_val)
+constraint_verb_in_list (struct constraint * c,
+    const union constraint_value * subj)
 {
-  GVariantIter iter;
-  g_autoptr (GVariant) child = NULL;
-
-  g_variant_iter_init (&iter, check_val);
-  while ((child = g_variant_iter_next_value (&iter))) {
-    if (constraint_verb_equals (subj_type, subj_val, child))
+  for (guint i = 0; i < c->n_values; i++) {
+    if (constraint_value_equals (c->subject_type, subj, &c->values[i]))
       return TRUE;
-    g_variant_unref (child);
   }
   return FALSE;
 }
 
 static inline gboolean
-constraint_verb_in_range (gchar subj_type, const GValue * subj_val,
-    GVariant * check_val)
+constraint_verb_in_range (struct constraint * c,
+    const union constraint_value * subj)
 {
-  switch (subj_type) {
-#define CASE_RANGE(l, t, T) \
-    case l: { \
-      g##T val, min, max; \
-      g_variant_get (check_val, "("#t#t")", &min, &max); \
-      val = g_value_get_##T (subj_val); \
-      if (val < min || val > max) \
-        return FALSE; \
-      break; \
-    }
-    CASE_RANGE('i', i, int)
-    CASE_RANGE('u', u, uint)
-    CASE_RANGE('x', x, int64)
-    CASE_RANGE('t', t, uint64)
-    CASE_RANGE('d', d, double)
+  switch (c->subject_type) {
+#define CASE_RANGE(l, f) \
+    case l: \
+      return (subj->f >= c->values[0].f && subj->f <= c->values[1].f);
+    CASE_RANGE ('i', i)
+    CASE_RANGE ('u', u)
+    CASE_RANGE ('x', x)
+    CASE_RANGE ('t', t)
+    CASE_RANGE ('d', d)
 #undef CASE_RANGE
     default:
       g_return_val_if_reached (FALSE);
   }
-  return TRUE;
+}
+
+static const gchar *
+constraint_type_to_string (WpConstraintType type)
+{
+  switch (type) {
+    case WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY: return "pw-global";
+    case WP_CONSTRAINT_TYPE_PW_PROPERTY: return "pw";
+    case WP_CONSTRAINT_TYPE_G_PROPERTY: return "gobject";
+    default: return "none";
+  }
+}
+
+/* describes the constraint, as in: pw-global media.class = 'Audio/Sink' */
+static void
+constraint_append_description (struct constraint * c, GString * str)
+{
+  g_string_append_printf (str, "%s %s %c", constraint_type_to_string (c->type),
+      c->subject, (gchar) c->verb);
+  if (c->value) {
+    g_autofree gchar *value = g_variant_print (c->value, FALSE);
+    g_string_append_printf (str, " %s", value);
+  }
+}
+
+/*
+ * Checks the subject of \a c on the given object and properties.
+ * If \a subject_desc is not NULL, it is set to a description of the
+ * subject's value, or NULL if the subject does not exist
+ */
+static gboolean
+constraint_check (struct constraint * c, gpointer object,
+    WpProperties * pw_props, WpProperties * pw_global_props,
+    gchar ** subject_desc)
+{
+  WpProperties *lookup_props = pw_global_props;
+  g_auto (GValue) gvalue = G_VALUE_INIT;
+  union constraint_value value = { 0 };
+  gboolean exists = FALSE;
+
+  /* collect, check & convert the subject property */
+  switch (c->type) {
+    case WP_CONSTRAINT_TYPE_PW_PROPERTY:
+      lookup_props = pw_props;
+      SPA_FALLTHROUGH;
+
+    case WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY: {
+      const gchar *lookup_str = NULL;
+
+      if (lookup_props)
+        exists = !!(lookup_str = c->subject_key ?
+            wp_properties_get_by_atom (lookup_props, c->subject_key) :
+            wp_properties_get (lookup_props, c->subject));
+
+      if (exists && c->subject_type)
+        property_string_to_value (c->subject_type, lookup_str, &value);
+      if (subject_desc && exists)
+        *subject_desc = g_strdup_printf ("is '%s'", lookup_str);
+      break;
+    }
+    case WP_CONSTRAINT_TYPE_G_PROPERTY: {
+      GParamSpec *pspec = NULL;
+
+      if (object)
+        exists = !!(pspec = constraint_find_pspec (c, object));
+
+      if (exists && c->subject_type &&
+          !object_property_to_value (c->subject_type, object, pspec,
+              &gvalue, &value)) {
+        if (subject_desc)
+          *subject_desc = g_strdup_printf ("is of incompatible type %s",
+              g_type_name (pspec->value_type));
+        return FALSE;
+      }
+      if (subject_desc && exists) {
+        g_autofree gchar *contents = G_IS_VALUE (&gvalue) ?
+            g_strdup_value_contents (&gvalue) : NULL;
+        *subject_desc = contents ?
+            g_strdup_printf ("is %s", contents) : g_strdup ("is present");
+      }
+      break;
+    }
+    default:
+      g_return_val_if_reached (FALSE);
+  }
+
+  /* match the subject to the constraint's value,
+     according to the operation defined by the verb */
+  switch (c->verb) {
+    case WP_CONSTRAINT_VERB_EQUALS:
+      return exists && constraint_verb_equals (c, &value);
+    case WP_CONSTRAINT_VERB_NOT_EQUALS:
+      return !exists || !constraint_verb_equals (c, &value);
+    case WP_CONSTRAINT_VERB_MATCHES:
+      return exists && constraint_verb_matches (c, &value);
+    case WP_CONSTRAINT_VERB_IN_LIST:
+      return exists && constraint_verb_in_list (c, &value);
+    case WP_CONSTRAINT_VERB_IN_RANGE:
+      return exists && constraint_verb_in_range (c, &value);
+    case WP_CONSTRAINT_VERB_IS_PRESENT:
+      return exists;
+    case WP_CONSTRAINT_VERB_IS_ABSENT:
+      return !exists;
+    default:
+      g_return_val_if_reached (FALSE);
+  }
+}
+
+/*
+ * The implementation of wp_object_interest_matches_full(), without the
+ * validation and the statistics. If \a explanation is not NULL, all the
+ * constraints are checked and every failure is described on a separate line.
+ * \a rejected is set to the first constraint that failed, if any
+ */
+static WpInterestMatch
+wp_object_interest_check (WpObjectInterest * self,
+    WpInterestMatchFlags flags, GType object_type, gpointer object,
+    WpProperties * pw_props, WpProperties * pw_global_props,
+    struct constraint ** rejected, GString * explanation)
+{
+  WpInterestMatch result = WP_INTEREST_MATCH_ALL;
+  g_autoptr (WpProperties) props = NULL;
+  g_autoptr (WpProperties) global_props = NULL;
+  struct constraint *c;
+  guint index = 0;
+
+  if (explanation)
+    flags |= WP_INTEREST_MATCH_FLAGS_CHECK_ALL;
+
+  /* check if the GType matches */
+  if (!g_type_is_a (object_type, self->gtype)) {
+    result &= ~WP_INTEREST_MATCH_GTYPE;
+    if (explanation)
+      g_string_append_printf (explanation, "type %s is not a %s\n",
+          g_type_name (object_type), g_type_name (self->gtype));
+  }
+
+  /* prepare for constraint lookups on proxy properties */
+  if (object) {
+    if (!pw_global_props && WP_IS_GLOBAL_PROXY (object)) {
+      WpGlobalProxy *pwg = (WpGlobalProxy *) object;
+      pw_global_props = global_props =
+          wp_global_proxy_get_global_properties (pwg);
+    }
+
+    if (!pw_props && WP_IS_PIPEWIRE_OBJECT (object)) {
+      WpObject *oo = (WpObject *) object;
+      WpPipewireObject *pwo = (WpPipewireObject *) object;
+
+      if (wp_object_get_active_features (oo) & WP_PIPEWIRE_OBJECT_FEATURE_INFO)
+        pw_props = props = wp_pipewire_object_get_properties (pwo);
+    }
+
+    if (!pw_global_props && WP_IS_SESSION_ITEM (object)) {
+      WpSessionItem *si = (WpSessionItem *) object;
+      pw_global_props = props = wp_session_item_get_properties (si);
+    }
+  }
+
+  /* check all constraints; if any of them fails at any point, fail the match */
+  pw_array_for_each (c, &self->constraints) {
+    g_autofree gchar *subject_desc = NULL;
+
+    index++;
+
+    /* return early if the match failed and CHECK_ALL is not specified */
+    if (!(flags & WP_INTEREST_MATCH_FLAGS_CHECK_ALL) &&
+        result != WP_INTEREST_MATCH_ALL)
+      break;
+
+    if (constraint_check (c, object, pw_props, pw_global_props,
+            explanation ? &subject_desc : NULL))
+      continue;
+
+    result &= ~(1 << c->type);
+    if (rejected && !*rejected)
+      *rejected = c;
+
+    if (explanation) {
+      g_string_append_printf (explanation, "constraint %u (", index);
+      constraint_append_description (c, explanation);
+      g_string_append_printf (explanation, ") failed: %s %s\n", c->subject,
+          subject_desc ? subject_desc : "is absent");
+    }
+  }
+  return result;
 }
 
 /*!
@@ -731,11 +1144,9 @@ wp_object_interest_matches_full (WpObjectInterest * self,
     WpInterestMatchFlags flags, GType object_type, gpointer object,
     WpProperties * pw_props, WpProperties * pw_global_props)
 {
-  WpInterestMatch result = WP_INTEREST_MATCH_ALL;
-  g_autoptr (WpProperties) props = NULL;
-  g_autoptr (WpProperties) global_props = NULL;
   g_autoptr (GError) error = NULL;
-  struct constraint *c;
+  struct constraint *rejected = NULL;
+  WpInterestMatch result;
 
   g_return_val_if_fail (self != NULL, WP_INTEREST_MATCH_NONE);
 
@@ -745,135 +1156,157 @@ wp_object_interest_matches_full (WpObjectInterest * self,
     return WP_INTEREST_MATCH_NONE;
   }
 
-  /* check if the GType matches */
-  if (!g_type_is_a (object_type, self->gtype))
-    result &= ~WP_INTEREST_MATCH_GTYPE;
+  result = wp_object_interest_check (self, flags, object_type, object,
+      pw_props, pw_global_props, &rejected, NULL);
 
-  /* prepare for constraint lookups on proxy properties */
-  if (object) {
-    if (!pw_global_props && WP_IS_GLOBAL_PROXY (object)) {
-      WpGlobalProxy *pwg = (WpGlobalProxy *) object;
-      pw_global_props = global_props =
-          wp_global_proxy_get_global_properties (pwg);
-    }
+  self->n_evaluations++;
+  if (result == WP_INTEREST_MATCH_ALL)
+    self->n_matches++;
+  else if (!(result & WP_INTEREST_MATCH_GTYPE))
+    self->n_type_rejects++;
+  else if (rejected)
+    rejected->n_rejects++;
 
-    if (!pw_props && WP_IS_PIPEWIRE_OBJECT (object)) {
-      WpObject *oo = (WpObject *) object;
-      WpPipewireObject *pwo = (WpPipewireObject *) object;
+  return result;
+}
 
-      if (wp_object_get_active_features (oo) & WP_PIPEWIRE_OBJECT_FEATURE_INFO)
-        pw_props = props = wp_pipewire_object_get_properties (pwo);
-    }
+/*!
+ * \brief Explains why the specified \a object does not match \a self
+ *
+ * All the constraints are checked, like with
+ * WP_INTEREST_MATCH_FLAGS_CHECK_ALL, and every failure is described on a
+ * separate line of the returned string: the object's type, if it is not of
+ * the interest's type, or the constraint (numbered from 1, in the order
+ * that the constraints were added) and the value that the subject has on
+ * \a object. Constraints that fail often are best placed first, as the
+ * rest of the constraints are not checked after the first failure.
+ *
+ * \a object is interpreted like in wp_object_interest_matches().
+ * This function does not affect the statistics of \a self.
+ *
+ * \ingroup wpobjectinterest
+ * \param self the object interest
+ * \param object the target object to check
+ * \returns (transfer full) (nullable): the description of all the failures,
+ *   or NULL if \a object matches
+ */
+gchar *
+wp_object_interest_explain (WpObjectInterest * self, gpointer object)
+{
+  g_autoptr (GError) error = NULL;
+  GString *explanation;
+  WpInterestMatch result;
+  gboolean is_props;
 
-    if (!pw_global_props && WP_IS_SESSION_ITEM (object)) {
-      WpSessionItem *si = (WpSessionItem *) object;
-      pw_global_props = props = wp_session_item_get_properties (si);
-    }
+  g_return_val_if_fail (self != NULL, NULL);
+
+  if (!wp_object_interest_validate (self, &error))
+    return g_strdup_printf ("invalid interest: %s\n", error->message);
+
+  is_props = g_type_is_a (self->gtype, WP_TYPE_PROPERTIES);
+  if (is_props)
+    g_return_val_if_fail (object != NULL, NULL);
+  else
+    g_return_val_if_fail (G_IS_OBJECT (object), NULL);
+
+  explanation = g_string_new (NULL);
+  if (is_props)
+    result = wp_object_interest_check (self, 0, self->gtype, NULL,
+        (WpProperties *) object, NULL, NULL, explanation);
+  else
+    result = wp_object_interest_check (self, 0, G_OBJECT_TYPE (object),
+        object, NULL, NULL, NULL, explanation);
+
+  if (result == WP_INTEREST_MATCH_ALL) {
+    g_string_free (explanation, TRUE);
+    return NULL;
   }
+  return g_string_free (explanation, FALSE);
+}
+
+/*!
+ * \brief Gets the statistics of the evaluations of \a self
+ *
+ * The statistics are collected every time that the interest is evaluated by
+ * wp_object_interest_matches() or wp_object_interest_matches_full(),
+ * including the evaluations that are done by a WpObjectManager.
+ *
+ * \ingroup wpobjectinterest
+ * \param self the object interest
+ * \param stats (out caller-allocates): the location to store the statistics
+ */
+void
+wp_object_interest_get_stats (WpObjectInterest * self,
+    WpObjectInterestStats * stats)
+{
+  struct constraint *c;
+  guint index = 0;
+
+  g_return_if_fail (self != NULL);
+  g_return_if_fail (stats != NULL);
+
+  stats->n_evaluations = self->n_evaluations;
+  stats->n_matches = self->n_matches;
+  stats->n_type_rejects = self->n_type_rejects;
+  stats->time_ns = self->time_ns;
+  stats->top_reject_constraint = 0;
+  stats->n_top_rejects = 0;
 
-  /* check all constraints; if any of them fails at any point, fail the match */
   pw_array_for_each (c, &self->constraints) {
-    WpProperties *lookup_props = pw_global_props;
-    g_auto (GValue) value = G_VALUE_INIT;
-    gboolean exists = FALSE;
+    index++;
+    if (c->n_rejects > stats->n_top_rejects) {
+      stats->top_reject_constraint = index;
+      stats->n_top_rejects = c->n_rejects;
+    }
+  }
+}
 
-    /* return early if the match failed and CHECK_ALL is not specified */
-    if (!(flags & WP_INTEREST_MATCH_FLAGS_CHECK_ALL) &&
-        result != WP_INTEREST_MATCH_ALL)
-      return result;
+/*!
+ * \brief Resets all the statistics of \a self to zero
+ *
+ * \ingroup wpobjectinterest
+ * \param self the object interest
+ */
+void
+wp_object_interest_reset_stats (WpObjectInterest * self)
+{
+  struct constraint *c;
 
-    /* collect, check & convert the subject property */
-    switch (c->type) {
-      case WP_CONSTRAINT_TYPE_PW_PROPERTY:
-        lookup_props = pw_props;
-        SPA_FALLTHROUGH;
+  g_return_if_fail (self != NULL);
 
-      case WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY: {
-        const gchar *lookup_str = NULL;
+  self->n_evaluations = 0;
+  self->n_matches = 0;
+  self->n_type_rejects = 0;
+  self->time_ns = 0;
+  pw_array_for_each (c, &self->constraints)
+    c->n_rejects = 0;
+}
 
-        if (lookup_props)
-          exists = !!(lookup_str = wp_properties_get (lookup_props, c->subject));
+/* private: accounts time spent by an object manager evaluating \a self */
+void
+wp_object_interest_add_time (WpObjectInterest * self, guint64 time_ns)
+{
+  self->time_ns += time_ns;
+}
 
-        if (exists && c->subject_type)
-          property_string_to_gvalue (c->subject_type, lookup_str, &value);
-        break;
-      }
-      case WP_CONSTRAINT_TYPE_G_PROPERTY: {
-        GType value_type;
-        GParamSpec *pspec = NULL;
-
-        if (object)
-          exists = !!(pspec = g_object_class_find_property (
-              G_OBJECT_GET_CLASS (object), c->subject));
-
-        if (exists && c->subject_type) {
-          g_value_init (&value, pspec->value_type);
-          g_object_get_property (object, c->subject, &value);
-          value_type = G_VALUE_TYPE (&value);
-
-          /* transform if not compatible */
-          if (value_type != subject_type_to_gtype (c->subject_type)) {
-            if (g_value_type_transformable (value_type,
-                    subject_type_to_gtype (c->subject_type))) {
-              g_auto (GValue) orig = G_VALUE_INIT;
-              g_value_init (&orig, value_type);
-              g_value_copy (&value, &orig);
-              g_value_unset (&value);
-              g_value_init (&value, subject_type_to_gtype (c->subject_type));
-              g_value_transform (&orig, &value);
-            }
-            else {
-              result &= ~(1 << c->type);
-              continue;
-            }
-          }
-        }
+/* private: describes \a self and its statistics, on multiple lines */
+void
+wp_object_interest_append_stats (WpObjectInterest * self, GString * str,
+    const gchar * indent)
+{
+  struct constraint *c;
+  guint index = 0;
 
-        break;
-      }
-      default:
-        g_return_val_if_reached (WP_INTEREST_MATCH_NONE);
-    }
+  g_string_append_printf (str, "%sinterest %s: %" G_GUINT64_FORMAT
+      " evaluations, %" G_GUINT64_FORMAT " matches, %" G_GUINT64_FORMAT
+      " type rejects, %" G_GUINT64_FORMAT " us\n", indent,
+      g_type_name (self->gtype), self->n_evaluations, self->n_matches,
+      self->n_type_rejects, self->time_ns / 1000);
 
-    /* match the subject to the constraint's value,
-       according to the operation defined by the verb */
-    switch (c->verb) {
-      case WP_CONSTRAINT_VERB_EQUALS:
-        if (!exists ||
-            !constraint_verb_equals (c->subject_type, &value, c->value))
-          result &= ~(1 << c->type);
-        break;
-      case WP_CONSTRAINT_VERB_NOT_EQUALS:
-        if (exists &&
-            constraint_verb_equals (c->subject_type, &value, c->value))
-          result &= ~(1 << c->type);
-        break;
-      case WP_CONSTRAINT_VERB_MATCHES:
-        if (!exists ||
-            !constraint_verb_matches (c->subject_type, &value, c->value))
-          result &= ~(1 << c->type);
-        break;
-      case WP_CONSTRAINT_VERB_IN_LIST:
-        if (!exists ||
-            !constraint_verb_in_list (c->subject_type, &value, c->value))
-          result &= ~(1 << c->type);
-        break;
-      case WP_CONSTRAINT_VERB_IN_RANGE:
-        if (!exists ||
-            !constraint_verb_in_range (c->subject_type, &value, c->value))
-          result &= ~(1 << c->type);
-        break;
-      case WP_CONSTRAINT_VERB_IS_PRESENT:
-        if (!exists)
-          result &= ~(1 << c->type);
-        break;
-      case WP_CONSTRAINT_VERB_IS_ABSENT:
-        if (exists)
-          result &= ~(1 << c->type);
-        break;
-      default:
-        g_return_val_if_reached (WP_INTEREST_MATCH_NONE);
-    }
+  pw_array_for_each (c, &self->constraints) {
+    g_string_append_printf (str, "%s  constraint %u (", indent, ++index);
+    constraint_append_description (c, str);
+    g_string_append_printf (str, "): %" G_GUINT64_FORMAT " rejects\n",
+        c->n_rejects);
   }
-  return result;
 }
@@ -131,6 +131,44 @@ WpInterestMatch wp_object_interest_matches_full (WpObjectInterest * self,
     WpInterestMatchFlags flags, GType object_type, gpointer object,
     WpProperties * pw_props, WpProperties * pw_global_props);
 
+WP_API
+gchar * wp_object_interest_explain (WpObjectInterest * self, gpointer object);
+
+/* statistics */
+
+typedef struct _WpObjectInterestStats WpObjectInterestStats;
+
+/*!
+ * \brief Statistics of the evaluations of an object interest
+ * \ingroup wpobjectinterest
+ */
+struct _WpObjectInterestStats
+{
+  /*! the number of times that the interest was evaluated */
+  guint64 n_evaluations;
+  /*! the number of evaluations that matched */
+  guint64 n_matches;
+  /*! the number of evaluations that failed because of the object's type */
+  guint64 n_type_rejects;
+  /*! the time spent in evaluations that were done by object managers,
+      in nanoseconds; only measured when "wireplumber.om-timing" is set in
+      the context properties, 0 otherwise */
+  guint64 time_ns;
+  /*! the constraint (numbered from 1, in the order that the constraints
+      were added) that was most often the first one to fail, or 0 */
+  guint top_reject_constraint;
+  /*! the number of evaluations where top_reject_constraint was the first
+      constraint to fail */
+  guint64 n_top_rejects;
+};
+
+WP_API
+void wp_object_interest_get_stats (WpObjectInterest * self,
+    WpObjectInterestStats * stats);
+
+WP_API
+void wp_object_interest_reset_stats (WpObjectInterest * self);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC (WpObjectInterest, wp_object_interest_unref)
 
 G_END_DECLS
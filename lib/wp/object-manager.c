@@ -10,9 +10,17 @@
 
 #include "object-manager.h"
 #include "log.h"
+#include "port.h"
 #include "proxy-interfaces.h"
+#include "session-item.h"
 #include "private/registry.h"
+#include "private/object-interest.h"
 
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <pipewire/pipewire.h>
 
 /*! \defgroup wpobjectmanager WpObjectManager */
@@ -111,6 +119,49 @@
  * Flags: G_SIGNAL_RUN_FIRST
  * \endparblock
  *
+ * \par objects-added
+ * \parblock
+ * \code
+ * void
+ * objects_added_callback (WpObjectManager * self,
+ *                         GPtrArray * objects,
+ *                         gpointer user_data)
+ * \endcode
+ *
+ * Batched version of \c object-added. Emitted once per dispatch cycle, right
+ * before \c objects-changed, with all the objects that were added since the
+ * previous emission and are still managed. Objects are only collected while
+ * there is a handler connected to this signal or to \c objects-changed.
+ *
+ * Parameters:
+ * - `objects` (element-type GObject) - the objects that were added
+ *
+ * Flags: G_SIGNAL_RUN_FIRST
+ * \endparblock
+ *
+ * \par objects-removed
+ * \parblock
+ * \code
+ * void
+ * objects_removed_callback (WpObjectManager * self,
+ *                           GPtrArray * objects,
+ *                           gpointer user_data)
+ * \endcode
+ *
+ * Batched version of \c object-removed. Emitted once per dispatch cycle,
+ * before \c objects-added, with all the objects that were removed since the
+ * previous emission. Objects that were both added and removed within the
+ * same cycle are reported in neither batch. The objects are kept alive until
+ * the end of the emission, but they may already have been destroyed on the
+ * PipeWire side. Objects are only collected while there is a handler
+ * connected to this signal or to \c objects-changed.
+ *
+ * Parameters:
+ * - `objects` (element-type GObject) - the objects that were removed
+ *
+ * Flags: G_SIGNAL_RUN_FIRST
+ * \endparblock
+ *
  * \par objects-changed
  * \parblock
  * \code
@@ -123,11 +174,57 @@
  * this object manager. This signal is useful to get notified only once when
  * multiple changes happen in a short timespan. The receiving callback may
  * retrieve the updated list of objects by calling wp_object_manager_new_iterator()
+ * or, to only process what changed, call
+ * wp_object_manager_get_pending_changes()
  *
  * Flags: G_SIGNAL_RUN_FIRST
  * \endparblock
  */
 
+struct om_index
+{
+  WpConstraintType type;
+  gchar *key;
+  WpPropKey atom;
+  /* element-type: <normalized value, GPtrArray of objects without a ref> */
+  GHashTable *buckets;
+  /* element-type: <object, normalized value as stored in buckets> */
+  GHashTable *values;
+};
+
+struct om_sorted_entry
+{
+  GObject *object; /* without a ref */
+  /* unique and even; orders objects with the same values by age and
+     leaves the odd numbers free to search for the position after an entry */
+  guint64 serial;
+  gdouble values[];
+};
+
+struct om_sorted_view
+{
+  grefcount ref;
+  WpConstraintType type;
+  GStrv keys;
+  WpSortedViewFlags flags;
+  WpPropKey *atoms;
+  guint n_keys;
+  /* element-type: struct om_sorted_entry*, with the highest values first */
+  GSequence *entries;
+  /* element-type: <object, GSequenceIter* of its entry> */
+  GHashTable *iters;
+  guint64 next_serial;
+  /* moves on every time the order of 'entries' changes */
+  guint gen;
+};
+
+/* a proxy that is being activated before it is added to 'om' */
+struct om_pending
+{
+  WpObjectManager *om; /* the object manager that holds the objects */
+  WpGlobal *global;
+};
+
 struct _WpObjectManager
 {
   GObject parent;
@@ -139,11 +236,48 @@ struct _WpObjectManager
   GHashTable *features;
   /* objects that we are interested in, without a ref */
   GPtrArray *objects;
-
+  /* element-type: <object, GUINT_TO_POINTER (its index in 'objects')> */
+  GHashTable *positions;
+  /* iterators walk 'objects' in place; while there are readers, it is
+     replaced by a copy before being modified and the generation moves on */
+  guint objects_gen;
+  guint objects_readers;
+  /* element-type: struct om_index* */
+  GPtrArray *indexes;
+  /* element-type: struct om_sorted_view* */
+  GPtrArray *views;
+  /* objects added / removed since the last objects-changed, with a ref */
+  GPtrArray *batch_added;
+  GPtrArray *batch_removed;
+  /* object -> its index in batch_added */
+  GHashTable *batch_positions;
+  /* the batches that are being reported, while objects-changed is emitted */
+  GPtrArray *emitting_added;
+  GPtrArray *emitting_removed;
+
+  /* once a second object manager with the same interests and requested
+     features is installed, both of them share a hidden 'leader' that holds
+     the objects and evaluates the interests; the object managers of the
+     users are its 'followers' and only keep their own signal emission state
+     and a record of the indexes and the sorted views that they requested */
+  WpObjectManager *leader;
+  /* element-type: WpObjectManager*, without a ref */
+  GPtrArray *followers;
+  gchar *share_key;
+  gboolean hidden;
+
+  gboolean passive;
   gboolean installed;
   gboolean changed;
-  guint pending_objects;
+  /* element-type: struct om_pending*, owned by the activations */
+  GPtrArray *pending;
   GSource *idle_source;
+
+  /* statistics; see WpObjectManagerStats */
+  gboolean timing;
+  guint64 n_evaluations;
+  guint64 n_matches;
+  guint64 time_ns;
 };
 
 enum {
@@ -154,6 +288,8 @@ enum {
 enum {
   SIGNAL_OBJECT_ADDED,
   SIGNAL_OBJECT_REMOVED,
+  SIGNAL_OBJECTS_ADDED,
+  SIGNAL_OBJECTS_REMOVED,
   SIGNAL_OBJECTS_CHANGED,
   SIGNAL_INSTALLED,
   LAST_SIGNAL,
@@ -163,6 +299,402 @@ static guint signals[LAST_SIGNAL] = { 0 };
 
 G_DEFINE_TYPE (WpObjectManager, wp_object_manager, G_TYPE_OBJECT)
 
+/* every managed object carries the list of object managers that hold it,
+   so that removing it only needs to visit those */
+static G_DEFINE_QUARK (wp-object-managers, managing_oms);
+
+static void wp_object_manager_interests_changed (WpObjectManager * self);
+
+static GPtrArray *
+object_get_managing_oms (gpointer object)
+{
+  return g_object_get_qdata (G_OBJECT (object), managing_oms_quark ());
+}
+
+static void
+object_add_managing_om (gpointer object, WpObjectManager * om)
+{
+  GPtrArray *oms = object_get_managing_oms (object);
+
+  if (!oms) {
+    oms = g_ptr_array_new ();
+    g_object_set_qdata_full (G_OBJECT (object), managing_oms_quark (), oms,
+        (GDestroyNotify) g_ptr_array_unref);
+  }
+  g_ptr_array_add (oms, om);
+}
+
+static void
+object_remove_managing_om (gpointer object, WpObjectManager * om)
+{
+  GPtrArray *oms = object_get_managing_oms (object);
+
+  if (oms)
+    g_ptr_array_remove_fast (oms, om);
+}
+
+/* the object manager that holds the objects on behalf of self */
+static inline WpObjectManager *
+wp_object_manager_get_storage (WpObjectManager * self)
+{
+  return self->leader ? self->leader : self;
+}
+
+static struct om_index *
+om_index_new (WpConstraintType type, const gchar * key)
+{
+  struct om_index *idx = g_slice_new0 (struct om_index);
+  idx->type = type;
+  idx->key = g_strdup (key);
+  idx->atom = wp_prop_key_from_string (key);
+  idx->buckets = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, (GDestroyNotify) g_ptr_array_unref);
+  idx->values = g_hash_table_new (g_direct_hash, g_direct_equal);
+  return idx;
+}
+
+static void
+om_index_free (struct om_index * idx)
+{
+  g_clear_pointer (&idx->values, g_hash_table_unref);
+  g_clear_pointer (&idx->buckets, g_hash_table_unref);
+  g_free (idx->key);
+  g_slice_free (struct om_index, idx);
+}
+
+/* numbers are stored in canonical decimal form, so that numeric constraint
+   values (ex. "=u") can find them without caring about the formatting */
+static gchar *
+om_index_normalize_value (const gchar * str)
+{
+  if (g_ascii_isdigit (str[0]) ||
+      (str[0] == '-' && g_ascii_isdigit (str[1]))) {
+    gint64 number;
+    errno = 0;
+    number = g_ascii_strtoll (str, NULL, 10);
+    if (errno == 0)
+      return g_strdup_printf ("%" G_GINT64_FORMAT, number);
+  }
+  return g_strdup (str);
+}
+
+static gchar *
+om_index_variant_to_value (GVariant * value)
+{
+  switch (*g_variant_get_type_string (value)) {
+    case 's':
+      return om_index_normalize_value (g_variant_get_string (value, NULL));
+    case 'i':
+      return g_strdup_printf ("%" G_GINT32_FORMAT, g_variant_get_int32 (value));
+    case 'u':
+      return g_strdup_printf ("%" G_GUINT32_FORMAT, g_variant_get_uint32 (value));
+    case 'x':
+      return g_strdup_printf ("%" G_GINT64_FORMAT, g_variant_get_int64 (value));
+    case 't':
+      return g_strdup_printf ("%" G_GUINT64_FORMAT, g_variant_get_uint64 (value));
+    default:
+      /* booleans and doubles have too many string representations */
+      return NULL;
+  }
+}
+
+/* retrieves the normalized value of the \a key property of \a object in the
+   same way that wp_object_interest_matches_full() does */
+static gchar *
+om_get_object_value (WpConstraintType type, const gchar * key, WpPropKey atom,
+    GObject * object)
+{
+  g_autoptr (WpProperties) props = NULL;
+  const gchar *str = NULL;
+
+  switch (type) {
+    case WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY:
+      if (WP_IS_GLOBAL_PROXY (object))
+        props = wp_global_proxy_get_global_properties (WP_GLOBAL_PROXY (object));
+      else if (WP_IS_SESSION_ITEM (object))
+        props = wp_session_item_get_properties (WP_SESSION_ITEM (object));
+      break;
+
+    case WP_CONSTRAINT_TYPE_PW_PROPERTY:
+      if (WP_IS_PIPEWIRE_OBJECT (object) &&
+          (wp_object_get_active_features (WP_OBJECT (object)) &
+              WP_PIPEWIRE_OBJECT_FEATURE_INFO))
+        props = wp_pipewire_object_get_properties (WP_PIPEWIRE_OBJECT (object));
+      break;
+
+    case WP_CONSTRAINT_TYPE_G_PROPERTY: {
+      GParamSpec *pspec = g_object_class_find_property (
+          G_OBJECT_GET_CLASS (object), key);
+
+      if (pspec && g_value_type_transformable (pspec->value_type,
+              G_TYPE_STRING)) {
+        g_auto (GValue) value = G_VALUE_INIT;
+        g_auto (GValue) strvalue = G_VALUE_INIT;
+
+        g_value_init (&value, pspec->value_type);
+        g_value_init (&strvalue, G_TYPE_STRING);
+        g_object_get_property (object, key, &value);
+        if (g_value_transform (&value, &strvalue) &&
+            (str = g_value_get_string (&strvalue)))
+          return om_index_normalize_value (str);
+      }
+      return NULL;
+    }
+    default:
+      g_return_val_if_reached (NULL);
+  }
+
+  if (props)
+    str = atom ? wp_properties_get_by_atom (props, atom) :
+        wp_properties_get (props, key);
+  return str ? om_index_normalize_value (str) : NULL;
+}
+
+static void
+om_index_insert (struct om_index * idx, GObject * object)
+{
+  gchar *value = om_get_object_value (idx->type, idx->key, idx->atom, object);
+  gpointer stored = NULL;
+  GPtrArray *bucket = NULL;
+
+  /* objects without a value can never match an "equals" constraint */
+  if (!value)
+    return;
+
+  if (g_hash_table_lookup_extended (idx->buckets, value, &stored,
+          (gpointer *) &bucket)) {
+    g_free (value);
+  } else {
+    stored = value;
+    bucket = g_ptr_array_new ();
+    g_hash_table_insert (idx->buckets, value, bucket);
+  }
+  g_ptr_array_add (bucket, object);
+  g_hash_table_insert (idx->values, object, stored);
+}
+
+static void
+om_index_remove (struct om_index * idx, GObject * object)
+{
+  const gchar *value = g_hash_table_lookup (idx->values, object);
+  GPtrArray *bucket;
+
+  if (!value)
+    return;
+
+  g_hash_table_remove (idx->values, object);
+  bucket = g_hash_table_lookup (idx->buckets, value);
+  g_ptr_array_remove (bucket, object);
+  if (bucket->len == 0)
+    g_hash_table_remove (idx->buckets, value);
+}
+
+static struct om_sorted_view *
+om_sorted_view_new (WpConstraintType type, const gchar * const * keys,
+    WpSortedViewFlags flags)
+{
+  struct om_sorted_view *view = g_slice_new0 (struct om_sorted_view);
+  g_ref_count_init (&view->ref);
+  view->type = type;
+  view->keys = g_strdupv ((gchar **) keys);
+  view->flags = flags;
+  view->n_keys = g_strv_length (view->keys);
+  view->atoms = g_new (WpPropKey, view->n_keys);
+  for (guint i = 0; i < view->n_keys; i++)
+    view->atoms[i] = wp_prop_key_from_string (keys[i]);
+  view->entries = g_sequence_new (g_free);
+  view->iters = g_hash_table_new (g_direct_hash, g_direct_equal);
+  view->next_serial = 0;
+  view->gen = 0;
+  return view;
+}
+
+static struct om_sorted_view *
+om_sorted_view_ref (struct om_sorted_view * view)
+{
+  g_ref_count_inc (&view->ref);
+  return view;
+}
+
+static void
+om_sorted_view_unref (struct om_sorted_view * view)
+{
+  if (g_ref_count_dec (&view->ref)) {
+    g_clear_pointer (&view->iters, g_hash_table_unref);
+    g_clear_pointer (&view->entries, g_sequence_free);
+    g_free (view->atoms);
+    g_strfreev (view->keys);
+    g_slice_free (struct om_sorted_view, view);
+  }
+}
+
+static gint
+om_sorted_entry_compare (gconstpointer a, gconstpointer b, gpointer data)
+{
+  const struct om_sorted_entry *ea = a;
+  const struct om_sorted_entry *eb = b;
+  const struct om_sorted_view *view = data;
+
+  for (guint i = 0; i < view->n_keys; i++) {
+    if (ea->values[i] != eb->values[i])
+      return (ea->values[i] > eb->values[i]) ? -1 : 1;
+  }
+  return (ea->serial > eb->serial) - (ea->serial < eb->serial);
+}
+
+/* parses \a str like tonumber() does in the Lua scripts that used to do
+   the sorting, so that fractional and exponent values sort the same way;
+   strings that are not entirely a number give 0 */
+static gdouble
+om_sorted_view_parse_value (const gchar * str, WpSortedViewFlags flags)
+{
+  gchar *end = NULL;
+  gdouble value;
+
+  if (!str)
+    return 0;
+  if (flags & WP_SORTED_VIEW_FLAG_INTEGER)
+    return atoi (str);
+
+  value = g_ascii_strtod (str, &end);
+  if (end == str || isnan (value))
+    return 0;
+  while (g_ascii_isspace (*end))
+    end++;
+  return (*end == '\0') ? value : 0;
+}
+
+/* objects that do not have a key, or have a non-numeric value on it,
+   are sorted as if the value was 0 */
+static void
+om_sorted_view_get_object_values (struct om_sorted_view * view,
+    GObject * object, gdouble * values)
+{
+  for (guint i = 0; i < view->n_keys; i++) {
+    g_autofree gchar *str = om_get_object_value (view->type, view->keys[i],
+        view->atoms[i], object);
+    values[i] = om_sorted_view_parse_value (str, view->flags);
+  }
+}
+
+static void
+om_sorted_view_insert (struct om_sorted_view * view, GObject * object)
+{
+  struct om_sorted_entry *entry = g_malloc (sizeof (struct om_sorted_entry) +
+      view->n_keys * sizeof (gdouble));
+  GSequenceIter *iter;
+
+  entry->object = object;
+  entry->serial = view->next_serial;
+  view->next_serial += 2;
+  om_sorted_view_get_object_values (view, object, entry->values);
+
+  iter = g_sequence_insert_sorted (view->entries, entry,
+      om_sorted_entry_compare, view);
+  g_hash_table_insert (view->iters, object, iter);
+  view->gen++;
+}
+
+static void
+om_sorted_view_remove (struct om_sorted_view * view, GObject * object)
+{
+  GSequenceIter *iter = g_hash_table_lookup (view->iters, object);
+
+  if (!iter)
+    return;
+
+  g_hash_table_remove (view->iters, object);
+  g_sequence_remove (iter);
+  view->gen++;
+}
+
+static void
+om_sorted_view_update (struct om_sorted_view * view, GObject * object)
+{
+  GSequenceIter *iter = g_hash_table_lookup (view->iters, object);
+  struct om_sorted_entry *entry;
+  gdouble *values;
+
+  if (!iter)
+    return;
+
+  entry = g_sequence_get (iter);
+  values = g_newa (gdouble, view->n_keys);
+  om_sorted_view_get_object_values (view, object, values);
+
+  if (memcmp (values, entry->values, view->n_keys * sizeof (gdouble)) != 0) {
+    memcpy (entry->values, values, view->n_keys * sizeof (gdouble));
+    g_sequence_sort_changed (iter, om_sorted_entry_compare, view);
+    view->gen++;
+  }
+}
+
+static void
+on_indexed_object_notify (GObject * object, GParamSpec * pspec,
+    WpObjectManager * self)
+{
+  const gchar *name = g_param_spec_get_name (pspec);
+
+  for (guint i = 0; i < self->indexes->len; i++) {
+    struct om_index *idx = g_ptr_array_index (self->indexes, i);
+    const gchar *watched = (idx->type == WP_CONSTRAINT_TYPE_G_PROPERTY) ?
+        idx->key : "properties";
+
+    if (!g_strcmp0 (name, watched)) {
+      om_index_remove (idx, object);
+      om_index_insert (idx, object);
+    }
+  }
+
+  for (guint i = 0; i < self->views->len; i++) {
+    struct om_sorted_view *view = g_ptr_array_index (self->views, i);
+    const gchar *watched = (view->type == WP_CONSTRAINT_TYPE_G_PROPERTY) ?
+        NULL : "properties";
+
+    if (watched ? !g_strcmp0 (name, watched) :
+            g_strv_contains ((const gchar * const *) view->keys, name))
+      om_sorted_view_update (view, object);
+  }
+}
+
+/* TRUE if the objects are watched for property changes */
+static inline gboolean
+wp_object_manager_watches_objects (WpObjectManager * self)
+{
+  return self->indexes->len > 0 || self->views->len > 0;
+}
+
+static void
+wp_object_manager_index_object (WpObjectManager * self, GObject * object)
+{
+  if (!wp_object_manager_watches_objects (self))
+    return;
+
+  for (guint i = 0; i < self->indexes->len; i++)
+    om_index_insert (g_ptr_array_index (self->indexes, i), object);
+  for (guint i = 0; i < self->views->len; i++)
+    om_sorted_view_insert (g_ptr_array_index (self->views, i), object);
+
+  /* keep the indexes and the views in sync with property changes */
+  g_signal_connect (object, "notify",
+      G_CALLBACK (on_indexed_object_notify), self);
+}
+
+static void
+wp_object_manager_unindex_object (WpObjectManager * self, GObject * object)
+{
+  if (!wp_object_manager_watches_objects (self))
+    return;
+
+  g_signal_handlers_disconnect_by_func (object,
+      on_indexed_object_notify, self);
+
+  for (guint i = 0; i < self->indexes->len; i++)
+    om_index_remove (g_ptr_array_index (self->indexes, i), object);
+  for (guint i = 0; i < self->views->len; i++)
+    om_sorted_view_remove (g_ptr_array_index (self->views, i), object);
+}
+
 static void
 wp_object_manager_init (WpObjectManager * self)
 {
@@ -171,9 +703,18 @@ wp_object_manager_init (WpObjectManager * self)
       (GDestroyNotify) wp_object_interest_unref);
   self->features = g_hash_table_new (g_direct_hash, g_direct_equal);
   self->objects = g_ptr_array_new ();
+  self->positions = g_hash_table_new (g_direct_hash, g_direct_equal);
+  self->indexes = g_ptr_array_new_with_free_func (
+      (GDestroyNotify) om_index_free);
+  self->views = g_ptr_array_new_with_free_func (
+      (GDestroyNotify) om_sorted_view_unref);
+  self->batch_added = g_ptr_array_new_with_free_func (g_object_unref);
+  self->batch_removed = g_ptr_array_new_with_free_func (g_object_unref);
+  self->batch_positions = g_hash_table_new (g_direct_hash, g_direct_equal);
+  self->followers = g_ptr_array_new ();
   self->installed = FALSE;
   self->changed = FALSE;
-  self->pending_objects = 0;
+  self->pending = g_ptr_array_new ();
 }
 
 static void
@@ -185,6 +726,24 @@ wp_object_manager_finalize (GObject * object)
     g_source_destroy (self->idle_source);
     g_clear_pointer (&self->idle_source, g_source_unref);
   }
+  if (self->leader) {
+    g_ptr_array_remove_fast (self->leader->followers, self);
+    g_clear_object (&self->leader);
+  }
+  for (guint i = 0; i < self->objects->len; i++) {
+    gpointer object = g_ptr_array_index (self->objects, i);
+    wp_object_manager_unindex_object (self, object);
+    object_remove_managing_om (object, self);
+  }
+  g_clear_pointer (&self->indexes, g_ptr_array_unref);
+  g_clear_pointer (&self->views, g_ptr_array_unref);
+  g_clear_pointer (&self->batch_added, g_ptr_array_unref);
+  g_clear_pointer (&self->batch_removed, g_ptr_array_unref);
+  g_clear_pointer (&self->batch_positions, g_hash_table_unref);
+  g_clear_pointer (&self->followers, g_ptr_array_unref);
+  g_clear_pointer (&self->share_key, g_free);
+  g_clear_pointer (&self->pending, g_ptr_array_unref);
+  g_clear_pointer (&self->positions, g_hash_table_unref);
   g_clear_pointer (&self->objects, g_ptr_array_unref);
   g_clear_pointer (&self->features, g_hash_table_unref);
   g_clear_pointer (&self->interests, g_ptr_array_unref);
@@ -231,6 +790,14 @@ wp_object_manager_class_init (WpObjectManagerClass * klass)
       "object-removed", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_FIRST,
       0, NULL, NULL, NULL, G_TYPE_NONE, 1, G_TYPE_OBJECT);
 
+  signals[SIGNAL_OBJECTS_ADDED] = g_signal_new (
+      "objects-added", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_FIRST,
+      0, NULL, NULL, NULL, G_TYPE_NONE, 1, G_TYPE_PTR_ARRAY);
+
+  signals[SIGNAL_OBJECTS_REMOVED] = g_signal_new (
+      "objects-removed", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_FIRST,
+      0, NULL, NULL, NULL, G_TYPE_NONE, 1, G_TYPE_PTR_ARRAY);
+
   signals[SIGNAL_OBJECTS_CHANGED] = g_signal_new (
       "objects-changed", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_FIRST,
       0, NULL, NULL, NULL, G_TYPE_NONE, 0);
@@ -265,6 +832,76 @@ wp_object_manager_is_installed (WpObjectManager * self)
   return self->installed;
 }
 
+/*!
+ * \brief Puts the object manager in passive mode
+ *
+ * In passive mode, the object manager does not bind the PipeWire globals
+ * that it is interested in. They are exposed as soon as they appear on the
+ * registry, as WpGlobalProxy objects that have no active features, which only
+ * gives access to their global id, type, permissions and global properties.
+ * Any features requested with wp_object_manager_request_object_features()
+ * are ignored. If more is needed for a particular object, it can be upgraded
+ * on demand by activating the wanted features on it with
+ * wp_object_activate().
+ *
+ * Because pipewire objects are not bound, constraints of type
+ * WP_CONSTRAINT_TYPE_PW_PROPERTY are evaluated as if the object had no
+ * properties and will normally not match; use
+ * WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY instead.
+ *
+ * This is meant for consumers that only need to monitor what is on the
+ * registry. Non-pipewire objects (session items, plugins, ...) are not
+ * affected.
+ *
+ * This must be called before installing the object manager.
+ *
+ * \ingroup wpobjectmanager
+ * \param self the object manager
+ * \param passive TRUE to enable passive mode
+ */
+void
+wp_object_manager_set_passive (WpObjectManager * self, gboolean passive)
+{
+  g_autoptr (WpCore) core = NULL;
+
+  g_return_if_fail (WP_IS_OBJECT_MANAGER (self));
+
+  core = g_weak_ref_get (&self->core);
+  g_return_if_fail (core == NULL);
+
+  self->passive = passive;
+}
+
+/*!
+ * \brief Checks if the object manager is in passive mode
+ * \ingroup wpobjectmanager
+ * \param self the object manager
+ * \returns TRUE if passive mode is enabled, see
+ *   wp_object_manager_set_passive()
+ */
+gboolean
+wp_object_manager_is_passive (WpObjectManager * self)
+{
+  g_return_val_if_fail (WP_IS_OBJECT_MANAGER (self), FALSE);
+  return self->passive;
+}
+
+/* validates \a interest, dropping it if it is not valid;
+   failures are logged on \a object */
+static gboolean
+om_interest_validate (gpointer object, WpObjectInterest * interest)
+{
+  g_autoptr (GError) error = NULL;
+
+  if (G_UNLIKELY (!wp_object_interest_validate (interest, &error))) {
+    wp_critical_object (object, "interest validation failed: %s",
+        error->message);
+    wp_object_interest_unref (interest);
+    return FALSE;
+  }
+  return TRUE;
+}
+
 /*!
  * \brief Equivalent to:
  * \code
@@ -301,6 +938,10 @@ wp_object_manager_add_interest (WpObjectManager * self, GType gtype, ...)
  * (g_type_is_a() must match) and optionally, a set of additional constraints
  * on certain properties of the object. Refer to WpObjectInterest for more details.
  *
+ * If the object manager is already installed, the new interest applies to
+ * the objects that appear from then on; the objects that are already
+ * managed are not affected.
+ *
  * \ingroup wpobjectmanager
  * \param self the object manager
  * \param interest (transfer full): the interest
@@ -309,17 +950,12 @@ void
 wp_object_manager_add_interest_full (WpObjectManager *self,
     WpObjectInterest * interest)
 {
-  g_autoptr (GError) error = NULL;
-
   g_return_if_fail (WP_IS_OBJECT_MANAGER (self));
 
-  if (G_UNLIKELY (!wp_object_interest_validate (interest, &error))) {
-    wp_critical_object (self, "interest validation failed: %s",
-        error->message);
-    wp_object_interest_unref (interest);
+  if (!om_interest_validate (self, interest))
     return;
-  }
   g_ptr_array_add (self->interests, interest);
+  wp_object_manager_interests_changed (self);
 }
 
 static void
@@ -346,7 +982,8 @@ store_children_object_features (GHashTable *store, GType object_type,
  * \a object_type.
  *
  * These features will always be prepared before the object appears on the
- * object manager.
+ * object manager. If the object manager is already installed, they are
+ * prepared on the objects that appear from then on.
  *
  * \ingroup wpobjectmanager
  * \param self the object manager
@@ -363,40 +1000,293 @@ wp_object_manager_request_object_features (WpObjectManager *self,
   g_hash_table_insert (self->features, GSIZE_TO_POINTER (object_type),
       GUINT_TO_POINTER (wanted_features));
   store_children_object_features (self->features, object_type, wanted_features);
+  wp_object_manager_interests_changed (self);
+}
+
+static struct om_index *
+wp_object_manager_find_index (WpObjectManager * self, WpConstraintType type,
+    const gchar * key)
+{
+  for (guint i = 0; i < self->indexes->len; i++) {
+    struct om_index *idx = g_ptr_array_index (self->indexes, i);
+    if (idx->type == type && !g_strcmp0 (idx->key, key))
+      return idx;
+  }
+  return NULL;
 }
 
 /*!
- * \brief Gets the number of objects managed by the object manager.
+ * \brief Requests the object manager to maintain a hash index of its objects
+ * on the value of the \a key property.
+ *
+ * Lookups and filtered iterators whose interest contains a
+ * WP_CONSTRAINT_VERB_EQUALS constraint of the same \a type on \a key,
+ * with a string or integer value, will use this index to find candidate
+ * objects directly, instead of checking the interest against every object
+ * that this object manager holds. The result is the same in both cases.
+ *
+ * This is useful when the same object manager is queried repeatedly for
+ * objects with a specific id or name, ex. "node.id" or "object.serial".
+ *
  * \ingroup wpobjectmanager
  * \param self the object manager
- * \returns the number of objects managed by this WpObjectManager
+ * \param type the type of the property to index
+ * \param key the name of the property to index
  */
-guint
-wp_object_manager_get_n_objects (WpObjectManager * self)
+void
+wp_object_manager_add_index (WpObjectManager * self, WpConstraintType type,
+    const gchar * key)
 {
-  g_return_val_if_fail (WP_IS_OBJECT_MANAGER (self), 0);
-  return self->objects->len;
-}
+  struct om_index *idx;
+  gboolean watching;
 
-struct om_iterator_data
-{
-  WpObjectManager *om;
-  GPtrArray *objects;
-  WpObjectInterest *interest;
-  guint index;
-};
+  g_return_if_fail (WP_IS_OBJECT_MANAGER (self));
+  g_return_if_fail (type > WP_CONSTRAINT_TYPE_NONE &&
+      type <= WP_CONSTRAINT_TYPE_G_PROPERTY);
+  g_return_if_fail (key != NULL);
 
-static void
-om_iterator_reset (WpIterator *it)
-{
-  struct om_iterator_data *it_data = wp_iterator_get_user_data (it);
-  it_data->index = 0;
+  /* the index is maintained on the shared set; self only records it */
+  if (self->leader)
+    wp_object_manager_add_index (self->leader, type, key);
+
+  if (wp_object_manager_find_index (self, type, key))
+    return;
+
+  watching = wp_object_manager_watches_objects (self);
+  idx = om_index_new (type, key);
+  g_ptr_array_add (self->indexes, idx);
+
+  /* index objects that are already managed */
+  for (guint i = 0; i < self->objects->len; i++) {
+    GObject *object = g_ptr_array_index (self->objects, i);
+    om_index_insert (idx, object);
+    if (!watching)
+      g_signal_connect (object, "notify",
+          G_CALLBACK (on_indexed_object_notify), self);
+  }
 }
 
-static gboolean
-om_iterator_next (WpIterator *it, GValue *item)
+static struct om_sorted_view *
+wp_object_manager_find_sorted_view (WpObjectManager * self,
+    WpConstraintType type, const gchar * const * keys,
+    WpSortedViewFlags flags)
 {
-  struct om_iterator_data *it_data = wp_iterator_get_user_data (it);
+  for (guint i = 0; i < self->views->len; i++) {
+    struct om_sorted_view *view = g_ptr_array_index (self->views, i);
+    if (view->type == type && view->flags == flags &&
+        g_strv_equal ((const gchar * const *) view->keys, keys))
+      return view;
+  }
+  return NULL;
+}
+
+/*!
+ * \brief Requests the object manager to keep its objects sorted on the
+ * numeric values of the \a keys properties.
+ *
+ * Objects are sorted in descending order of the value of the first key,
+ * then of the second key and so on; objects that do not have one of the
+ * keys, or that have a non-numeric value on it, are sorted as if the value
+ * was 0. Values are parsed like Lua's tonumber() does, so they may also be
+ * fractional or use an exponent, unless \a flags has
+ * WP_SORTED_VIEW_FLAG_INTEGER, in which case they are parsed like atoi()
+ * does, for code that scores the objects with atoi(). The order is
+ * maintained as objects are
+ * added, removed or change their properties, so that
+ * wp_object_manager_new_sorted_iterator() can return the objects with the
+ * highest values first without checking all the other ones.
+ *
+ * This is useful for finding the best candidate among many objects,
+ * ex. the node with the highest "priority.session".
+ *
+ * \ingroup wpobjectmanager
+ * \param self the object manager
+ * \param type the type of the properties to sort on
+ * \param keys (array zero-terminated=1): the names of the properties
+ *   to sort on, in order of significance
+ * \param flags how to parse the values of the properties
+ */
+void
+wp_object_manager_add_sorted_view (WpObjectManager * self,
+    WpConstraintType type, const gchar * const * keys,
+    WpSortedViewFlags flags)
+{
+  struct om_sorted_view *view;
+  gboolean watching;
+
+  g_return_if_fail (WP_IS_OBJECT_MANAGER (self));
+  g_return_if_fail (type > WP_CONSTRAINT_TYPE_NONE &&
+      type <= WP_CONSTRAINT_TYPE_G_PROPERTY);
+  g_return_if_fail (keys != NULL && keys[0] != NULL);
+
+  /* the view is maintained on the shared set; self only records it */
+  if (self->leader)
+    wp_object_manager_add_sorted_view (self->leader, type, keys, flags);
+
+  if (wp_object_manager_find_sorted_view (self, type, keys, flags))
+    return;
+
+  watching = wp_object_manager_watches_objects (self);
+  view = om_sorted_view_new (type, keys, flags);
+  g_ptr_array_add (self->views, view);
+
+  /* sort objects that are already managed */
+  for (guint i = 0; i < self->objects->len; i++) {
+    GObject *object = g_ptr_array_index (self->objects, i);
+    om_sorted_view_insert (view, object);
+    if (!watching)
+      g_signal_connect (object, "notify",
+          G_CALLBACK (on_indexed_object_notify), self);
+  }
+}
+
+/*
+ * Finds the objects that may match \a interest by looking at the indexes.
+ * \returns TRUE if an index was usable, in which case \a candidates is set
+ *   to the index bucket (transfer none), or NULL if no object can match
+ */
+static gboolean
+wp_object_manager_lookup_index (WpObjectManager * self,
+    WpObjectInterest * interest, GPtrArray ** candidates)
+{
+  for (guint i = 0; i < self->indexes->len; i++) {
+    struct om_index *idx = g_ptr_array_index (self->indexes, i);
+    GVariant *value = wp_object_interest_find_equals_value (interest,
+        idx->type, idx->key);
+    g_autofree gchar *str = value ? om_index_variant_to_value (value) : NULL;
+
+    if (str) {
+      *candidates = g_hash_table_lookup (idx->buckets, str);
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+/*!
+ * \brief Gets the number of objects managed by the object manager.
+ * \ingroup wpobjectmanager
+ * \param self the object manager
+ * \returns the number of objects managed by this WpObjectManager
+ */
+guint
+wp_object_manager_get_n_objects (WpObjectManager * self)
+{
+  g_return_val_if_fail (WP_IS_OBJECT_MANAGER (self), 0);
+  return wp_object_manager_get_storage (self)->objects->len;
+}
+
+/*!
+ * \brief Gets the objects that were added to and removed from this object
+ * manager since the previous emission of \c objects-changed
+ *
+ * This is only valid while \c objects-changed (or one of \c objects-added,
+ * \c objects-removed) is being emitted. Changes are tracked only while there
+ * is a handler connected to one of these signals, so a handler that was
+ * connected in the middle of a burst of changes may only see part of them.
+ *
+ * \ingroup wpobjectmanager
+ * \param self the object manager
+ * \param added (out) (optional) (transfer none) (element-type GObject):
+ *   the objects that were added and are still managed
+ * \param removed (out) (optional) (transfer none) (element-type GObject):
+ *   the objects that were removed; these are still alive, but may have
+ *   already been destroyed on the PipeWire side
+ * \returns TRUE if this was called during the emission of one of the
+ *   signals above, FALSE otherwise, in which case \a added and \a removed
+ *   are set to NULL
+ */
+gboolean
+wp_object_manager_get_pending_changes (WpObjectManager * self,
+    GPtrArray ** added, GPtrArray ** removed)
+{
+  g_return_val_if_fail (WP_IS_OBJECT_MANAGER (self), FALSE);
+
+  if (added)
+    *added = self->emitting_added;
+  if (removed)
+    *removed = self->emitting_removed;
+  return self->emitting_added != NULL;
+}
+
+/* lets go of the \a objects array of an object manager, which \a readers
+   iterators may still be walking; the object manager does not own
+   references on its objects, which may be destroyed as soon as they are
+   removed, so the iterators get their own */
+static void
+wp_object_manager_objects_release (GPtrArray * objects, guint readers)
+{
+  if (readers > 0) {
+    g_ptr_array_foreach (objects, (GFunc) g_object_ref, NULL);
+    g_ptr_array_set_free_func (objects, g_object_unref);
+  }
+  g_ptr_array_unref (objects);
+}
+
+/* must be called before modifying self->objects */
+static void
+wp_object_manager_objects_prepare_write (WpObjectManager * self)
+{
+  if (self->objects_readers > 0) {
+    GPtrArray *objects = g_ptr_array_copy (self->objects, NULL, NULL);
+    wp_object_manager_objects_release (self->objects, self->objects_readers);
+    self->objects = objects;
+    self->objects_readers = 0;
+    self->objects_gen++;
+  }
+}
+
+struct om_iterator_data
+{
+  WpObjectManager *om;
+  GPtrArray *objects;
+  WpObjectInterest *interest;
+  guint index;
+  /* TRUE if 'objects' is the om's live storage at generation 'gen' */
+  gboolean live;
+  guint gen;
+};
+
+static void
+om_iterator_acquire (struct om_iterator_data *it_data)
+{
+  WpObjectManager *self = it_data->om;
+
+  it_data->objects = g_ptr_array_ref (self->objects);
+  it_data->live = TRUE;
+  it_data->gen = self->objects_gen;
+  self->objects_readers++;
+}
+
+static void
+om_iterator_release (struct om_iterator_data *it_data)
+{
+  if (!it_data->live)
+    return;
+
+  /* if the generation moved on, the om has already forgotten about us */
+  if (it_data->gen == it_data->om->objects_gen)
+    it_data->om->objects_readers--;
+  it_data->live = FALSE;
+  g_clear_pointer (&it_data->objects, g_ptr_array_unref);
+}
+
+static void
+om_iterator_reset (WpIterator *it)
+{
+  struct om_iterator_data *it_data = wp_iterator_get_user_data (it);
+  it_data->index = 0;
+  if (!it_data->objects)
+    om_iterator_acquire (it_data);
+}
+
+static gboolean
+om_iterator_next (WpIterator *it, GValue *item)
+{
+  struct om_iterator_data *it_data = wp_iterator_get_user_data (it);
+
+  if (!it_data->objects)
+    return FALSE;
 
   while (it_data->index < it_data->objects->len) {
     gpointer obj = g_ptr_array_index (it_data->objects, it_data->index++);
@@ -408,6 +1298,9 @@ om_iterator_next (WpIterator *it, GValue *item)
       return TRUE;
     }
   }
+
+  /* done; stop holding back modifications of the om */
+  om_iterator_release (it_data);
   return FALSE;
 }
 
@@ -419,6 +1312,9 @@ om_iterator_fold (WpIterator *it, WpIteratorFoldFunc func, GValue *ret,
   gpointer *obj, *base;
   guint len;
 
+  if (!it_data->objects)
+    return TRUE;
+
   obj = base = it_data->objects->pdata;
   len = it_data->objects->len;
 
@@ -433,6 +1329,8 @@ om_iterator_fold (WpIterator *it, WpIteratorFoldFunc func, GValue *ret,
     }
     obj++;
   }
+
+  om_iterator_release (it_data);
   return TRUE;
 }
 
@@ -440,9 +1338,10 @@ static void
 om_iterator_finalize (WpIterator *it)
 {
   struct om_iterator_data *it_data = wp_iterator_get_user_data (it);
+  om_iterator_release (it_data);
   g_clear_pointer (&it_data->objects, g_ptr_array_unref);
   g_clear_pointer (&it_data->interest, wp_object_interest_unref);
-  g_object_unref (it_data->om);
+  g_clear_object (&it_data->om);
 }
 
 static const WpIteratorMethods om_iterator_methods = {
@@ -453,6 +1352,32 @@ static const WpIteratorMethods om_iterator_methods = {
   .finalize = om_iterator_finalize,
 };
 
+/*
+ * \param om (nullable): the object manager that holds the objects
+ * \param objects (transfer full) (nullable): the objects to iterate through,
+ *   or NULL to walk the objects of \a om in place
+ * \param interest (transfer full) (nullable): a valid interest that the
+ *   returned objects must match
+ */
+static WpIterator *
+om_iterator_new (WpObjectManager * om, GPtrArray * objects,
+    WpObjectInterest * interest)
+{
+  WpIterator *it;
+  struct om_iterator_data *it_data;
+
+  it = wp_iterator_new (&om_iterator_methods, sizeof (struct om_iterator_data));
+  it_data = wp_iterator_get_user_data (it);
+  it_data->om = om ? g_object_ref (om) : NULL;
+  if (objects)
+    it_data->objects = objects;
+  else
+    om_iterator_acquire (it_data);
+  it_data->interest = interest;
+  it_data->index = 0;
+  return it;
+}
+
 /*!
  * \brief Iterates through all the objects managed by this object manager.
  * \ingroup wpobjectmanager
@@ -463,17 +1388,9 @@ static const WpIteratorMethods om_iterator_methods = {
 WpIterator *
 wp_object_manager_new_iterator (WpObjectManager * self)
 {
-  WpIterator *it;
-  struct om_iterator_data *it_data;
-
   g_return_val_if_fail (WP_IS_OBJECT_MANAGER (self), NULL);
 
-  it = wp_iterator_new (&om_iterator_methods, sizeof (struct om_iterator_data));
-  it_data = wp_iterator_get_user_data (it);
-  it_data->om = g_object_ref (self);
-  it_data->objects = g_ptr_array_copy (self->objects, NULL, NULL);
-  it_data->index = 0;
-  return it;
+  return om_iterator_new (wp_object_manager_get_storage (self), NULL, NULL);
 }
 
 /*!
@@ -523,26 +1440,22 @@ WpIterator *
 wp_object_manager_new_filtered_iterator_full (WpObjectManager * self,
     WpObjectInterest * interest)
 {
-  WpIterator *it;
-  struct om_iterator_data *it_data;
-  g_autoptr (GError) error = NULL;
+  WpObjectManager *storage;
+  GPtrArray *candidates = NULL;
 
   g_return_val_if_fail (WP_IS_OBJECT_MANAGER (self), NULL);
 
-  if (G_UNLIKELY (!wp_object_interest_validate (interest, &error))) {
-    wp_critical_object (self, "interest validation failed: %s",
-        error->message);
-    wp_object_interest_unref (interest);
+  if (!om_interest_validate (self, interest))
     return NULL;
-  }
 
-  it = wp_iterator_new (&om_iterator_methods, sizeof (struct om_iterator_data));
-  it_data = wp_iterator_get_user_data (it);
-  it_data->om = g_object_ref (self);
-  it_data->objects = g_ptr_array_copy (self->objects, NULL, NULL);
-  it_data->interest = interest;
-  it_data->index = 0;
-  return it;
+  /* index buckets are small by construction, so those are still copied;
+     the full set of objects is walked in place */
+  storage = wp_object_manager_get_storage (self);
+  if (!wp_object_manager_lookup_index (storage, interest, &candidates))
+    return om_iterator_new (storage, NULL, interest);
+  return om_iterator_new (storage, candidates ?
+      g_ptr_array_copy (candidates, NULL, NULL) : g_ptr_array_new (),
+      interest);
 }
 
 /*!
@@ -605,19 +1518,259 @@ wp_object_manager_lookup_full (WpObjectManager * self,
   return NULL;
 }
 
+struct om_sorted_iterator_data
+{
+  WpObjectManager *om;
+  struct om_sorted_view *view;
+  WpObjectInterest *interest;
+  /* the next entry to look at, valid while the view is at generation 'gen' */
+  GSequenceIter *pos;
+  guint gen;
+  /* a search key for the position right after the last returned object,
+     to resume from there if the view changes in the meantime */
+  struct om_sorted_entry *resume;
+  gboolean started;
+};
+
+static void
+om_sorted_iterator_reset (WpIterator *it)
+{
+  struct om_sorted_iterator_data *it_data = wp_iterator_get_user_data (it);
+  it_data->pos = g_sequence_get_begin_iter (it_data->view->entries);
+  it_data->gen = it_data->view->gen;
+  it_data->started = FALSE;
+}
+
+static gboolean
+om_sorted_iterator_next (WpIterator *it, GValue *item)
+{
+  struct om_sorted_iterator_data *it_data = wp_iterator_get_user_data (it);
+  struct om_sorted_view *view = it_data->view;
+
+  if (it_data->gen != view->gen) {
+    it_data->pos = it_data->started ?
+        g_sequence_search (view->entries, it_data->resume,
+            om_sorted_entry_compare, view) :
+        g_sequence_get_begin_iter (view->entries);
+    it_data->gen = view->gen;
+  }
+
+  while (!g_sequence_iter_is_end (it_data->pos)) {
+    struct om_sorted_entry *entry = g_sequence_get (it_data->pos);
+    it_data->pos = g_sequence_iter_next (it_data->pos);
+
+    /* take the next object that matches the interest, if any */
+    if (!it_data->interest ||
+        wp_object_interest_matches (it_data->interest, entry->object)) {
+      memcpy (it_data->resume->values, entry->values,
+          view->n_keys * sizeof (gdouble));
+      it_data->resume->serial = entry->serial + 1;
+      it_data->started = TRUE;
+      g_value_init_from_instance (item, entry->object);
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+static void
+om_sorted_iterator_finalize (WpIterator *it)
+{
+  struct om_sorted_iterator_data *it_data = wp_iterator_get_user_data (it);
+  g_clear_pointer (&it_data->resume, g_free);
+  g_clear_pointer (&it_data->interest, wp_object_interest_unref);
+  g_clear_pointer (&it_data->view, om_sorted_view_unref);
+  g_object_unref (it_data->om);
+}
+
+static const WpIteratorMethods om_sorted_iterator_methods = {
+  .version = WP_ITERATOR_METHODS_VERSION,
+  .reset = om_sorted_iterator_reset,
+  .next = om_sorted_iterator_next,
+  .finalize = om_sorted_iterator_finalize,
+};
+
+/*!
+ * \brief Iterates through the objects managed by this object manager that
+ * match the specified \a interest, in the order of a sorted view.
+ *
+ * The view is the one of wp_object_manager_add_sorted_view() with the same
+ * \a type, \a keys and \a flags; it is added first if it does not exist. Note that
+ * a view that is added this way is permanent, like any other: it is kept up
+ * to date for as long as the object manager exists, even after the iterator
+ * is gone, so it is best to add the views with
+ * wp_object_manager_add_sorted_view() before installing the object manager
+ * and to only iterate on these. Objects are
+ * returned starting from the ones with the highest values, so the first
+ * object returned is the best match and the iteration can stop as soon
+ * as an acceptable object is found.
+ *
+ * The object manager may be modified during the iteration; the iteration
+ * then continues after the last returned object in the updated order.
+ *
+ * \ingroup wpobjectmanager
+ * \param self the object manager
+ * \param type the type of the properties to sort on
+ * \param keys (array zero-terminated=1): the names of the properties
+ *   to sort on, in order of significance
+ * \param flags how to parse the values of the properties
+ * \param interest (transfer full)(nullable): the interest, or NULL to
+ *   iterate through all the objects
+ * \returns (transfer full): a WpIterator that iterates over all the matching
+ *   objects of this object manager, in descending order
+ */
+WpIterator *
+wp_object_manager_new_sorted_iterator (WpObjectManager * self,
+    WpConstraintType type, const gchar * const * keys,
+    WpSortedViewFlags flags, WpObjectInterest * interest)
+{
+  WpIterator *it;
+  struct om_sorted_iterator_data *it_data;
+  WpObjectManager *storage;
+  struct om_sorted_view *view;
+
+  g_return_val_if_fail (WP_IS_OBJECT_MANAGER (self), NULL);
+  g_return_val_if_fail (keys != NULL && keys[0] != NULL, NULL);
+
+  if (interest && !om_interest_validate (self, interest))
+    return NULL;
+
+  storage = wp_object_manager_get_storage (self);
+  wp_object_manager_add_sorted_view (storage, type, keys, flags);
+  view = wp_object_manager_find_sorted_view (storage, type, keys, flags);
+  g_return_val_if_fail (view, NULL);
+
+  it = wp_iterator_new (&om_sorted_iterator_methods,
+      sizeof (struct om_sorted_iterator_data));
+  it_data = wp_iterator_get_user_data (it);
+  it_data->om = g_object_ref (storage);
+  it_data->view = om_sorted_view_ref (view);
+  it_data->interest = interest;
+  it_data->resume = g_malloc0 (sizeof (struct om_sorted_entry) +
+      view->n_keys * sizeof (gdouble));
+  om_sorted_iterator_reset (it);
+  return it;
+}
+
+/*!
+ * \brief Gets the statistics of the objects that \a self has evaluated
+ *
+ * Object managers that share their objects (see
+ * wp_core_install_object_manager()) also share their statistics.
+ *
+ * \ingroup wpobjectmanager
+ * \param self the object manager
+ * \param stats (out caller-allocates): the location to store the statistics
+ */
+void
+wp_object_manager_get_stats (WpObjectManager * self,
+    WpObjectManagerStats * stats)
+{
+  WpObjectManager *storage;
+
+  g_return_if_fail (WP_IS_OBJECT_MANAGER (self));
+  g_return_if_fail (stats != NULL);
+
+  storage = wp_object_manager_get_storage (self);
+  stats->n_evaluations = storage->n_evaluations;
+  stats->n_matches = storage->n_matches;
+  stats->time_ns = storage->time_ns;
+}
+
+static void
+wp_object_manager_append_stats (WpObjectManager * self, GString * str)
+{
+  g_string_append_printf (str, WP_OBJECT_FORMAT ": %u objects, %u followers, "
+      "%" G_GUINT64_FORMAT " evaluations, %" G_GUINT64_FORMAT " matches, %"
+      G_GUINT64_FORMAT " us\n", WP_OBJECT_ARGS (self), self->objects->len,
+      self->followers->len, self->n_evaluations, self->n_matches,
+      self->time_ns / 1000);
+
+  for (guint i = 0; i < self->interests->len; i++)
+    wp_object_interest_append_stats (g_ptr_array_index (self->interests, i),
+        str, "  ");
+}
+
+/*!
+ * \brief Describes the statistics of \a self and of each of its interests,
+ * in a human readable form
+ *
+ * For every interest, this includes how many times each constraint was the
+ * first one to reject an object (see wp_object_interest_get_stats()).
+ *
+ * \ingroup wpobjectmanager
+ * \param self the object manager
+ * \returns (transfer full): the statistics, on multiple lines
+ */
+gchar *
+wp_object_manager_dump_stats (WpObjectManager * self)
+{
+  GString *str;
+
+  g_return_val_if_fail (WP_IS_OBJECT_MANAGER (self), NULL);
+
+  str = g_string_new (NULL);
+  wp_object_manager_append_stats (wp_object_manager_get_storage (self), str);
+  return g_string_free (str, FALSE);
+}
+
+/* cheap pre-check: can an object of this type match any of our interests? */
+static gboolean
+wp_object_manager_is_interested_in_type (WpObjectManager * self, GType type)
+{
+  for (guint i = 0; i < self->interests->len; i++) {
+    WpObjectInterest *interest = g_ptr_array_index (self->interests, i);
+    if (g_type_is_a (type, wp_object_interest_get_gtype (interest)))
+      return TRUE;
+  }
+  return FALSE;
+}
+
+static inline guint64
+get_monotonic_time_ns (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return SPA_TIMESPEC_TO_NSEC (&ts);
+}
+
+/* accounts the time since \a *since on \a interest and moves \a *since;
+   this is a no-op unless timing was enabled on the registry */
+static inline void
+wp_object_manager_account_time (WpObjectManager * self,
+    WpObjectInterest * interest, guint64 * since)
+{
+  guint64 now;
+
+  if (!self->timing)
+    return;
+
+  now = get_monotonic_time_ns ();
+  wp_object_interest_add_time (interest, now - *since);
+  self->time_ns += now - *since;
+  *since = now;
+}
+
 static gboolean
 wp_object_manager_is_interested_in_object (WpObjectManager * self,
     GObject * object)
 {
   guint i;
   WpObjectInterest *interest = NULL;
+  guint64 time = self->timing ? get_monotonic_time_ns () : 0;
+  gboolean matches = FALSE;
 
-  for (i = 0; i < self->interests->len; i++) {
+  self->n_evaluations++;
+
+  for (i = 0; i < self->interests->len && !matches; i++) {
     interest = g_ptr_array_index (self->interests, i);
-    if (wp_object_interest_matches (interest, object))
-      return TRUE;
+    matches = wp_object_interest_matches (interest, object);
+    wp_object_manager_account_time (self, interest, &time);
   }
-  return FALSE;
+
+  if (matches)
+    self->n_matches++;
+  return matches;
 }
 
 static gboolean
@@ -626,6 +1779,9 @@ wp_object_manager_is_interested_in_global (WpObjectManager * self,
 {
   guint i;
   WpObjectInterest *interest = NULL;
+  guint64 time = self->timing ? get_monotonic_time_ns () : 0;
+
+  self->n_evaluations++;
 
   for (i = 0; i < self->interests->len; i++) {
     interest = g_ptr_array_index (self->interests, i);
@@ -634,6 +1790,7 @@ wp_object_manager_is_interested_in_global (WpObjectManager * self,
     WpInterestMatch match = wp_object_interest_matches_full (interest,
         WP_INTEREST_MATCH_FLAGS_CHECK_ALL, global->type, global->proxy,
         NULL, global->properties);
+    wp_object_manager_account_time (self, interest, &time);
 
     /* and consider the manager interested if the type and the globals match...
        if pw_properties / g_properties fail, that's ok because they are not
@@ -650,36 +1807,104 @@ wp_object_manager_is_interested_in_global (WpObjectManager * self,
             g_type_is_a (global->type, WP_TYPE_PIPEWIRE_OBJECT))
         *wanted_features |= WP_PIPEWIRE_OBJECT_FEATURE_INFO;
 
+      self->n_matches++;
       return TRUE;
     }
   }
   return FALSE;
 }
 
-static gboolean
-idle_emit_objects_changed (WpObjectManager * self)
+typedef void (*WpObjectManagerFollowerFunc) (WpObjectManager *, gpointer);
+
+static void
+wp_object_manager_foreach_follower (WpObjectManager * self,
+    WpObjectManagerFollowerFunc func, gpointer data)
 {
-  g_clear_pointer (&self->idle_source, g_source_unref);
+  g_autoptr (GPtrArray) followers = NULL;
 
-  if (G_UNLIKELY (!self->installed)) {
-    wp_trace_object (self, "installed");
-    g_signal_emit (self, signals[SIGNAL_INSTALLED], 0);
-    self->installed = TRUE;
-  }
-  wp_trace_object (self, "emit objects-changed");
-  g_signal_emit (self, signals[SIGNAL_OBJECTS_CHANGED], 0);
+  if (self->followers->len == 0)
+    return;
 
-  return G_SOURCE_REMOVE;
+  /* signal handlers may well destroy followers */
+  followers = g_ptr_array_copy (self->followers, (GCopyFunc) g_object_ref,
+      NULL);
+  g_ptr_array_set_free_func (followers, g_object_unref);
+  for (guint i = 0; i < followers->len; i++)
+    func (g_ptr_array_index (followers, i), data);
 }
 
+static void wp_object_manager_maybe_objects_changed (WpObjectManager * self);
+static gboolean wp_registry_is_exposing_to (WpRegistry * self,
+    WpObjectManager * om);
+
 static void
-wp_object_manager_maybe_objects_changed (WpObjectManager * self)
+follower_maybe_objects_changed (WpObjectManager * self, gpointer data)
 {
-  wp_trace_object (self, "pending:%u changed:%d idle_source:%p installed:%d",
-      self->pending_objects, self->changed, self->idle_source, self->installed);
+  wp_object_manager_maybe_objects_changed (self);
+}
 
-  /* always wait until there are no pending objects */
-  if (self->pending_objects > 0)
+/* changes are only tracked while somebody is listening for them */
+static gboolean
+wp_object_manager_wants_changes (WpObjectManager * self, guint batch_signal)
+{
+  return g_signal_has_handler_pending (self, signals[batch_signal], 0, FALSE)
+      || g_signal_has_handler_pending (self,
+          signals[SIGNAL_OBJECTS_CHANGED], 0, FALSE);
+}
+
+static gboolean
+idle_emit_objects_changed (WpObjectManager * self)
+{
+  g_clear_pointer (&self->idle_source, g_source_unref);
+
+  g_autoptr (GPtrArray) added = g_steal_pointer (&self->batch_added);
+  g_autoptr (GPtrArray) removed = g_steal_pointer (&self->batch_removed);
+
+  /* changes that happen from now on are reported on the next emission */
+  self->batch_added = g_ptr_array_new_with_free_func (g_object_unref);
+  self->batch_removed = g_ptr_array_new_with_free_func (g_object_unref);
+  g_hash_table_remove_all (self->batch_positions);
+  self->emitting_added = added;
+  self->emitting_removed = removed;
+
+  if (removed->len > 0) {
+    wp_trace_object (self, "emit objects-removed (%u)", removed->len);
+    g_signal_emit (self, signals[SIGNAL_OBJECTS_REMOVED], 0, removed);
+  }
+  if (added->len > 0) {
+    wp_trace_object (self, "emit objects-added (%u)", added->len);
+    g_signal_emit (self, signals[SIGNAL_OBJECTS_ADDED], 0, added);
+  }
+
+  if (G_UNLIKELY (!self->installed)) {
+    wp_trace_object (self, "installed");
+    g_signal_emit (self, signals[SIGNAL_INSTALLED], 0);
+    self->installed = TRUE;
+  }
+  wp_trace_object (self, "emit objects-changed");
+  g_signal_emit (self, signals[SIGNAL_OBJECTS_CHANGED], 0);
+
+  self->emitting_added = NULL;
+  self->emitting_removed = NULL;
+
+  /* followers may have been waiting for the shared set to be installed */
+  wp_object_manager_foreach_follower (self,
+      follower_maybe_objects_changed, NULL);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+wp_object_manager_maybe_objects_changed (WpObjectManager * self)
+{
+  WpObjectManager *storage = wp_object_manager_get_storage (self);
+
+  wp_trace_object (self, "pending:%u changed:%d idle_source:%p installed:%d",
+      storage->pending->len, self->changed, self->idle_source,
+      self->installed);
+
+  /* always wait until there are no pending objects */
+  if (storage->pending->len > 0)
     return;
 
   /* Emit 'objects-changed' when:
@@ -711,28 +1936,87 @@ wp_object_manager_maybe_objects_changed (WpObjectManager * self)
    * - the registry has globals; if we are on early startup where we don't
    * have any globals yet, wait...
    */
+  else if (!self->installed && self->leader) {
+    /* followers are installed together with the shared set */
+    if (self->leader->installed) {
+      wp_trace_object (self, "installed");
+      g_signal_emit (self, signals[SIGNAL_INSTALLED], 0);
+      self->installed = TRUE;
+    }
+  }
   else if (!self->installed) {
     g_autoptr (WpCore) core = g_weak_ref_get (&self->core);
     if (core) {
       WpRegistry *reg = wp_core_get_registry (core);
-      if (reg->tmp_globals->len == 0 && reg->globals->len != 0) {
+      if (reg->tmp_globals->len == 0 && reg->globals->len != 0 &&
+          !wp_registry_is_exposing_to (reg, self)) {
         wp_trace_object (self, "installed");
         g_signal_emit (self, signals[SIGNAL_INSTALLED], 0);
         self->installed = TRUE;
       }
     }
   }
+
+  wp_object_manager_foreach_follower (self,
+      follower_maybe_objects_changed, NULL);
+}
+
+static void
+wp_object_manager_emit_object_added (WpObjectManager * self, gpointer object)
+{
+  if (wp_object_manager_wants_changes (self, SIGNAL_OBJECTS_ADDED)) {
+    g_hash_table_insert (self->batch_positions, object,
+        GUINT_TO_POINTER (self->batch_added->len));
+    g_ptr_array_add (self->batch_added, g_object_ref (object));
+  }
+  g_signal_emit (self, signals[SIGNAL_OBJECT_ADDED], 0, object);
+  self->changed = TRUE;
+}
+
+static void
+wp_object_manager_emit_object_removed (WpObjectManager * self,
+    gpointer object)
+{
+  g_autoptr (GObject) batch_ref = NULL;
+  gpointer pos;
+
+  /* an object that comes and goes within the same cycle is not reported */
+  if (g_hash_table_lookup_extended (self->batch_positions, object, NULL,
+          &pos)) {
+    guint index = GPOINTER_TO_UINT (pos);
+
+    g_hash_table_remove (self->batch_positions, object);
+    batch_ref = g_ptr_array_steal_index_fast (self->batch_added, index);
+    /* the last object was moved in the place of the removed one */
+    if (index < self->batch_added->len)
+      g_hash_table_insert (self->batch_positions,
+          g_ptr_array_index (self->batch_added, index),
+          GUINT_TO_POINTER (index));
+  }
+  else if (wp_object_manager_wants_changes (self, SIGNAL_OBJECTS_REMOVED))
+    g_ptr_array_add (self->batch_removed, g_object_ref (object));
+  g_signal_emit (self, signals[SIGNAL_OBJECT_REMOVED], 0, object);
+  self->changed = TRUE;
 }
 
 /* caller must also call wp_object_manager_maybe_objects_changed() after */
 static void
 wp_object_manager_add_object (WpObjectManager * self, gpointer object)
 {
+  /* the objects of self may have been handed over to a leader meanwhile */
+  self = wp_object_manager_get_storage (self);
+
   if (wp_object_manager_is_interested_in_object (self, object)) {
     wp_trace_object (self, "added: " WP_OBJECT_FORMAT, WP_OBJECT_ARGS (object));
+    wp_object_manager_objects_prepare_write (self);
+    g_hash_table_insert (self->positions, object,
+        GUINT_TO_POINTER (self->objects->len));
     g_ptr_array_add (self->objects, object);
-    g_signal_emit (self, signals[SIGNAL_OBJECT_ADDED], 0, object);
-    self->changed = TRUE;
+    object_add_managing_om (object, self);
+    wp_object_manager_index_object (self, object);
+    wp_object_manager_emit_object_added (self, object);
+    wp_object_manager_foreach_follower (self,
+        wp_object_manager_emit_object_added, object);
   }
 }
 
@@ -740,21 +2024,39 @@ wp_object_manager_add_object (WpObjectManager * self, gpointer object)
 static void
 wp_object_manager_rm_object (WpObjectManager * self, gpointer object)
 {
-  guint index;
-  if (g_ptr_array_find (self->objects, object, &index)) {
+  gpointer pos;
+
+  if (g_hash_table_lookup_extended (self->positions, object, NULL, &pos)) {
+    g_autoptr (GObject) ref = g_object_ref (object);
+    guint index = GPOINTER_TO_UINT (pos);
+
+    wp_object_manager_objects_prepare_write (self);
+    g_hash_table_remove (self->positions, object);
     g_ptr_array_remove_index_fast (self->objects, index);
-    g_signal_emit (self, signals[SIGNAL_OBJECT_REMOVED], 0, object);
-    self->changed = TRUE;
+    /* the last object was moved in the place of the removed one */
+    if (index < self->objects->len)
+      g_hash_table_insert (self->positions,
+          g_ptr_array_index (self->objects, index), GUINT_TO_POINTER (index));
+    object_remove_managing_om (object, self);
+    wp_object_manager_unindex_object (self, object);
+    wp_object_manager_emit_object_removed (self, object);
+    wp_object_manager_foreach_follower (self,
+        wp_object_manager_emit_object_removed, object);
   }
 }
 
 static void
 on_proxy_ready (GObject * proxy, GAsyncResult * res, gpointer data)
 {
-  g_autoptr (WpObjectManager) self = WP_OBJECT_MANAGER (data);
+  struct om_pending *p = data;
+  g_autoptr (WpObjectManager) self = p->om;
   g_autoptr (GError) error = NULL;
 
-  self->pending_objects--;
+  /* p->om may have changed in the meantime, if the objects of the
+     object manager that started the activation were taken over */
+  g_ptr_array_remove_fast (self->pending, p);
+  wp_global_unref (p->global);
+  g_free (p);
 
   if (!wp_object_activate_finish (WP_OBJECT (proxy), res, &error)) {
     wp_debug_object (self, "proxy activation failed: %s", error->message);
@@ -771,6 +2073,9 @@ wp_object_manager_add_global (WpObjectManager * self, WpGlobal * global)
 {
   WpProxyFeatures features = 0;
 
+  /* the objects of self may have been handed over to a leader meanwhile */
+  self = wp_object_manager_get_storage (self);
+
   /* do not allow proxies that don't have a defined subclass;
      bind will fail because proxy_class->pw_iface_type is NULL */
   if (global->type == WP_TYPE_GLOBAL_PROXY)
@@ -779,8 +2084,6 @@ wp_object_manager_add_global (WpObjectManager * self, WpGlobal * global)
   if (wp_object_manager_is_interested_in_global (self, global, &features)) {
     g_autoptr (WpCore) core = g_weak_ref_get (&self->core);
 
-    self->pending_objects++;
-
     if (!global->proxy)
       global->proxy = g_object_new (global->type,
           "core", core,
@@ -790,8 +2093,19 @@ wp_object_manager_add_global (WpObjectManager * self, WpGlobal * global)
     wp_trace_object (self, "adding global:%u -> " WP_OBJECT_FORMAT,
         global->id, WP_OBJECT_ARGS (global->proxy));
 
+    /* in passive mode, the proxy is exposed unbound, as it is */
+    if (self->passive) {
+      wp_object_manager_add_object (self, global->proxy);
+      return;
+    }
+
+    struct om_pending *p = g_new0 (struct om_pending, 1);
+    p->om = g_object_ref (self);
+    p->global = wp_global_ref (global);
+    g_ptr_array_add (self->pending, p);
+
     wp_object_activate (WP_OBJECT (global->proxy), features, NULL,
-        on_proxy_ready, g_object_ref (self));
+        on_proxy_ready, p);
   }
 }
 
@@ -849,11 +2163,51 @@ wp_object_manager_add_global (WpObjectManager * self, WpGlobal * global)
 #undef G_LOG_DOMAIN
 #define G_LOG_DOMAIN "wp-registry"
 
+void
+wp_registry_invalidate_om_dispatch (WpRegistry *self)
+{
+  if (self->om_dispatch)
+    g_hash_table_remove_all (self->om_dispatch);
+}
+
+/*
+ * Returns the object managers that have at least one interest on a type
+ * that \a type is (a descendant of). The returned array is owned by the
+ * dispatch table and is only valid until the table is invalidated, which
+ * may happen as soon as any external code runs (i.e. signal handlers)
+ */
+static GPtrArray *
+wp_registry_get_om_dispatch (WpRegistry *self, GType type)
+{
+  GPtrArray *oms = g_hash_table_lookup (self->om_dispatch,
+      GSIZE_TO_POINTER (type));
+
+  if (G_UNLIKELY (!oms)) {
+    oms = g_ptr_array_new ();
+    for (guint i = 0; i < self->object_managers->len; i++) {
+      WpObjectManager *om = g_ptr_array_index (self->object_managers, i);
+      if (wp_object_manager_is_interested_in_type (om, type))
+        g_ptr_array_add (oms, om);
+    }
+    g_hash_table_insert (self->om_dispatch, GSIZE_TO_POINTER (type), oms);
+  }
+  return oms;
+}
+
 static void
 wp_registry_notify_add_object (WpRegistry *self, gpointer object)
 {
-  for (guint i = 0; i < self->object_managers->len; i++) {
-    WpObjectManager *om = g_ptr_array_index (self->object_managers, i);
+  g_autoptr (GPtrArray) oms = NULL;
+
+  /* keep a ref on the interested object managers, as signal handlers may
+     install or destroy object managers and invalidate the dispatch table */
+  oms = g_ptr_array_copy (
+      wp_registry_get_om_dispatch (self, G_OBJECT_TYPE (object)),
+      (GCopyFunc) g_object_ref, NULL);
+  g_ptr_array_set_free_func (oms, g_object_unref);
+
+  for (guint i = 0; i < oms->len; i++) {
+    WpObjectManager *om = g_ptr_array_index (oms, i);
     wp_object_manager_add_object (om, object);
     wp_object_manager_maybe_objects_changed (om);
   }
@@ -862,8 +2216,19 @@ wp_registry_notify_add_object (WpRegistry *self, gpointer object)
 static void
 wp_registry_notify_rm_object (WpRegistry *self, gpointer object)
 {
-  for (guint i = 0; i < self->object_managers->len; i++) {
-    WpObjectManager *om = g_ptr_array_index (self->object_managers, i);
+  GPtrArray *oms = object_get_managing_oms (object);
+  g_autoptr (GPtrArray) copy = NULL;
+
+  if (!oms || oms->len == 0)
+    return;
+
+  /* signal handlers may destroy object managers or make them drop the
+     object, so work on a copy and check membership again on every step */
+  copy = g_ptr_array_copy (oms, NULL, NULL);
+  for (guint i = 0; i < copy->len; i++) {
+    WpObjectManager *om = g_ptr_array_index (copy, i);
+    if (!g_ptr_array_find (oms, om, NULL))
+      continue;
     wp_object_manager_rm_object (om, object);
     wp_object_manager_maybe_objects_changed (om);
   }
@@ -873,7 +2238,28 @@ static void
 object_manager_destroyed (gpointer data, GObject * om)
 {
   WpRegistry *self = data;
+  const gchar *share_key = WP_OBJECT_MANAGER (om)->share_key;
+
+  guint index;
+
   g_ptr_array_remove_fast (self->object_managers, om);
+  wp_registry_invalidate_om_dispatch (self);
+
+  /* forget about it if its globals are still being exposed */
+  if (self->exposing_oms &&
+      g_ptr_array_find (self->exposing_oms, om, &index)) {
+    g_ptr_array_remove_index (self->exposing_oms, index);
+    g_hash_table_remove (self->exposing_om_globals, om);
+    if (index < self->exposing_om)
+      self->exposing_om--;
+    /* the next one in line starts from its first global */
+    else if (index == self->exposing_om)
+      self->exposing_global = 0;
+  }
+
+  if (share_key && self->shared_oms &&
+      g_hash_table_lookup (self->shared_oms, share_key) == om)
+    g_hash_table_remove (self->shared_oms, share_key);
 }
 
 /* find the subclass of WpPipewireGloabl that can handle
@@ -952,6 +2338,15 @@ static const struct pw_registry_events registry_events = {
   .global_remove = registry_global_remove,
 };
 
+/* how long exposing new globals to the object managers may block the main
+   loop before yielding; "wireplumber.expose-budget-ms" in the context
+   properties overrides it and 0 means no limit */
+#define DEFAULT_EXPOSE_BUDGET_MS 10
+
+struct ports_node;
+static void ports_node_free (struct ports_node * pn);
+static void wp_registry_flush_ports_nodes (WpRegistry * self);
+
 void
 wp_registry_init (WpRegistry *self)
 {
@@ -961,15 +2356,38 @@ wp_registry_init (WpRegistry *self)
       g_ptr_array_new_with_free_func ((GDestroyNotify) wp_global_unref);
   self->objects = g_ptr_array_new_with_free_func (g_object_unref);
   self->object_managers = g_ptr_array_new ();
+  self->om_dispatch = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+      NULL, (GDestroyNotify) g_ptr_array_unref);
+  self->shared_oms = g_hash_table_new (g_str_hash, g_str_equal);
+  self->ports_nodes = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+      NULL, (GDestroyNotify) ports_node_free);
+  self->node_ports = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+      NULL, (GDestroyNotify) g_ptr_array_unref);
+  self->ports_dirty = g_hash_table_new (g_direct_hash, g_direct_equal);
+  self->expose_budget_ns = DEFAULT_EXPOSE_BUDGET_MS * SPA_NSEC_PER_MSEC;
 }
 
 void
 wp_registry_clear (WpRegistry *self)
 {
   wp_registry_detach (self);
+  if (self->expose_source) {
+    g_source_destroy (self->expose_source);
+    g_clear_pointer (&self->expose_source, g_source_unref);
+  }
   g_clear_pointer (&self->globals, g_ptr_array_unref);
   g_clear_pointer (&self->tmp_globals, g_ptr_array_unref);
 
+  /* drop the port index; nodes that still have FEATURE_PORTS enabled
+     will simply see no ports from now on */
+  if (self->ports_om) {
+    g_signal_handlers_disconnect_by_data (self->ports_om, self);
+    g_clear_object (&self->ports_om);
+  }
+  g_clear_pointer (&self->ports_nodes, g_hash_table_unref);
+  g_clear_pointer (&self->node_ports, g_hash_table_unref);
+  g_clear_pointer (&self->ports_dirty, g_hash_table_unref);
+
   /* remove all the registered objects
      this will normally also destroy the object managers, eventually, since
      they are normally ref'ed by modules, which are registered objects */
@@ -996,17 +2414,49 @@ wp_registry_clear (WpRegistry *self)
       g_object_weak_unref (om, object_manager_destroyed, self);
     }
   }
+
+  g_clear_pointer (&self->om_dispatch, g_hash_table_unref);
+  g_clear_pointer (&self->shared_oms, g_hash_table_unref);
 }
 
 void
 wp_registry_attach (WpRegistry *self, struct pw_core *pw_core)
 {
+  const struct pw_properties *props = pw_core_get_properties (pw_core);
+  const gchar *budget = pw_properties_get (props,
+      "wireplumber.expose-budget-ms");
+
+  /* fractions are allowed, mainly so that tests can expose one global
+     per main loop iteration */
+  if (budget)
+    self->expose_budget_ns =
+        MAX (g_ascii_strtod (budget, NULL), 0.0) * SPA_NSEC_PER_MSEC;
+
+  /* "wireplumber.om-timing" makes the object managers also measure the time
+     that they spend checking objects against their interests; only the
+     counters are kept otherwise, as reading the clock on every check is not
+     free */
+  self->om_timing =
+      spa_atob (pw_properties_get (props, "wireplumber.om-timing"));
+  for (guint i = 0; i < self->object_managers->len; i++) {
+    WpObjectManager *om = g_ptr_array_index (self->object_managers, i);
+    om->timing = self->om_timing;
+  }
+
   self->pw_registry = pw_core_get_registry (pw_core,
       PW_VERSION_REGISTRY, 0);
   pw_registry_add_listener (self->pw_registry, &self->listener,
       &registry_events, self);
 }
 
+static void
+wp_registry_stop_exposing (WpRegistry * self)
+{
+  g_clear_pointer (&self->exposing_om_globals, g_hash_table_unref);
+  g_clear_pointer (&self->exposing_oms, g_ptr_array_unref);
+  g_clear_pointer (&self->exposing_globals, g_ptr_array_unref);
+}
+
 void
 wp_registry_detach (WpRegistry *self)
 {
@@ -1038,6 +2488,10 @@ wp_registry_detach (WpRegistry *self)
       to NULL, so there is no further interference */
   }
 
+  /* stop exposing globals; the ones that were being exposed are
+     already in the globals list */
+  wp_registry_stop_exposing (self);
+
   /* drop tmp globals as well */
   objlist = self->tmp_globals;
   while (objlist && objlist->len > 0) {
@@ -1047,27 +2501,24 @@ wp_registry_detach (WpRegistry *self)
   }
 }
 
-static gboolean
-expose_tmp_globals (WpCore *core)
+/* moves the tmp globals to the globals list and sorts them per object
+   manager, to be exposed to them by wp_registry_continue_exposing() */
+static void
+wp_registry_start_exposing (WpRegistry * self)
 {
-  WpRegistry *self = wp_core_get_registry (core);
-  g_autoptr (GPtrArray) tmp_globals = NULL;
-  g_autoptr (GPtrArray) object_managers = NULL;
-
-  /* in case the registry was cleared in the meantime... */
-  if (G_UNLIKELY (!self->tmp_globals))
-    return G_SOURCE_REMOVE;
+  WpCore *core = wp_registry_get_core (self);
+  GPtrArray *globals;
 
   /* steal the tmp_globals list and replace it with an empty one */
-  tmp_globals = self->tmp_globals;
+  globals = self->exposing_globals = self->tmp_globals;
   self->tmp_globals =
       g_ptr_array_new_with_free_func ((GDestroyNotify) wp_global_unref);
 
-  wp_debug_object (core, "exposing %u new globals", tmp_globals->len);
+  wp_debug_object (core, "exposing %u new globals", globals->len);
 
   /* traverse in the order that the globals appeared on the registry */
-  for (guint i = 0; i < tmp_globals->len; i++) {
-    WpGlobal *g = g_ptr_array_index (tmp_globals, i);
+  for (guint i = 0; i < globals->len; i++) {
+    WpGlobal *g = g_ptr_array_index (globals, i);
 
     /* if global was already removed, drop it */
     if (g->flags == 0 || g->id == SPA_ID_INVALID)
@@ -1080,8 +2531,11 @@ expose_tmp_globals (WpCore *core)
         wp_global_rm_flag (old_g, WP_GLOBAL_FLAG_OWNED_BY_PROXY);
     }
 
-    g_return_val_if_fail (self->globals->len <= g->id ||
-        g_ptr_array_index (self->globals, g->id) == NULL, G_SOURCE_REMOVE);
+    if (G_UNLIKELY (self->globals->len > g->id &&
+            g_ptr_array_index (self->globals, g->id) != NULL)) {
+      wp_critical_object (core, "global %u is already exposed", g->id);
+      continue;
+    }
 
     /* set the registry, so that wp_global_rm_flag() can work full-scale */
     g->registry = self;
@@ -1092,26 +2546,146 @@ expose_tmp_globals (WpCore *core)
     g_ptr_array_index (self->globals, g->id) = wp_global_ref (g);
   }
 
-  object_managers = g_ptr_array_copy (self->object_managers,
-      (GCopyFunc) g_object_ref, NULL);
-  g_ptr_array_set_free_func (object_managers, g_object_unref);
+  /* sort the globals per object manager, offering each global only to the
+     object managers that have an interest on its type; this must be done
+     before notifying any of them, as notifying runs external code that
+     may invalidate the dispatch table */
+  self->exposing_oms = g_ptr_array_copy (self->object_managers, NULL, NULL);
+  self->exposing_om_globals = g_hash_table_new_full (g_direct_hash,
+      g_direct_equal, NULL, (GDestroyNotify) g_ptr_array_unref);
+  self->exposing_om = 0;
+  self->exposing_global = 0;
+
+  for (guint i = 0; i < globals->len; i++) {
+    WpGlobal *g = g_ptr_array_index (globals, i);
+    GPtrArray *oms;
+
+    /* if global was already removed or failed to be stored, drop it */
+    if (g->flags == 0 || g->id == SPA_ID_INVALID || g->registry != self)
+      continue;
 
-  /* notify object managers */
-  for (guint i = 0; i < object_managers->len; i++) {
-    WpObjectManager *om = g_ptr_array_index (object_managers, i);
+    oms = wp_registry_get_om_dispatch (self, g->type);
+    for (guint j = 0; j < oms->len; j++) {
+      WpObjectManager *om = g_ptr_array_index (oms, j);
+      GPtrArray *om_globals =
+          g_hash_table_lookup (self->exposing_om_globals, om);
+      if (!om_globals) {
+        om_globals = g_ptr_array_new ();
+        g_hash_table_insert (self->exposing_om_globals, om, om_globals);
+      }
+      g_ptr_array_add (om_globals, g);
+    }
+  }
+}
 
-    for (guint i = 0; i < tmp_globals->len; i++) {
-      WpGlobal *g = g_ptr_array_index (tmp_globals, i);
+/*
+ * Notifies the object managers about the globals that are being exposed,
+ * until the time budget runs out. Every object manager gets all of its
+ * globals before the next one starts, as it did when this was done at once.
+ * \returns TRUE if all the globals have been exposed (or the exposure
+ *   was stopped in the meantime), FALSE if there is more to do
+ */
+static gboolean
+wp_registry_continue_exposing (WpRegistry * self)
+{
+  guint64 deadline = self->expose_budget_ns ?
+      get_monotonic_time_ns () + self->expose_budget_ns : 0;
 
-      /* if global was already removed, drop it */
+  while (self->exposing_oms && self->exposing_om < self->exposing_oms->len) {
+    /* look it up on every step; its objects may be taken over by a hidden
+       leader from a signal handler, which then takes its place here */
+    g_autoptr (WpObjectManager) om = g_object_ref (
+        g_ptr_array_index (self->exposing_oms, self->exposing_om));
+    GPtrArray *globals = g_hash_table_lookup (self->exposing_om_globals, om);
+
+    if (globals && self->exposing_global < globals->len) {
+      WpGlobal *g = g_ptr_array_index (globals, self->exposing_global++);
+
+      /* if global was removed in the meantime, drop it */
       if (g->flags == 0 || g->id == SPA_ID_INVALID)
         continue;
 
       wp_object_manager_add_global (om, g);
+
+      /* the registry was detached from a signal handler */
+      if (G_UNLIKELY (!self->exposing_oms))
+        return TRUE;
+
+      /* always make some progress, then yield to the main loop */
+      if (deadline && get_monotonic_time_ns () >= deadline)
+        return FALSE;
+      continue;
     }
+
+    self->exposing_om++;
+    self->exposing_global = 0;
     wp_object_manager_maybe_objects_changed (om);
   }
+  return TRUE;
+}
+
+/* TRUE if \a om is yet to be notified about some globals */
+static gboolean
+wp_registry_is_exposing_to (WpRegistry * self, WpObjectManager * om)
+{
+  guint index;
+
+  return self->exposing_oms &&
+      g_ptr_array_find (self->exposing_oms, om, &index) &&
+      index >= self->exposing_om;
+}
+
+static void
+wp_registry_finish_exposing (WpRegistry * self)
+{
+  g_autoptr (GPtrArray) object_managers = NULL;
+
+  wp_registry_stop_exposing (self);
+
+  /* object managers that were installed while exposing could not consider
+     themselves installed until now */
+  object_managers = g_ptr_array_copy (self->object_managers,
+      (GCopyFunc) g_object_ref, NULL);
+  g_ptr_array_set_free_func (object_managers, g_object_unref);
+
+  for (guint i = 0; i < object_managers->len; i++) {
+    WpObjectManager *om = g_ptr_array_index (object_managers, i);
+    if (!om->installed)
+      wp_object_manager_maybe_objects_changed (om);
+  }
+
+  /* nodes may have been waiting for their ports to be exposed */
+  if (self->ports_dirty && g_hash_table_size (self->ports_dirty) > 0)
+    wp_registry_flush_ports_nodes (self);
+}
+
+static gboolean
+expose_tmp_globals (WpCore *core)
+{
+  WpRegistry *self = wp_core_get_registry (core);
 
+  /* in case the registry was cleared in the meantime... */
+  if (G_UNLIKELY (!self->tmp_globals))
+    goto done;
+
+  if (!self->exposing_globals) {
+    if (self->tmp_globals->len == 0)
+      goto done;
+    wp_registry_start_exposing (self);
+  }
+
+  /* resume in the next main loop iteration if the budget ran out */
+  if (!wp_registry_continue_exposing (self))
+    return G_SOURCE_CONTINUE;
+
+  wp_registry_finish_exposing (self);
+
+  /* globals that appeared in the meantime are exposed next */
+  if (self->tmp_globals && self->tmp_globals->len > 0)
+    return G_SOURCE_CONTINUE;
+
+done:
+  g_clear_pointer (&self->expose_source, g_source_unref);
   return G_SOURCE_REMOVE;
 }
 
@@ -1153,17 +2727,27 @@ wp_registry_prepare_new_global (WpRegistry * self, guint32 id,
     global->id = id;
     global->type = type;
     global->permissions = permissions;
-    global->properties = props ?
-        wp_properties_new_copy_dict (props) : wp_properties_new_empty ();
     global->proxy = proxy;
     g_ptr_array_add (self->tmp_globals, wp_global_ref (global));
 
     /* ensure we have 'object.id' so that we can filter by id on object managers */
-    wp_properties_setf (global->properties, PW_KEY_OBJECT_ID, "%u", global->id);
+    {
+      g_autoptr (WpPropertiesBuilder) b =
+          wp_properties_builder_new (props ? props->n_items + 1 : 1);
+      gchar id_str[11];
+
+      if (props)
+        wp_properties_builder_add_dict (b, props);
+      g_snprintf (id_str, sizeof (id_str), "%u", global->id);
+      wp_properties_builder_add (b, PW_KEY_OBJECT_ID, id_str);
+      global->properties =
+          wp_properties_builder_end_intern (g_steal_pointer (&b));
+    }
 
-    /* schedule exposing when adding the first global */
-    if (self->tmp_globals->len == 1) {
-      wp_core_idle_add_closure (core, NULL,
+    /* schedule exposing when adding the first global, unless a previous
+       exposure is still running; that one picks these up when it is done */
+    if (!self->expose_source) {
+      wp_core_idle_add_closure (core, &self->expose_source,
           g_cclosure_new_object (G_CALLBACK (expose_tmp_globals), G_OBJECT (core)));
     }
   } else {
@@ -1184,8 +2768,12 @@ wp_registry_prepare_new_global (WpRegistry * self, guint32 id,
       global->proxy = proxy;
     }
 
-    if (props)
+    /* the interned properties are immutable; switch to a copy */
+    if (props) {
+      global->properties =
+          wp_properties_ensure_unique_owner (global->properties);
       wp_properties_update_from_dict (global->properties, props);
+    }
   }
 
   if (new_global)
@@ -1270,6 +2858,312 @@ wp_registry_remove_object (WpRegistry *reg, gpointer obj)
   g_ptr_array_remove_fast (reg->objects, obj);
 }
 
+/* object managers with equal keys manage exactly the same objects */
+static gchar *
+wp_object_manager_get_share_key (WpObjectManager * self)
+{
+  g_autoptr (GPtrArray) parts = g_ptr_array_new_with_free_func (g_free);
+  GHashTableIter iter;
+  gpointer type, features;
+
+  for (guint i = 0; i < self->interests->len; i++) {
+    WpObjectInterest *interest = g_ptr_array_index (self->interests, i);
+    g_autofree gchar *str = wp_object_interest_to_canonical_string (interest);
+    g_ptr_array_add (parts, g_strdup_printf ("i:%s", str));
+  }
+
+  g_hash_table_iter_init (&iter, self->features);
+  while (g_hash_table_iter_next (&iter, &type, &features)) {
+    g_ptr_array_add (parts, g_strdup_printf ("f:%s:%x",
+        g_type_name (GPOINTER_TO_SIZE (type)), GPOINTER_TO_UINT (features)));
+  }
+
+  return wp_object_interest_join_canonical (
+      self->passive ? "passive" : "active", '\n', parts);
+}
+
+static WpObjectManager *
+wp_object_manager_new_leader (WpObjectManager * om)
+{
+  WpObjectManager *self = wp_object_manager_new ();
+  GHashTableIter iter;
+  gpointer type, features;
+
+  self->hidden = TRUE;
+  self->passive = om->passive;
+
+  for (guint i = 0; i < om->interests->len; i++)
+    g_ptr_array_add (self->interests,
+        wp_object_interest_ref (g_ptr_array_index (om->interests, i)));
+
+  g_hash_table_iter_init (&iter, om->features);
+  while (g_hash_table_iter_next (&iter, &type, &features))
+    g_hash_table_insert (self->features, type, features);
+
+  wp_trace_object (self, "new shared object manager");
+  return self;
+}
+
+static void
+wp_object_manager_follow (WpObjectManager * self, WpObjectManager * leader,
+    WpCore * core)
+{
+  g_autoptr (GPtrArray) objects = NULL;
+
+  wp_trace_object (self, "following " WP_OBJECT_FORMAT,
+      WP_OBJECT_ARGS (leader));
+
+  self->leader = g_object_ref (leader);
+  g_ptr_array_add (leader->followers, self);
+  g_weak_ref_set (&self->core, core);
+
+  /* indexes and sorted views are maintained on the shared set */
+  for (guint i = 0; i < self->indexes->len; i++) {
+    struct om_index *idx = g_ptr_array_index (self->indexes, i);
+    wp_object_manager_add_index (leader, idx->type, idx->key);
+  }
+  for (guint i = 0; i < self->views->len; i++) {
+    struct om_sorted_view *view = g_ptr_array_index (self->views, i);
+    wp_object_manager_add_sorted_view (leader, view->type,
+        (const gchar * const *) view->keys, view->flags);
+  }
+
+  /* catch up with the objects that are already in the shared set */
+  objects = g_ptr_array_copy (leader->objects, (GCopyFunc) g_object_ref, NULL);
+  g_ptr_array_set_free_func (objects, g_object_unref);
+  for (guint i = 0; i < objects->len; i++) {
+    gpointer object = g_ptr_array_index (objects, i);
+    if (g_hash_table_contains (leader->positions, object))
+      wp_object_manager_emit_object_added (self, object);
+  }
+
+  wp_object_manager_maybe_objects_changed (self);
+}
+
+/* makes \a om one of the object managers that the registry notifies */
+static void
+wp_registry_add_object_manager (WpRegistry * reg, WpObjectManager * om)
+{
+  g_object_weak_ref (G_OBJECT (om), object_manager_destroyed, reg);
+  g_ptr_array_add (reg->object_managers, om);
+  g_weak_ref_set (&om->core, wp_registry_get_core (reg));
+  om->timing = reg->om_timing;
+  wp_registry_invalidate_om_dispatch (reg);
+}
+
+static void
+wp_registry_install_object_manager (WpRegistry * reg, WpObjectManager * om)
+{
+  guint i;
+
+  wp_registry_add_object_manager (reg, om);
+
+  /* add pre-existing objects to the object manager,
+     in case it's interested in them */
+  for (i = 0; i < reg->globals->len; i++) {
+    WpGlobal *g = g_ptr_array_index (reg->globals, i);
+    /* check if null because the globals array can have gaps */
+    if (g && wp_object_manager_is_interested_in_type (om, g->type))
+      wp_object_manager_add_global (om, g);
+  }
+  for (i = 0; i < reg->objects->len; i++) {
+    GObject *o = g_ptr_array_index (reg->objects, i);
+    if (wp_object_manager_is_interested_in_type (om, G_OBJECT_TYPE (o)))
+      wp_object_manager_add_object (om, o);
+  }
+
+  wp_object_manager_maybe_objects_changed (om);
+}
+
+/*
+ * Hands the objects of the installed object manager \a om over to a new
+ * hidden leader, which takes its place on the registry, and makes \a om
+ * follow it. The objects of \a om do not change, so nothing is announced.
+ * \returns (transfer none): the leader
+ */
+static WpObjectManager *
+wp_registry_share_object_manager (WpRegistry * reg, WpObjectManager * om)
+{
+  g_autoptr (WpObjectManager) om_ref = g_object_ref (om);
+  WpObjectManager *leader = wp_object_manager_new_leader (om);
+  GPtrArray *globals = NULL, *tmp;
+  gboolean watching;
+  guint index;
+
+  wp_trace_object (om, "sharing objects with " WP_OBJECT_FORMAT,
+      WP_OBJECT_ARGS (leader));
+
+  /* the leader takes the place of om on the registry */
+  g_object_weak_unref (G_OBJECT (om), object_manager_destroyed, reg);
+  g_ptr_array_remove_fast (reg->object_managers, om);
+  wp_registry_add_object_manager (reg, leader);
+  leader->share_key = g_steal_pointer (&om->share_key);
+  g_hash_table_replace (reg->shared_oms, leader->share_key, leader);
+
+  if (reg->exposing_oms && g_ptr_array_find (reg->exposing_oms, om, &index)) {
+    g_ptr_array_index (reg->exposing_oms, index) = leader;
+    if (g_hash_table_steal_extended (reg->exposing_om_globals, om, NULL,
+            (gpointer *) &globals))
+      g_hash_table_insert (reg->exposing_om_globals, leader, globals);
+  }
+
+  /* the indexes and the sorted views move along with the objects, so that
+     the sorted iterators in progress go on; om keeps a record of them */
+  watching = wp_object_manager_watches_objects (om);
+  for (guint i = 0; i < om->objects->len; i++) {
+    gpointer object = g_ptr_array_index (om->objects, i);
+    g_hash_table_insert (leader->positions, object,
+        GUINT_TO_POINTER (leader->objects->len));
+    g_ptr_array_add (leader->objects, object);
+    object_remove_managing_om (object, om);
+    object_add_managing_om (object, leader);
+    if (watching) {
+      g_signal_handlers_disconnect_by_func (object,
+          on_indexed_object_notify, om);
+      g_signal_connect (object, "notify",
+          G_CALLBACK (on_indexed_object_notify), leader);
+    }
+  }
+  tmp = leader->indexes;
+  leader->indexes = om->indexes;
+  om->indexes = tmp;
+  for (guint i = 0; i < leader->indexes->len; i++) {
+    struct om_index *idx = g_ptr_array_index (leader->indexes, i);
+    g_ptr_array_add (om->indexes, om_index_new (idx->type, idx->key));
+  }
+  tmp = leader->views;
+  leader->views = om->views;
+  om->views = tmp;
+  for (guint i = 0; i < leader->views->len; i++) {
+    struct om_sorted_view *view = g_ptr_array_index (leader->views, i);
+    g_ptr_array_add (om->views, om_sorted_view_new (view->type,
+            (const gchar * const *) view->keys, view->flags));
+  }
+
+  /* iterators that are in progress on om keep walking the array they have */
+  g_hash_table_remove_all (om->positions);
+  wp_object_manager_objects_release (om->objects, om->objects_readers);
+  om->objects = g_ptr_array_new ();
+  om->objects_readers = 0;
+  om->objects_gen++;
+
+  /* the activations that are in progress complete on the leader */
+  for (guint i = 0; i < om->pending->len; i++) {
+    struct om_pending *p = g_ptr_array_index (om->pending, i);
+    p->om = g_object_ref (leader);
+    g_object_unref (om);
+  }
+  g_ptr_array_extend_and_steal (leader->pending,
+      g_steal_pointer (&om->pending));
+  om->pending = g_ptr_array_new ();
+
+  leader->installed = om->installed;
+  leader->n_evaluations = om->n_evaluations;
+  leader->n_matches = om->n_matches;
+  leader->time_ns = om->time_ns;
+
+  /* om keeps the reference that the leader was created with */
+  om->leader = leader;
+  g_ptr_array_add (leader->followers, om);
+  return leader;
+}
+
+/*
+ * Makes the follower \a self hold its objects again, so that its interests
+ * or its requested features can change without affecting the other
+ * followers of its leader. Its objects do not change, so nothing is
+ * announced; the objects that the leader is still preparing or is yet to
+ * be offered are added to \a self as well, as usual.
+ */
+static void
+wp_registry_unshare_object_manager (WpRegistry * reg, WpObjectManager * self)
+{
+  g_autoptr (WpObjectManager) leader = g_steal_pointer (&self->leader);
+  g_autoptr (GPtrArray) pending = NULL;
+  guint index;
+
+  wp_trace_object (self, "leaving " WP_OBJECT_FORMAT,
+      WP_OBJECT_ARGS (leader));
+
+  g_ptr_array_remove_fast (leader->followers, self);
+  wp_registry_add_object_manager (reg, self);
+
+  for (guint i = 0; i < leader->objects->len; i++) {
+    gpointer object = g_ptr_array_index (leader->objects, i);
+    g_hash_table_insert (self->positions, object,
+        GUINT_TO_POINTER (self->objects->len));
+    g_ptr_array_add (self->objects, object);
+    object_add_managing_om (object, self);
+    wp_object_manager_index_object (self, object);
+  }
+  self->n_evaluations = leader->n_evaluations;
+  self->n_matches = leader->n_matches;
+  self->time_ns = leader->time_ns;
+
+  /* the globals that the leader is yet to be offered */
+  if (reg->exposing_oms &&
+      g_ptr_array_find (reg->exposing_oms, leader, &index) &&
+      index >= reg->exposing_om) {
+    GPtrArray *globals = g_hash_table_lookup (reg->exposing_om_globals,
+        leader);
+    guint first = (index == reg->exposing_om) ? reg->exposing_global : 0;
+
+    if (globals && first < globals->len) {
+      GPtrArray *rest = g_ptr_array_sized_new (globals->len - first);
+      for (guint i = first; i < globals->len; i++)
+        g_ptr_array_add (rest, g_ptr_array_index (globals, i));
+      g_ptr_array_add (reg->exposing_oms, self);
+      g_hash_table_insert (reg->exposing_om_globals, self, rest);
+    }
+  }
+
+  /* and the ones that it is preparing; signal handlers may run from here */
+  pending = g_ptr_array_new_with_free_func ((GDestroyNotify) wp_global_unref);
+  for (guint i = 0; i < leader->pending->len; i++) {
+    struct om_pending *p = g_ptr_array_index (leader->pending, i);
+    g_ptr_array_add (pending, wp_global_ref (p->global));
+  }
+  for (guint i = 0; i < pending->len; i++) {
+    WpGlobal *g = g_ptr_array_index (pending, i);
+    if (g->flags != 0 && g->id != SPA_ID_INVALID)
+      wp_object_manager_add_global (self, g);
+  }
+
+  wp_object_manager_maybe_objects_changed (self);
+}
+
+/*
+ * Called after the interests or the requested features of \a self changed.
+ * If it is installed, its objects are no longer the ones that a new object
+ * manager with the same interests would have, so it stops being shared.
+ */
+static void
+wp_object_manager_interests_changed (WpObjectManager * self)
+{
+  g_autoptr (WpCore) core = g_weak_ref_get (&self->core);
+  WpRegistry *reg;
+
+  if (!core)
+    return;
+
+  reg = wp_core_get_registry (core);
+
+  /* prevent bad things when called from within wp_registry_clear() */
+  if (G_UNLIKELY (!reg->shared_oms))
+    return;
+
+  if (self->leader)
+    wp_registry_unshare_object_manager (reg, self);
+  else if (self->share_key) {
+    if (g_hash_table_lookup (reg->shared_oms, self->share_key) == self)
+      g_hash_table_remove (reg->shared_oms, self->share_key);
+    g_clear_pointer (&self->share_key, g_free);
+  }
+
+  /* the types that it may be interested in may have changed */
+  wp_registry_invalidate_om_dispatch (reg);
+}
+
 /*!
  * \brief Installs the object manager on this core, activating its internal
  * management engine.
@@ -1277,6 +3171,12 @@ wp_registry_remove_object (WpRegistry *reg, gpointer obj)
  * This will immediately emit signals about objects added on \a om
  * if objects that the \a om is interested in were in existence already.
  *
+ * Object managers that have equal interests and request the same object
+ * features share a single set of objects internally, which is evaluated
+ * only once for every object. Each of them still emits its own signals.
+ * An object manager whose interests or requested features are changed
+ * after it is installed stops sharing its objects.
+ *
  * \ingroup wpobjectmanager
  * \param self the core
  * \param om (transfer none): a WpObjectManager
@@ -1285,31 +3185,405 @@ void
 wp_core_install_object_manager (WpCore * self, WpObjectManager * om)
 {
   WpRegistry *reg;
-  guint i;
+  g_autofree gchar *share_key = NULL;
+  WpObjectManager *shared;
 
   g_return_if_fail (WP_IS_CORE (self));
   g_return_if_fail (WP_IS_OBJECT_MANAGER (om));
+  g_return_if_fail (om->leader == NULL);
 
   reg = wp_core_get_registry (self);
 
-  g_object_weak_ref (G_OBJECT (om), object_manager_destroyed, reg);
-  g_ptr_array_add (reg->object_managers, om);
-  g_weak_ref_set (&om->core, self);
+  /* prevent bad things when called from within wp_registry_clear() */
+  if (G_UNLIKELY (!reg->shared_oms))
+    return;
 
-  /* add pre-existing objects to the object manager,
-     in case it's interested in them */
-  for (i = 0; i < reg->globals->len; i++) {
-    WpGlobal *g = g_ptr_array_index (reg->globals, i);
-    /* check if null because the globals array can have gaps */
-    if (g)
-      wp_object_manager_add_global (om, g);
+  /* the first object manager with a key holds its objects by itself;
+     they are handed over to a hidden leader when a second one comes */
+  share_key = wp_object_manager_get_share_key (om);
+  shared = g_hash_table_lookup (reg->shared_oms, share_key);
+  if (!shared) {
+    om->share_key = g_steal_pointer (&share_key);
+    g_hash_table_insert (reg->shared_oms, om->share_key, om);
+    wp_registry_install_object_manager (reg, om);
+    return;
   }
-  for (i = 0; i < reg->objects->len; i++) {
-    GObject *o = g_ptr_array_index (reg->objects, i);
-    wp_object_manager_add_object (om, o);
+
+  if (!shared->hidden)
+    shared = wp_registry_share_object_manager (reg, shared);
+  wp_object_manager_follow (om, shared, self);
+}
+
+/*!
+ * \brief Describes the statistics of all the object managers that are
+ * installed on this core, like wp_object_manager_dump_stats() does
+ *
+ * Object managers that share their objects are listed once.
+ *
+ * \ingroup wpobjectmanager
+ * \param self the core
+ * \returns (transfer full): the statistics, on multiple lines
+ */
+gchar *
+wp_core_dump_object_manager_stats (WpCore * self)
+{
+  WpRegistry *reg;
+  GString *str;
+
+  g_return_val_if_fail (WP_IS_CORE (self), NULL);
+
+  reg = wp_core_get_registry (self);
+  str = g_string_new (NULL);
+
+  /* the list is gone while the registry is being cleared */
+  if (reg->object_managers) {
+    for (guint i = 0; i < reg->object_managers->len; i++)
+      wp_object_manager_append_stats (
+          g_ptr_array_index (reg->object_managers, i), str);
   }
+  return g_string_free (str, FALSE);
+}
 
-  wp_object_manager_maybe_objects_changed (om);
+/* port index */
+
+/* a node that has WP_NODE_FEATURE_PORTS enabled, or is enabling it */
+struct ports_node
+{
+  WpNode *node; /* without a ref */
+  GPtrArray *ports; /* the ports that are ready, element-type: WpPort* */
+  GHashTable *pending; /* set of WpPort* that are being activated */
+  gboolean synced; /* a core sync completed after the node was added */
+  gboolean enabled; /* WP_NODE_FEATURE_PORTS was enabled on the node */
+};
+
+static void
+ports_node_free (struct ports_node * pn)
+{
+  g_ptr_array_unref (pn->ports);
+  g_hash_table_unref (pn->pending);
+  g_slice_free (struct ports_node, pn);
+}
+
+static guint32
+port_get_node_id (WpPort * port)
+{
+  g_autoptr (WpProperties) props =
+      wp_global_proxy_get_global_properties (WP_GLOBAL_PROXY (port));
+  const gchar *str =
+      props ? wp_properties_get_by_atom (props, WP_PROP_KEY_NODE_ID) : NULL;
+  return str ? (guint32) strtoul (str, NULL, 10) : SPA_ID_INVALID;
+}
+
+/*
+ * Enables WP_NODE_FEATURE_PORTS on the nodes that are waiting for it and
+ * emits "ports-changed" on the ones whose ports changed, but only once none
+ * of their ports is still being activated
+ */
+static void
+wp_registry_flush_ports_nodes (WpRegistry * self)
+{
+  g_autoptr (GPtrArray) enabled =
+      g_ptr_array_new_with_free_func (g_object_unref);
+  g_autoptr (GPtrArray) changed =
+      g_ptr_array_new_with_free_func (g_object_unref);
+  GHashTableIter iter;
+  gpointer key;
+  gboolean exposed;
+
+  /* ports that were announced before the sync completed may still be
+     waiting to be exposed to the object manager */
+  exposed = self->ports_om && wp_object_manager_is_installed (self->ports_om)
+      && self->tmp_globals && self->tmp_globals->len == 0
+      && !self->exposing_globals;
+
+  /* collect the nodes first; the handlers may well enable or disable
+     the ports feature on other nodes */
+  g_hash_table_iter_init (&iter, self->ports_dirty);
+  while (g_hash_table_iter_next (&iter, &key, NULL)) {
+    struct ports_node *pn = g_hash_table_lookup (self->ports_nodes, key);
+
+    if (!pn) {
+      g_hash_table_iter_remove (&iter);
+      continue;
+    }
+    if (g_hash_table_size (pn->pending) > 0)
+      continue;
+
+    if (!pn->enabled) {
+      if (!exposed || !pn->synced)
+        continue;
+      pn->enabled = TRUE;
+      g_ptr_array_add (enabled, g_object_ref (pn->node));
+    } else {
+      g_ptr_array_add (changed, g_object_ref (pn->node));
+    }
+    g_hash_table_iter_remove (&iter);
+  }
+
+  for (guint i = 0; i < enabled->len; i++)
+    wp_object_update_features (g_ptr_array_index (enabled, i),
+        WP_NODE_FEATURE_PORTS, 0);
+  for (guint i = 0; i < changed->len; i++)
+    g_signal_emit_by_name (g_ptr_array_index (changed, i), "ports-changed");
+}
+
+static void
+on_ports_port_activated (WpObject * port, GAsyncResult * res, gpointer data)
+{
+  g_autoptr (WpCore) core = wp_object_get_core (port);
+  g_autoptr (GError) error = NULL;
+  gboolean ready = wp_object_activate_finish (port, res, &error);
+  WpRegistry *self;
+  struct ports_node *pn;
+  guint32 node_id;
+
+  if (!ready)
+    wp_debug_object (port, "port activation failed: %s", error->message);
+
+  /* prevent bad things when the core is being destroyed */
+  if (!core)
+    return;
+  self = wp_core_get_registry (core);
+  if (G_UNLIKELY (!self->ports_nodes))
+    return;
+
+  /* the node may have stopped tracking its ports in the meantime */
+  node_id = port_get_node_id (WP_PORT (port));
+  pn = g_hash_table_lookup (self->ports_nodes, GUINT_TO_POINTER (node_id));
+  if (!pn || !g_hash_table_remove (pn->pending, port))
+    return;
+
+  if (ready) {
+    g_ptr_array_add (pn->ports, port);
+    g_hash_table_add (self->ports_dirty, GUINT_TO_POINTER (node_id));
+  }
+  wp_registry_flush_ports_nodes (self);
+}
+
+static void
+wp_registry_activate_node_port (WpRegistry * self, struct ports_node * pn,
+    WpPort * port)
+{
+  g_hash_table_add (pn->pending, port);
+  wp_object_activate (WP_OBJECT (port), WP_OBJECT_FEATURES_ALL, NULL,
+      (GAsyncReadyCallback) on_ports_port_activated, NULL);
+}
+
+static void
+on_ports_om_object_added (WpObjectManager * om, WpPort * port,
+    WpRegistry * self)
+{
+  guint32 node_id = port_get_node_id (port);
+  struct ports_node *pn;
+  GPtrArray *ports;
+
+  if (node_id == SPA_ID_INVALID)
+    return;
+
+  ports = g_hash_table_lookup (self->node_ports, GUINT_TO_POINTER (node_id));
+  if (!ports) {
+    ports = g_ptr_array_new ();
+    g_hash_table_insert (self->node_ports, GUINT_TO_POINTER (node_id), ports);
+  }
+  g_ptr_array_add (ports, port);
+
+  /* only the ports of the nodes that asked for them are bound */
+  pn = g_hash_table_lookup (self->ports_nodes, GUINT_TO_POINTER (node_id));
+  if (pn)
+    wp_registry_activate_node_port (self, pn, port);
+}
+
+static void
+on_ports_om_object_removed (WpObjectManager * om, WpPort * port,
+    WpRegistry * self)
+{
+  guint32 node_id = port_get_node_id (port);
+  struct ports_node *pn;
+  GPtrArray *ports;
+
+  ports = g_hash_table_lookup (self->node_ports, GUINT_TO_POINTER (node_id));
+  if (!ports || !g_ptr_array_remove (ports, port))
+    return;
+  if (ports->len == 0)
+    g_hash_table_remove (self->node_ports, GUINT_TO_POINTER (node_id));
+
+  pn = g_hash_table_lookup (self->ports_nodes, GUINT_TO_POINTER (node_id));
+  if (pn) {
+    g_hash_table_remove (pn->pending, port);
+    if (g_ptr_array_remove (pn->ports, port))
+      g_hash_table_add (self->ports_dirty, GUINT_TO_POINTER (node_id));
+  }
+}
+
+static void
+on_ports_om_changed (WpObjectManager * om, WpRegistry * self)
+{
+  wp_registry_flush_ports_nodes (self);
+}
+
+static void
+on_ports_node_synced (WpCore * core, GAsyncResult * res, WpNode * node)
+{
+  g_autoptr (WpNode) node_ref = node;
+  g_autoptr (GError) error = NULL;
+  WpRegistry *self = wp_core_get_registry (core);
+  struct ports_node *pn;
+
+  if (!wp_core_sync_finish (core, res, &error))
+    wp_debug_object (node, "core sync failed: %s", error->message);
+
+  if (G_UNLIKELY (!self->ports_nodes))
+    return;
+
+  pn = g_hash_table_lookup (self->ports_nodes,
+      GUINT_TO_POINTER (wp_proxy_get_bound_id (WP_PROXY (node))));
+  if (pn && pn->node == node) {
+    pn->synced = TRUE;
+    wp_registry_flush_ports_nodes (self);
+  }
+}
+
+/*
+ * \brief Starts tracking the ports of \a node in the core-wide port index
+ *
+ * All the ports of the graph are kept unbound in a single passive object
+ * manager, which is created on first use, and are bucketed by their
+ * "node.id" property. Only the ports of the nodes that are tracked here
+ * are bound and activated.
+ *
+ * WP_NODE_FEATURE_PORTS is enabled on \a node after a core sync, once all
+ * the ports that were announced up to that point have been activated;
+ * after that, "ports-changed" is emitted on \a node every time the set of
+ * its ready ports changes.
+ *
+ * \param self the registry
+ * \param node_id the bound id of \a node
+ * \param node (transfer none): the node
+ */
+void
+wp_registry_add_ports_node (WpRegistry *self, guint32 node_id, WpNode *node)
+{
+  WpCore *core = wp_registry_get_core (self);
+  struct ports_node *pn;
+
+  /* prevent bad things when called from within wp_registry_clear() */
+  if (G_UNLIKELY (!self->ports_nodes))
+    return;
+
+  /* the id may still be tracked by an older node, which is gone from the
+     server; the new node takes over: it activates the same ports again,
+     which also completes the activations that are in progress, and the
+     sync of the old node is ignored */
+  pn = g_hash_table_lookup (self->ports_nodes, GUINT_TO_POINTER (node_id));
+  if (pn) {
+    g_return_if_fail (pn->node != node);
+    wp_debug_object (node, "takes over the ports of node:%u from "
+        WP_OBJECT_FORMAT, node_id, WP_OBJECT_ARGS (pn->node));
+  }
+
+  pn = g_slice_new0 (struct ports_node);
+  pn->node = node;
+  pn->ports = g_ptr_array_new ();
+  pn->pending = g_hash_table_new (g_direct_hash, g_direct_equal);
+  g_hash_table_insert (self->ports_nodes, GUINT_TO_POINTER (node_id), pn);
+  g_hash_table_add (self->ports_dirty, GUINT_TO_POINTER (node_id));
+
+  if (!self->ports_om) {
+    /* passive, so that ports are not bound until a node asks for them */
+    self->ports_om = wp_object_manager_new ();
+    wp_object_manager_set_passive (self->ports_om, TRUE);
+    wp_object_manager_add_interest (self->ports_om, WP_TYPE_PORT, NULL);
+    g_signal_connect (self->ports_om, "object-added",
+        G_CALLBACK (on_ports_om_object_added), self);
+    g_signal_connect (self->ports_om, "object-removed",
+        G_CALLBACK (on_ports_om_object_removed), self);
+    g_signal_connect (self->ports_om, "objects-changed",
+        G_CALLBACK (on_ports_om_changed), self);
+    g_signal_connect (self->ports_om, "installed",
+        G_CALLBACK (on_ports_om_changed), self);
+    wp_core_install_object_manager (core, self->ports_om);
+  } else {
+    GPtrArray *ports =
+        g_hash_table_lookup (self->node_ports, GUINT_TO_POINTER (node_id));
+    for (guint i = 0; ports && i < ports->len; i++)
+      wp_registry_activate_node_port (self, pn, g_ptr_array_index (ports, i));
+  }
+
+  /* ports of a new node may still be on their way from the server */
+  wp_core_sync (core, NULL, (GAsyncReadyCallback) on_ports_node_synced,
+      g_object_ref (node));
+}
+
+/*
+ * \brief Stops tracking the ports of \a node
+ *
+ * \param self the registry
+ * \param node_id the id that \a node was added with
+ * \param node (transfer none): the node
+ */
+void
+wp_registry_remove_ports_node (WpRegistry *self, guint32 node_id,
+    WpNode *node)
+{
+  struct ports_node *pn;
+
+  if (G_UNLIKELY (!self->ports_nodes))
+    return;
+
+  /* the id may have been recycled by a newer node in the meantime */
+  pn = g_hash_table_lookup (self->ports_nodes, GUINT_TO_POINTER (node_id));
+  if (pn && pn->node == node) {
+    g_hash_table_remove (self->ports_nodes, GUINT_TO_POINTER (node_id));
+    g_hash_table_remove (self->ports_dirty, GUINT_TO_POINTER (node_id));
+  }
+}
+
+/*
+ * \param self the registry
+ * \param node_id the bound id of a node
+ * \returns (transfer none) (nullable) (element-type WpPort*): the ready
+ *   ports of the node with \a node_id, or NULL if it is not tracked
+ */
+GPtrArray *
+wp_registry_get_node_ports (WpRegistry *self, guint32 node_id)
+{
+  struct ports_node *pn;
+
+  if (G_UNLIKELY (!self->ports_nodes))
+    return NULL;
+  pn = g_hash_table_lookup (self->ports_nodes, GUINT_TO_POINTER (node_id));
+  return pn ? pn->ports : NULL;
+}
+
+/*
+ * \brief Iterates through the ready ports of \a node that match \a interest,
+ * like wp_object_manager_new_filtered_iterator_full() does
+ *
+ * \param self (nullable): the registry, or NULL if the core is gone
+ * \param node_id the id that \a node was added with
+ * \param node (transfer none): the node
+ * \param interest (transfer full) (nullable): the interest, or NULL to
+ *   iterate through all the ports
+ * \returns (transfer full) (nullable): the iterator, or NULL if \a interest
+ *   is not valid
+ */
+WpIterator *
+wp_registry_new_node_ports_iterator (WpRegistry *self, guint32 node_id,
+    WpNode *node, WpObjectInterest *interest)
+{
+  GPtrArray *ports = self ? wp_registry_get_node_ports (self, node_id) : NULL;
+  GPtrArray *items;
+
+  if (interest && !om_interest_validate (node, interest))
+    return NULL;
+
+  /* no object manager keeps the ports alive while iterating,
+     so the copy holds a reference on each one of them */
+  items = ports ?
+      g_ptr_array_copy (ports, (GCopyFunc) g_object_ref, NULL) :
+      g_ptr_array_new ();
+  g_ptr_array_set_free_func (items, g_object_unref);
+  return om_iterator_new (NULL, items, interest);
 }
 
 /* WpGlobal */
@@ -1374,7 +3648,9 @@ wp_global_rm_flag (WpGlobal *global, guint rm_flag)
      * this WpGlobal is not used in reference to objects added later.
      */
     global->id = SPA_ID_INVALID;
-    wp_properties_setf (global->properties, PW_KEY_OBJECT_ID, NULL);
+    global->properties =
+        wp_properties_ensure_unique_owner (global->properties);
+    wp_properties_set (global->properties, PW_KEY_OBJECT_ID, NULL);
   }
 
   /* drop the registry's ref on global when it does not appear on the registry anymore */
@@ -32,6 +32,12 @@ WpObjectManager * wp_object_manager_new (void);
 WP_API
 gboolean wp_object_manager_is_installed (WpObjectManager * self);
 
+WP_API
+void wp_object_manager_set_passive (WpObjectManager * self, gboolean passive);
+
+WP_API
+gboolean wp_object_manager_is_passive (WpObjectManager * self);
+
 /* interest */
 
 WP_API
@@ -48,11 +54,39 @@ WP_API
 void wp_object_manager_request_object_features (WpObjectManager *self,
     GType object_type, WpObjectFeatures wanted_features);
 
+/* indexes */
+
+WP_API
+void wp_object_manager_add_index (WpObjectManager * self,
+    WpConstraintType type, const gchar * key);
+
+/* sorted views */
+
+/*!
+ * \brief Flags that change how the values of a sorted view are parsed
+ * \ingroup wpobjectmanager
+ */
+typedef enum { /*< flags >*/
+  WP_SORTED_VIEW_FLAGS_NONE = 0,
+  /*! parse the values like atoi() does: the integer at the start of the
+   *  value counts and anything that follows it is ignored */
+  WP_SORTED_VIEW_FLAG_INTEGER = (1 << 0),
+} WpSortedViewFlags;
+
+WP_API
+void wp_object_manager_add_sorted_view (WpObjectManager * self,
+    WpConstraintType type, const gchar * const * keys,
+    WpSortedViewFlags flags);
+
 /* object inspection */
 
 WP_API
 guint wp_object_manager_get_n_objects (WpObjectManager * self);
 
+WP_API
+gboolean wp_object_manager_get_pending_changes (WpObjectManager * self,
+    GPtrArray ** added, GPtrArray ** removed);
+
 WP_API
 WpIterator * wp_object_manager_new_iterator (WpObjectManager * self);
 
@@ -64,6 +98,11 @@ WP_API
 WpIterator * wp_object_manager_new_filtered_iterator_full (
     WpObjectManager * self, WpObjectInterest * interest);
 
+WP_API
+WpIterator * wp_object_manager_new_sorted_iterator (WpObjectManager * self,
+    WpConstraintType type, const gchar * const * keys,
+    WpSortedViewFlags flags, WpObjectInterest * interest);
+
 WP_API
 gpointer wp_object_manager_lookup (WpObjectManager * self,
     GType gtype, ...) G_GNUC_NULL_TERMINATED;
@@ -72,6 +111,34 @@ WP_API
 gpointer wp_object_manager_lookup_full (WpObjectManager * self,
     WpObjectInterest * interest);
 
+/* statistics */
+
+typedef struct _WpObjectManagerStats WpObjectManagerStats;
+
+/*!
+ * \brief Statistics of the objects that an object manager has evaluated
+ * \ingroup wpobjectmanager
+ */
+struct _WpObjectManagerStats
+{
+  /*! the number of times that an object or a global was checked against
+      the interests */
+  guint64 n_evaluations;
+  /*! the number of these checks that matched at least one interest */
+  guint64 n_matches;
+  /*! the time spent checking objects against the interests, in nanoseconds;
+      only measured when "wireplumber.om-timing" is set in the context
+      properties, 0 otherwise */
+  guint64 time_ns;
+};
+
+WP_API
+void wp_object_manager_get_stats (WpObjectManager * self,
+    WpObjectManagerStats * stats);
+
+WP_API
+gchar * wp_object_manager_dump_stats (WpObjectManager * self);
+
 G_END_DECLS
 
 #endif
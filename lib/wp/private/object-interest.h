@@ -0,0 +1,33 @@
+/* WirePlumber
+ *
+ * Copyright © 2020 Collabora Ltd.
+ *    @author George Kiagiadakis <george.kiagiadakis@collabora.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __WIREPLUMBER_OBJECT_INTEREST_PRIVATE_H__
+#define __WIREPLUMBER_OBJECT_INTEREST_PRIVATE_H__
+
+#include "object-interest.h"
+
+G_BEGIN_DECLS
+
+GType wp_object_interest_get_gtype (WpObjectInterest * self);
+
+GVariant * wp_object_interest_find_equals_value (WpObjectInterest * self,
+    WpConstraintType type, const gchar * subject);
+
+gchar * wp_object_interest_to_canonical_string (WpObjectInterest * self);
+
+gchar * wp_object_interest_join_canonical (const gchar * prefix,
+    gchar separator, GPtrArray * parts);
+
+void wp_object_interest_add_time (WpObjectInterest * self, guint64 time_ns);
+
+void wp_object_interest_append_stats (WpObjectInterest * self, GString * str,
+    const gchar * indent);
+
+G_END_DECLS
+
+#endif
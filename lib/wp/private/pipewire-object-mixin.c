@@ -782,8 +782,10 @@ wp_pw_object_mixin_handle_event_info (gpointer instance, gconstpointer update)
     const struct spa_dict * props =
         G_STRUCT_MEMBER (const struct spa_dict *, d->info, iface->props_offset);
 
+    /* intern the properties, as many objects share most of their values;
+       this also lets them outlive the info struct that they come from */
     g_clear_pointer (&d->properties, wp_properties_unref);
-    d->properties = wp_properties_new_wrap_dict (props);
+    d->properties = wp_properties_new_intern_dict (props);
 
     g_object_notify (G_OBJECT (instance), "properties");
   }
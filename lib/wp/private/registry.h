@@ -11,6 +11,7 @@
 
 #include "core.h"
 #include "global-proxy.h"
+#include "node.h"
 
 #include <pipewire/pipewire.h>
 
@@ -30,6 +31,36 @@ struct _WpRegistry
   GPtrArray *tmp_globals; // elementy-type: WpGlobal*
   GPtrArray *objects; // element-type: GObject*
   GPtrArray *object_managers; // element-type: WpObjectManager*
+
+  /* object GType -> GPtrArray of the object managers that have at least one
+     interest that this type can match; built lazily on lookup and
+     dropped whenever the set of object managers or their interests change */
+  GHashTable *om_dispatch;
+
+  /* share key -> the installed object manager that holds the objects for
+     that key: the first one that was installed with it, or the hidden
+     leader that took over its objects when a second one came; without a ref */
+  GHashTable *shared_oms;
+
+  /* whether the object managers measure the time of their evaluations */
+  gboolean om_timing;
+
+  /* globals that are being exposed to the object managers; this is done
+     one object manager after the other, in the order that the globals
+     appeared, taking at most 'expose_budget_ns' per main loop iteration */
+  GSource *expose_source;
+  guint64 expose_budget_ns;
+  GPtrArray *exposing_globals; // element-type: WpGlobal*
+  GPtrArray *exposing_oms; // element-type: WpObjectManager*, without a ref
+  GHashTable *exposing_om_globals; // om -> GPtrArray of WpGlobal*
+  guint exposing_om; // the current position in exposing_oms
+  guint exposing_global; // the current position in the globals of that om
+
+  /* core-wide port index, backing WP_NODE_FEATURE_PORTS */
+  WpObjectManager *ports_om; // passive, holds all the ports unbound
+  GHashTable *ports_nodes; // node id -> the node that tracks its ports
+  GHashTable *node_ports; // node id -> GPtrArray of WpPort*, without a ref
+  GHashTable *ports_dirty; // set of node ids that need to be notified
 };
 
 void wp_registry_init (WpRegistry *self);
@@ -47,6 +78,16 @@ gpointer wp_registry_find_object (WpRegistry *reg, GEqualFunc func,
 void wp_registry_register_object (WpRegistry *reg, gpointer obj);
 void wp_registry_remove_object (WpRegistry *reg, gpointer obj);
 
+void wp_registry_invalidate_om_dispatch (WpRegistry *self);
+
+void wp_registry_add_ports_node (WpRegistry *self, guint32 node_id,
+    WpNode *node);
+void wp_registry_remove_ports_node (WpRegistry *self, guint32 node_id,
+    WpNode *node);
+GPtrArray * wp_registry_get_node_ports (WpRegistry *self, guint32 node_id);
+WpIterator * wp_registry_new_node_ports_iterator (WpRegistry *self,
+    guint32 node_id, WpNode *node, WpObjectInterest *interest);
+
 WpCore * wp_registry_get_core (WpRegistry * self) G_GNUC_CONST;
 
 /* core */
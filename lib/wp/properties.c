@@ -12,6 +12,7 @@
 
 #include <errno.h>
 #include <pipewire/properties.h>
+#include <pipewire/keys.h>
 
 /*! \defgroup wpproperties WpProperties */
 /*!
@@ -40,6 +41,23 @@
  * the ownership of the `struct pw_properties` remains outside. This must
  * be used with care, as the `struct pw_properties` may be free'ed externally.
  *
+ * Owned properties sets with many items also maintain an internal hash table
+ * index, so that looking up or updating a key does not have to scan all the
+ * items. The index is transparent; the `struct spa_dict` view is unaffected.
+ *
+ * Copies made with wp_properties_copy() (and therefore also with
+ * wp_properties_ensure_unique_owner()) are copy-on-write: the copy shares the
+ * underlying `struct pw_properties` with the original until either of them
+ * is modified.
+ *
+ * Properties sets that are created with wp_properties_new_intern_dict() or
+ * wp_properties_builder_end_intern() store their keys and values in a
+ * process-wide pool of reference-counted, immutable strings, so that sets
+ * with repeated keys and values share the same storage. Such a set is
+ * immutable; copies of it are not, and they are converted to a regular
+ * `struct pw_properties` the first time they are modified. See
+ * wp_properties_get_pool_stats() for the pool statistics.
+ *
  * WpProperties is reference-counted with wp_properties_ref() and
  * wp_properties_unref().
  */
@@ -47,8 +65,17 @@
 enum {
   FLAG_IS_DICT = (1<<1),
   FLAG_NO_OWNERSHIP = (1<<2),
+  /* dict is an interned_dict, owned by this object or shared
+     like props, if shared is set */
+  FLAG_INTERNED = (1<<3),
+  /* the set was constructed interned and is shared as it is, with the
+     objects that it describes; it cannot be modified, but copies can */
+  FLAG_IMMUTABLE = (1<<4),
 };
 
+/* owned sets with at least this many items get a hash table index */
+#define INDEX_MIN_ITEMS 32
+
 struct _WpProperties
 {
   grefcount ref;
@@ -57,10 +84,142 @@ struct _WpProperties
     struct pw_properties *props;
     const struct spa_dict *dict;
   };
+  /* key -> position + 1 in the items of props->dict; built lazily on lookup
+     and kept in sync by all the functions that modify props */
+  GHashTable *index;
+  /* the number of WpProperties that share props, if it was shared by
+     wp_properties_copy(); props is copied before it is modified */
+  grefcount *shared;
+  /* WpPropKey -> position + 1 in the items of props->dict, or 0 if absent;
+     built lazily by wp_properties_get_by_atom() and kept in sync like index */
+  guint32 *key_slots;
+};
+
+static const gchar * const prop_keys[] = {
+  [WP_PROP_KEY_NONE] = NULL,
+  [WP_PROP_KEY_OBJECT_ID] = PW_KEY_OBJECT_ID,
+  [WP_PROP_KEY_OBJECT_PATH] = PW_KEY_OBJECT_PATH,
+  [WP_PROP_KEY_NODE_ID] = PW_KEY_NODE_ID,
+  [WP_PROP_KEY_NODE_NAME] = PW_KEY_NODE_NAME,
+  [WP_PROP_KEY_NODE_DESCRIPTION] = PW_KEY_NODE_DESCRIPTION,
+  [WP_PROP_KEY_MEDIA_CLASS] = PW_KEY_MEDIA_CLASS,
+  [WP_PROP_KEY_MEDIA_TYPE] = PW_KEY_MEDIA_TYPE,
+  [WP_PROP_KEY_MEDIA_CATEGORY] = PW_KEY_MEDIA_CATEGORY,
+  [WP_PROP_KEY_MEDIA_ROLE] = PW_KEY_MEDIA_ROLE,
+  [WP_PROP_KEY_DEVICE_ID] = PW_KEY_DEVICE_ID,
+  [WP_PROP_KEY_DEVICE_NAME] = PW_KEY_DEVICE_NAME,
+  [WP_PROP_KEY_DEVICE_API] = PW_KEY_DEVICE_API,
+  [WP_PROP_KEY_PORT_NAME] = PW_KEY_PORT_NAME,
+  [WP_PROP_KEY_PORT_DIRECTION] = PW_KEY_PORT_DIRECTION,
+  [WP_PROP_KEY_CLIENT_ID] = PW_KEY_CLIENT_ID,
+  [WP_PROP_KEY_APP_NAME] = PW_KEY_APP_NAME,
+  [WP_PROP_KEY_FACTORY_NAME] = PW_KEY_FACTORY_NAME,
+  [WP_PROP_KEY_PRIORITY_SESSION] = PW_KEY_PRIORITY_SESSION,
 };
+#define N_PROP_KEYS G_N_ELEMENTS (prop_keys)
 
 G_DEFINE_BOXED_TYPE(WpProperties, wp_properties, wp_properties_ref, wp_properties_unref)
 
+/* the pool of interned strings; a string is freed when the last
+   interned dict that refers to it is freed */
+struct pool_string
+{
+  guint refcount;
+  gsize len;
+  gchar str[];
+};
+
+G_LOCK_DEFINE_STATIC (string_pool);
+static GHashTable *string_pool = NULL; /* str -> struct pool_string */
+static WpPropertiesPoolStats string_pool_stats = { 0, };
+
+/* must be called with the string_pool lock held */
+static const gchar *
+string_pool_acquire (const gchar * str)
+{
+  struct pool_string *ps;
+
+  if (G_UNLIKELY (!string_pool))
+    string_pool = g_hash_table_new (g_str_hash, g_str_equal);
+
+  ps = g_hash_table_lookup (string_pool, str);
+  if (ps) {
+    ps->refcount++;
+    string_pool_stats.saved += ps->len + 1;
+  } else {
+    gsize len = strlen (str);
+    ps = g_malloc (sizeof (struct pool_string) + len + 1);
+    ps->refcount = 1;
+    ps->len = len;
+    memcpy (ps->str, str, len + 1);
+    g_hash_table_insert (string_pool, ps->str, ps);
+    string_pool_stats.n_strings++;
+    string_pool_stats.size += len + 1;
+  }
+  string_pool_stats.n_refs++;
+  return ps->str;
+}
+
+/* must be called with the string_pool lock held */
+static void
+string_pool_release (const gchar * str)
+{
+  struct pool_string *ps = (struct pool_string *)
+      (str - G_STRUCT_OFFSET (struct pool_string, str));
+
+  string_pool_stats.n_refs--;
+  if (--ps->refcount > 0) {
+    string_pool_stats.saved -= ps->len + 1;
+  } else {
+    g_hash_table_remove (string_pool, ps->str);
+    string_pool_stats.n_strings--;
+    string_pool_stats.size -= ps->len + 1;
+    g_free (ps);
+  }
+}
+
+struct interned_dict
+{
+  struct spa_dict dict;
+  struct spa_dict_item items[];
+};
+
+static struct spa_dict *
+interned_dict_new (const struct spa_dict * dict)
+{
+  struct interned_dict *d = g_malloc (sizeof (struct interned_dict) +
+      dict->n_items * sizeof (struct spa_dict_item));
+  const struct spa_dict_item *item;
+  guint32 n_items = 0;
+
+  G_LOCK (string_pool);
+  spa_dict_for_each (item, dict) {
+    if (item->key && item->value)
+      d->items[n_items++] = SPA_DICT_ITEM_INIT (
+          string_pool_acquire (item->key), string_pool_acquire (item->value));
+  }
+  G_UNLOCK (string_pool);
+
+  d->dict = SPA_DICT_INIT (d->items, n_items);
+  d->dict.flags = dict->flags & SPA_DICT_FLAG_SORTED;
+  return &d->dict;
+}
+
+static void
+interned_dict_free (struct spa_dict * dict)
+{
+  const struct spa_dict_item *item;
+
+  G_LOCK (string_pool);
+  spa_dict_for_each (item, dict) {
+    string_pool_release (item->key);
+    string_pool_release (item->value);
+  }
+  G_UNLOCK (string_pool);
+
+  g_free (SPA_CONTAINER_OF (dict, struct interned_dict, dict));
+}
+
 /*!
  * \brief Creates a new empty properties set
  * \ingroup wpproperties
@@ -277,10 +436,47 @@ wp_properties_new_copy_dict (const struct spa_dict * dict)
   return self;
 }
 
+/*!
+ * \brief Constructs a new WpProperties that contains all the properties
+ * contained in the given \a dict structure, stored in the pool of interned
+ * strings.
+ *
+ * Keys and values that are already in the pool are not copied again; they
+ * are shared with all the other interned properties sets that contain them.
+ * This is meant for the many properties sets that are kept around and share
+ * most of their values, such as the properties of PipeWire objects.
+ *
+ * The returned object is immutable, like the ones that wrap a `spa_dict`,
+ * because it is meant to be shared as it is. To modify it, make a copy with
+ * wp_properties_copy() or wp_properties_ensure_unique_owner(); the copy
+ * shares the interned strings until it is first modified.
+ *
+ * \ingroup wpproperties
+ * \param dict a native `spa_dict` structure to copy
+ * \returns (transfer full): the newly constructed properties set
+ */
+WpProperties *
+wp_properties_new_intern_dict (const struct spa_dict * dict)
+{
+  WpProperties * self;
+
+  g_return_val_if_fail (dict != NULL, NULL);
+
+  self = g_slice_new0 (WpProperties);
+  g_ref_count_init (&self->ref);
+  self->flags = FLAG_INTERNED | FLAG_IMMUTABLE;
+  self->dict = interned_dict_new (dict);
+  return self;
+}
+
 /*!
  * \brief Constructs and returns a new WpProperties object that contains a copy
  * of all the properties contained in \a other.
  *
+ * If \a other owns its properties, the actual copy is deferred: both objects
+ * share the same storage until one of them is modified. Properties objects
+ * that wrap a native `spa_dict` or `pw_properties` are copied immediately.
+ *
  * \ingroup wpproperties
  * \param other a properties object
  * \returns (transfer full): the newly constructed properties set
@@ -289,17 +485,204 @@ wp_properties_new_copy_dict (const struct spa_dict * dict)
 WpProperties *
 wp_properties_copy (WpProperties * other)
 {
-  return wp_properties_new_copy_dict (wp_properties_peek_dict (other));
+  WpProperties * self;
+
+  g_return_val_if_fail (other != NULL, NULL);
+
+  if (other->flags & (FLAG_IS_DICT | FLAG_NO_OWNERSHIP))
+    return wp_properties_new_copy_dict (wp_properties_peek_dict (other));
+
+  if (!other->shared) {
+    other->shared = g_new (grefcount, 1);
+    g_ref_count_init (other->shared);
+  }
+  g_ref_count_inc (other->shared);
+
+  self = g_slice_new0 (WpProperties);
+  g_ref_count_init (&self->ref);
+  self->flags = other->flags & FLAG_INTERNED;
+  self->props = other->props;
+  self->shared = other->shared;
+  return self;
+}
+
+/* makes sure that self->props is not shared with any other WpProperties,
+   so that it can be modified */
+static void
+wp_properties_unshare (WpProperties * self)
+{
+  if (self->flags & FLAG_INTERNED) {
+    /* interned strings are immutable; switch to a copy of them */
+    struct spa_dict *dict = (struct spa_dict *) self->dict;
+    struct pw_properties *props = pw_properties_new_dict (dict);
+
+    props->dict.flags |= (dict->flags & SPA_DICT_FLAG_SORTED);
+    if (!self->shared || g_ref_count_dec (self->shared)) {
+      g_clear_pointer (&self->shared, g_free);
+      interned_dict_free (dict);
+    }
+    self->shared = NULL;
+    self->flags &= ~FLAG_INTERNED;
+    self->props = props;
+    /* the index points to the interned keys */
+    g_clear_pointer (&self->index, g_hash_table_unref);
+    return;
+  }
+
+  if (!self->shared)
+    return;
+
+  if (g_ref_count_compare (self->shared, 1)) {
+    g_free (self->shared);
+  } else {
+    self->props = pw_properties_copy (self->props);
+    g_ref_count_dec (self->shared);
+    /* the index points to the keys of the shared props */
+    g_clear_pointer (&self->index, g_hash_table_unref);
+  }
+  self->shared = NULL;
 }
 
 static void
 wp_properties_free (WpProperties * self)
 {
-  if (!(self->flags & FLAG_NO_OWNERSHIP))
-    pw_properties_free (self->props);
+  g_clear_pointer (&self->index, g_hash_table_unref);
+  g_clear_pointer (&self->key_slots, g_free);
+  if (self->shared) {
+    if (g_ref_count_dec (self->shared))
+      g_clear_pointer (&self->shared, g_free);
+    else
+      self->flags |= FLAG_NO_OWNERSHIP;
+  }
+  if (!(self->flags & FLAG_NO_OWNERSHIP)) {
+    if (self->flags & FLAG_INTERNED)
+      interned_dict_free ((struct spa_dict *) self->dict);
+    else
+      pw_properties_free (self->props);
+  }
   g_slice_free (WpProperties, self);
 }
 
+static gboolean
+wp_properties_ensure_index (WpProperties * self)
+{
+  const struct spa_dict *dict;
+
+  if (self->index)
+    return TRUE;
+
+  /* externally owned dicts may change behind our back */
+  if (self->flags & (FLAG_IS_DICT | FLAG_NO_OWNERSHIP))
+    return FALSE;
+
+  dict = wp_properties_peek_dict (self);
+  if (dict->n_items < INDEX_MIN_ITEMS)
+    return FALSE;
+
+  self->index = g_hash_table_new (g_str_hash, g_str_equal);
+  for (guint32 i = 0; i < dict->n_items; i++)
+    g_hash_table_insert (self->index, (gpointer) dict->items[i].key,
+        GUINT_TO_POINTER (i + 1));
+  return TRUE;
+}
+
+static const struct spa_dict_item *
+wp_properties_lookup_item (WpProperties * self, const gchar * key)
+{
+  const struct spa_dict *dict = wp_properties_peek_dict (self);
+  guint pos;
+
+  if (!wp_properties_ensure_index (self))
+    return spa_dict_lookup_item (dict, key);
+
+  pos = GPOINTER_TO_UINT (g_hash_table_lookup (self->index, key));
+  return pos ? &dict->items[pos - 1] : NULL;
+}
+
+/* keeps the sorted flag, the index and the key slots in sync after
+   pw_properties_set() changed the number of items from \a n_items;
+   replacing a value keeps the item in place */
+static void
+wp_properties_items_changed (WpProperties * self, guint32 n_items)
+{
+  struct spa_dict *dict = &self->props->dict;
+
+  if (dict->n_items > n_items) {
+    /* new items are appended, which breaks the order of a sorted dict */
+    const gchar *key = dict->items[dict->n_items - 1].key;
+    dict->flags &= ~SPA_DICT_FLAG_SORTED;
+
+    if (self->index)
+      g_hash_table_insert (self->index, (gpointer) key,
+          GUINT_TO_POINTER (dict->n_items));
+    if (self->key_slots) {
+      WpPropKey atom = wp_prop_key_from_string (key);
+      if (atom != WP_PROP_KEY_NONE)
+        self->key_slots[atom] = dict->n_items;
+    }
+  }
+  else if (dict->n_items < n_items) {
+    /* removing an item moves the last item into its place, which breaks
+       the order of a sorted dict and invalidates the positions */
+    dict->flags &= ~SPA_DICT_FLAG_SORTED;
+    g_clear_pointer (&self->index, g_hash_table_unref);
+    g_clear_pointer (&self->key_slots, g_free);
+  }
+}
+
+/* the equivalent of pw_properties_set() that also maintains the index */
+static gint
+wp_properties_set_internal (WpProperties * self, const gchar * key,
+    const gchar * value)
+{
+  guint32 n_items;
+  gint res;
+
+  if (self->shared || (self->flags & FLAG_INTERNED)) {
+    if (!g_strcmp0 (wp_properties_get (self, key), value))
+      return 0;
+    wp_properties_unshare (self);
+  }
+
+  /* answer sets that change nothing from the index */
+  if (wp_properties_ensure_index (self)) {
+    const struct spa_dict_item *item = wp_properties_lookup_item (self, key);
+    if (item ? (value && g_str_equal (item->value, value)) : !value)
+      return 0;
+  }
+
+  n_items = self->props->dict.n_items;
+  res = pw_properties_set (self->props, key, value);
+  wp_properties_items_changed (self, n_items);
+  return res;
+}
+
+static gint
+wp_properties_update_internal (WpProperties * self,
+    const struct spa_dict * dict)
+{
+  const struct spa_dict_item *item;
+  gint changed = 0;
+
+  spa_dict_for_each (item, dict)
+    changed += wp_properties_set_internal (self, item->key, item->value);
+  return changed;
+}
+
+static gint
+wp_properties_add_internal (WpProperties * self,
+    const struct spa_dict * dict)
+{
+  const struct spa_dict_item *item;
+  gint changed = 0;
+
+  spa_dict_for_each (item, dict) {
+    if (!wp_properties_lookup_item (self, item->key))
+      changed += wp_properties_set_internal (self, item->key, item->value);
+  }
+  return changed;
+}
+
 /*!
  * \ingroup wpproperties
  * \param self a properties object
@@ -337,6 +720,9 @@ wp_properties_unref (WpProperties * self)
  * it is returned instead. You should always consider \a self as unsafe to use
  * after this call and you should use the returned object instead.
  *
+ * The copy is made with wp_properties_copy(), so the properties are only
+ * actually copied when the returned object is modified.
+ *
  * \ingroup wpproperties
  * \param self (transfer full): a properties object
  * \returns (transfer full): the uniquely owned properties object
@@ -345,7 +731,7 @@ WpProperties *
 wp_properties_ensure_unique_owner (WpProperties * self)
 {
   if (!g_ref_count_compare (&self->ref, 1) ||
-      self->flags & (FLAG_IS_DICT | FLAG_NO_OWNERSHIP))
+      self->flags & (FLAG_IS_DICT | FLAG_NO_OWNERSHIP | FLAG_IMMUTABLE))
   {
     WpProperties *copy = wp_properties_copy (self);
     wp_properties_unref (self);
@@ -371,8 +757,9 @@ wp_properties_update (WpProperties * self, WpProperties * props)
   g_return_val_if_fail (self != NULL, -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_IS_DICT), -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_NO_OWNERSHIP), -EINVAL);
+  g_return_val_if_fail (!(self->flags & FLAG_IMMUTABLE), -EINVAL);
 
-  return pw_properties_update (self->props, wp_properties_peek_dict (props));
+  return wp_properties_update_internal (self, wp_properties_peek_dict (props));
 }
 
 /*!
@@ -393,8 +780,9 @@ wp_properties_update_from_dict (WpProperties * self,
   g_return_val_if_fail (self != NULL, -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_IS_DICT), -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_NO_OWNERSHIP), -EINVAL);
+  g_return_val_if_fail (!(self->flags & FLAG_IMMUTABLE), -EINVAL);
 
-  return pw_properties_update (self->props, dict);
+  return wp_properties_update_internal (self, dict);
 }
 
 /*!
@@ -415,8 +803,9 @@ wp_properties_add (WpProperties * self, WpProperties * props)
   g_return_val_if_fail (self != NULL, -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_IS_DICT), -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_NO_OWNERSHIP), -EINVAL);
+  g_return_val_if_fail (!(self->flags & FLAG_IMMUTABLE), -EINVAL);
 
-  return pw_properties_add (self->props, wp_properties_peek_dict (props));
+  return wp_properties_add_internal (self, wp_properties_peek_dict (props));
 }
 
 /*!
@@ -438,8 +827,9 @@ wp_properties_add_from_dict (WpProperties * self,
   g_return_val_if_fail (self != NULL, -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_IS_DICT), -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_NO_OWNERSHIP), -EINVAL);
+  g_return_val_if_fail (!(self->flags & FLAG_IMMUTABLE), -EINVAL);
 
-  return pw_properties_add (self->props, dict);
+  return wp_properties_add_internal (self, dict);
 }
 
 /*!
@@ -466,6 +856,7 @@ wp_properties_update_keys (WpProperties * self, WpProperties * props,
   g_return_val_if_fail (self != NULL, -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_IS_DICT), -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_NO_OWNERSHIP), -EINVAL);
+  g_return_val_if_fail (!(self->flags & FLAG_IMMUTABLE), -EINVAL);
 
   va_list args;
   va_start (args, key1);
@@ -501,6 +892,7 @@ wp_properties_update_keys_from_dict (WpProperties * self,
   g_return_val_if_fail (self != NULL, -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_IS_DICT), -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_NO_OWNERSHIP), -EINVAL);
+  g_return_val_if_fail (!(self->flags & FLAG_IMMUTABLE), -EINVAL);
 
   va_list args;
   va_start (args, key1);
@@ -526,12 +918,19 @@ gint
 wp_properties_update_keys_array (WpProperties * self, WpProperties * props,
     const gchar * keys[])
 {
+  gint changed = 0;
+  const gchar *value;
+
   g_return_val_if_fail (self != NULL, -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_IS_DICT), -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_NO_OWNERSHIP), -EINVAL);
+  g_return_val_if_fail (!(self->flags & FLAG_IMMUTABLE), -EINVAL);
 
-  return pw_properties_update_keys (self->props,
-      wp_properties_peek_dict (props), keys);
+  for (; *keys; keys++) {
+    if ((value = wp_properties_get (props, *keys)) != NULL)
+      changed += wp_properties_set_internal (self, *keys, value);
+  }
+  return changed;
 }
 
 /*!
@@ -557,6 +956,7 @@ wp_properties_add_keys (WpProperties * self, WpProperties * props,
   g_return_val_if_fail (self != NULL, -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_IS_DICT), -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_NO_OWNERSHIP), -EINVAL);
+  g_return_val_if_fail (!(self->flags & FLAG_IMMUTABLE), -EINVAL);
 
   va_list args;
   va_start (args, key1);
@@ -593,6 +993,7 @@ wp_properties_add_keys_from_dict (WpProperties * self,
   g_return_val_if_fail (self != NULL, -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_IS_DICT), -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_NO_OWNERSHIP), -EINVAL);
+  g_return_val_if_fail (!(self->flags & FLAG_IMMUTABLE), -EINVAL);
 
   va_list args;
   va_start (args, key1);
@@ -620,12 +1021,21 @@ gint
 wp_properties_add_keys_array (WpProperties * self, WpProperties * props,
     const gchar * keys[])
 {
+  gint changed = 0;
+  const gchar *value;
+
   g_return_val_if_fail (self != NULL, -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_IS_DICT), -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_NO_OWNERSHIP), -EINVAL);
+  g_return_val_if_fail (!(self->flags & FLAG_IMMUTABLE), -EINVAL);
 
-  return pw_properties_add_keys (self->props,
-      wp_properties_peek_dict (props), keys);
+  for (; *keys; keys++) {
+    if ((value = wp_properties_get (props, *keys)) == NULL)
+      continue;
+    if (wp_properties_lookup_item (self, *keys) == NULL)
+      changed += wp_properties_set_internal (self, *keys, value);
+  }
+  return changed;
 }
 
 /*!
@@ -640,10 +1050,98 @@ wp_properties_add_keys_array (WpProperties * self, WpProperties * props,
 const gchar *
 wp_properties_get (WpProperties * self, const gchar * key)
 {
+  const struct spa_dict_item *item;
+
   g_return_val_if_fail (self != NULL, NULL);
   g_return_val_if_fail (key != NULL, NULL);
 
-  return spa_dict_lookup (wp_properties_peek_dict (self), key);
+  item = wp_properties_lookup_item (self, key);
+  return item ? item->value : NULL;
+}
+
+static GHashTable *
+prop_keys_table (void)
+{
+  static gsize initialized = 0;
+  static GHashTable *table = NULL;
+
+  if (g_once_init_enter (&initialized)) {
+    table = g_hash_table_new (g_str_hash, g_str_equal);
+    for (guint i = 1; i < N_PROP_KEYS; i++)
+      g_hash_table_insert (table, (gpointer) prop_keys[i], GUINT_TO_POINTER (i));
+    g_once_init_leave (&initialized, 1);
+  }
+  return table;
+}
+
+/*!
+ * \brief Finds the atom of a well-known property key
+ *
+ * \ingroup wpproperties
+ * \param key a property key
+ * \returns the atom of \a key, or WP_PROP_KEY_NONE if \a key is not
+ *   a well-known key
+ */
+WpPropKey
+wp_prop_key_from_string (const gchar * key)
+{
+  g_return_val_if_fail (key != NULL, WP_PROP_KEY_NONE);
+  return GPOINTER_TO_UINT (g_hash_table_lookup (prop_keys_table (), key));
+}
+
+/*!
+ * \brief Gets the property key that an atom stands for
+ *
+ * \ingroup wpproperties
+ * \param key a property key atom
+ * \returns (transfer none) (nullable): the property key, or NULL if \a key is
+ *   WP_PROP_KEY_NONE or not valid
+ */
+const gchar *
+wp_prop_key_to_string (WpPropKey key)
+{
+  return (key < N_PROP_KEYS) ? prop_keys[key] : NULL;
+}
+
+/*!
+ * \brief Looks up the value of a well-known property
+ *
+ * This is equivalent to calling wp_properties_get() with the key that
+ * \a key stands for, but on properties that are owned by \a self, the
+ * position of all the well-known keys is recorded on the first call and
+ * further lookups do not need to compare any strings.
+ *
+ * \ingroup wpproperties
+ * \param self a properties object
+ * \param key the atom of the property key
+ * \returns (transfer none) (nullable): the value of the property, or NULL
+ *   if this property is not contained in \a self
+ */
+const gchar *
+wp_properties_get_by_atom (WpProperties * self, WpPropKey key)
+{
+  const struct spa_dict *dict;
+  guint32 pos;
+
+  g_return_val_if_fail (self != NULL, NULL);
+  g_return_val_if_fail (key > WP_PROP_KEY_NONE && key < N_PROP_KEYS, NULL);
+
+  /* externally owned dicts may change behind our back */
+  if (self->flags & (FLAG_IS_DICT | FLAG_NO_OWNERSHIP))
+    return wp_properties_get (self, prop_keys[key]);
+
+  dict = wp_properties_peek_dict (self);
+  if (!self->key_slots) {
+    self->key_slots = g_new0 (guint32, N_PROP_KEYS);
+    for (guint32 i = 0; i < dict->n_items; i++) {
+      WpPropKey atom = wp_prop_key_from_string (dict->items[i].key);
+      if (atom != WP_PROP_KEY_NONE && !self->key_slots[atom])
+        self->key_slots[atom] = i + 1;
+    }
+  }
+
+  pos = self->key_slots[key];
+  return pos ? dict->items[pos - 1].value : NULL;
 }
 
 /*!
@@ -668,8 +1166,10 @@ wp_properties_set (WpProperties * self, const gchar * key,
   g_return_val_if_fail (self != NULL, -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_IS_DICT), -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_NO_OWNERSHIP), -EINVAL);
+  g_return_val_if_fail (!(self->flags & FLAG_IMMUTABLE), -EINVAL);
+  g_return_val_if_fail (key != NULL, -EINVAL);
 
-  return pw_properties_set (self->props, key, value);
+  return wp_properties_set_internal (self, key, value);
 }
 
 /*!
@@ -718,8 +1218,12 @@ wp_properties_setf_valist (WpProperties * self, const gchar * key,
   g_return_val_if_fail (self != NULL, -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_IS_DICT), -EINVAL);
   g_return_val_if_fail (!(self->flags & FLAG_NO_OWNERSHIP), -EINVAL);
+  g_return_val_if_fail (!(self->flags & FLAG_IMMUTABLE), -EINVAL);
+  g_return_val_if_fail (key != NULL, -EINVAL);
 
-  return pw_properties_setva (self->props, key, format, args);
+  /* a NULL format removes the key, like in pw_properties_setva() */
+  g_autofree gchar *value = format ? g_strdup_vprintf (format, args) : NULL;
+  return wp_properties_set_internal (self, key, value);
 }
 
 struct _WpPropertiesItem
@@ -894,6 +1398,36 @@ wp_properties_new_iterator (WpProperties * self)
   return g_steal_pointer (&it);
 }
 
+/*!
+ * \brief Calls \a func for every property in the properties object
+ *
+ * Unlike wp_properties_new_iterator(), this does not allocate anything;
+ * the key and value strings are passed directly from the internal storage.
+ * \a self must not be modified while iterating.
+ *
+ * \ingroup wpproperties
+ * \param self a properties object
+ * \param func (scope call): the function to call for each property
+ * \param data (closure): data to pass to \a func
+ * \returns TRUE if all the properties were iterated, FALSE if \a func
+ *   stopped the iteration
+ */
+gboolean
+wp_properties_foreach (WpProperties * self, WpPropertiesForeachFunc func,
+    gpointer data)
+{
+  const struct spa_dict_item *item;
+
+  g_return_val_if_fail (self != NULL, FALSE);
+  g_return_val_if_fail (func != NULL, FALSE);
+
+  spa_dict_for_each (item, wp_properties_peek_dict (self)) {
+    if (!func (item->key, item->value, data))
+      return FALSE;
+  }
+  return TRUE;
+}
+
 /*!
  * \brief Gets the key from a properties iterator item
  *
@@ -955,7 +1489,11 @@ wp_properties_sort (WpProperties * self)
   g_return_if_fail (self != NULL);
   g_return_if_fail (!(self->flags & FLAG_IS_DICT));
   g_return_if_fail (!(self->flags & FLAG_NO_OWNERSHIP));
+  g_return_if_fail (!(self->flags & FLAG_IMMUTABLE));
 
+  wp_properties_unshare (self);
+  g_clear_pointer (&self->index, g_hash_table_unref);
+  g_clear_pointer (&self->key_slots, g_free);
   return spa_dict_qsort (&self->props->dict);
 }
 
@@ -971,7 +1509,8 @@ wp_properties_peek_dict (WpProperties * self)
 {
   g_return_val_if_fail (self != NULL, NULL);
 
-  return (self->flags & FLAG_IS_DICT) ? self->dict : &self->props->dict;
+  return (self->flags & (FLAG_IS_DICT | FLAG_INTERNED)) ?
+      self->dict : &self->props->dict;
 }
 
 /*!
@@ -1009,8 +1548,13 @@ wp_properties_unref_and_take_pw_properties (WpProperties * self)
   g_return_val_if_fail (self != NULL, NULL);
 
   g_autoptr (WpProperties) unique = wp_properties_ensure_unique_owner (self);
+  wp_properties_unshare (unique);
   /* set the flag so that unref-ing \a unique will not destroy unique->props */
   unique->flags = FLAG_NO_OWNERSHIP;
+  g_clear_pointer (&unique->index, g_hash_table_unref);
+  /* the caller may append to it with pw_properties_set(), which does not
+     know about the sorted flag and would leave it stale */
+  unique->props->dict.flags &= ~SPA_DICT_FLAG_SORTED;
   return unique->props;
 }
 
@@ -1049,3 +1593,253 @@ wp_properties_matches (WpProperties * self, WpProperties *other)
 
   return TRUE;
 }
+
+/*!
+ * \brief Compares two properties sets and reports the properties that
+ * were added, changed or removed in \a new_props, compared to \a old_props
+ *
+ * \a func is called first for the added and changed properties, in the order
+ * of \a new_props, and then for the removed properties, in the order of
+ * \a old_props. Either of the sets may be NULL, which is the same as
+ * an empty set.
+ *
+ * \ingroup wpproperties
+ * \param old_props (nullable): the old properties set
+ * \param new_props (nullable): the new properties set
+ * \param func (scope call) (nullable): the function to call for each
+ *   property that differs
+ * \param data (closure): data to pass to \a func
+ * \returns the number of properties that differ
+ */
+guint
+wp_properties_diff (WpProperties * old_props, WpProperties * new_props,
+    WpPropertiesDiffFunc func, gpointer data)
+{
+  const struct spa_dict_item *item;
+  const gchar *value;
+  guint n_diffs = 0;
+
+  if (old_props == new_props)
+    return 0;
+
+  if (new_props) {
+    spa_dict_for_each (item, wp_properties_peek_dict (new_props)) {
+      value = old_props ? wp_properties_get (old_props, item->key) : NULL;
+      if (!g_strcmp0 (value, item->value))
+        continue;
+      if (func)
+        func (item->key, value, item->value, data);
+      n_diffs++;
+    }
+  }
+
+  if (old_props) {
+    spa_dict_for_each (item, wp_properties_peek_dict (old_props)) {
+      if (new_props && wp_properties_get (new_props, item->key))
+        continue;
+      if (func)
+        func (item->key, item->value, NULL, data);
+      n_diffs++;
+    }
+  }
+
+  return n_diffs;
+}
+
+/*!
+ * \struct WpPropertiesBuilder
+ *
+ * WpPropertiesBuilder constructs a WpProperties object from many key-value
+ * pairs at once. Unlike calling wp_properties_set() repeatedly, adding a
+ * pair to the builder does not check whether the key already exists. All the
+ * pairs are sorted and de-duplicated once, when the properties object is
+ * created with wp_properties_builder_end(). If a key was added more than once,
+ * the value that was added last is kept.
+ *
+ * The resulting properties object is sorted by key.
+ */
+
+struct builder_item
+{
+  const gchar *key;
+  const gchar *value;
+  guint seq;
+};
+
+struct _WpPropertiesBuilder
+{
+  GStringChunk *strings;
+  GArray *items; /* element-type: struct builder_item */
+};
+
+/*!
+ * \brief Creates a new properties builder
+ *
+ * \ingroup wpproperties
+ * \param n_items the number of items that are expected to be added;
+ *   this is only a hint to allocate enough space in advance
+ * \returns (transfer full): the new builder
+ */
+WpPropertiesBuilder *
+wp_properties_builder_new (guint n_items)
+{
+  WpPropertiesBuilder *self = g_slice_new0 (WpPropertiesBuilder);
+  self->strings = g_string_chunk_new (MAX (n_items, 16) * 32);
+  self->items = g_array_sized_new (FALSE, FALSE, sizeof (struct builder_item),
+      n_items);
+  return self;
+}
+
+/*!
+ * \brief Adds a key-value pair to the builder
+ *
+ * Pairs with an empty key or a NULL value are ignored.
+ *
+ * \ingroup wpproperties
+ * \param self the builder
+ * \param key a property key
+ * \param value (nullable): a property value
+ */
+void
+wp_properties_builder_add (WpPropertiesBuilder * self, const gchar * key,
+    const gchar * value)
+{
+  struct builder_item item;
+
+  g_return_if_fail (self != NULL);
+  g_return_if_fail (key != NULL);
+
+  if (!key[0] || !value)
+    return;
+
+  item.key = g_string_chunk_insert (self->strings, key);
+  item.value = g_string_chunk_insert (self->strings, value);
+  item.seq = self->items->len;
+  g_array_append_val (self->items, item);
+}
+
+/*!
+ * \brief Adds all the key-value pairs of \a dict to the builder
+ *
+ * \ingroup wpproperties
+ * \param self the builder
+ * \param dict a `spa_dict` with the pairs to add
+ */
+void
+wp_properties_builder_add_dict (WpPropertiesBuilder * self,
+    const struct spa_dict * dict)
+{
+  const struct spa_dict_item *item;
+
+  g_return_if_fail (self != NULL);
+  g_return_if_fail (dict != NULL);
+
+  spa_dict_for_each (item, dict) {
+    if (item->key)
+      wp_properties_builder_add (self, item->key, item->value);
+  }
+}
+
+static gint
+builder_item_compare (gconstpointer a, gconstpointer b)
+{
+  const struct builder_item *ia = a, *ib = b;
+  gint res = strcmp (ia->key, ib->key);
+  if (res == 0)
+    res = (ia->seq < ib->seq) ? -1 : 1;
+  return res;
+}
+
+static WpProperties *
+wp_properties_builder_finish (WpPropertiesBuilder * self, gboolean intern)
+{
+  g_autoptr (WpPropertiesBuilder) builder = self;
+  g_autofree struct spa_dict_item *items = NULL;
+  struct spa_dict dict;
+  struct pw_properties *props;
+  guint n_items = 0;
+
+  g_array_sort (self->items, builder_item_compare);
+
+  /* keep the last added value of every key */
+  items = g_new (struct spa_dict_item, self->items->len);
+  for (guint i = 0; i < self->items->len; i++) {
+    struct builder_item *item =
+        &g_array_index (self->items, struct builder_item, i);
+
+    if (n_items > 0 && !strcmp (items[n_items - 1].key, item->key))
+      n_items--;
+    items[n_items++] = SPA_DICT_ITEM_INIT (item->key, item->value);
+  }
+
+  dict = SPA_DICT_INIT (items, n_items);
+  dict.flags = SPA_DICT_FLAG_SORTED;
+  if (intern)
+    return wp_properties_new_intern_dict (&dict);
+
+  props = pw_properties_new_dict (&dict);
+  props->dict.flags |= SPA_DICT_FLAG_SORTED;
+  return wp_properties_new_take (props);
+}
+
+/*!
+ * \brief Constructs the properties object and frees the builder
+ *
+ * \ingroup wpproperties
+ * \param self (transfer full): the builder
+ * \returns (transfer full): the new properties object, sorted by key
+ */
+WpProperties *
+wp_properties_builder_end (WpPropertiesBuilder * self)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+  return wp_properties_builder_finish (self, FALSE);
+}
+
+/*!
+ * \brief Same as wp_properties_builder_end(), but the properties are stored
+ * in the pool of interned strings, like with wp_properties_new_intern_dict()
+ *
+ * \ingroup wpproperties
+ * \param self (transfer full): the builder
+ * \returns (transfer full): the new properties object, sorted by key
+ */
+WpProperties *
+wp_properties_builder_end_intern (WpPropertiesBuilder * self)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+  return wp_properties_builder_finish (self, TRUE);
+}
+
+/*!
+ * \brief Frees a builder without constructing a properties object
+ *
+ * \ingroup wpproperties
+ * \param self (transfer full): the builder
+ */
+void
+wp_properties_builder_free (WpPropertiesBuilder * self)
+{
+  g_return_if_fail (self != NULL);
+
+  g_string_chunk_free (self->strings);
+  g_array_unref (self->items);
+  g_slice_free (WpPropertiesBuilder, self);
+}
+
+/*!
+ * \brief Gets the current statistics of the pool of interned strings that is
+ * used by wp_properties_new_intern_dict()
+ *
+ * \ingroup wpproperties
+ * \param stats (out caller-allocates): the location to store the statistics
+ */
+void
+wp_properties_get_pool_stats (WpPropertiesPoolStats * stats)
+{
+  g_return_if_fail (stats != NULL);
+
+  G_LOCK (string_pool);
+  *stats = string_pool_stats;
+  G_UNLOCK (string_pool);
+}
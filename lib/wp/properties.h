@@ -55,6 +55,9 @@ WpProperties * wp_properties_new_wrap_dict (const struct spa_dict * dict);
 WP_API
 WpProperties * wp_properties_new_copy_dict (const struct spa_dict * dict);
 
+WP_API
+WpProperties * wp_properties_new_intern_dict (const struct spa_dict * dict);
+
 WP_API
 WpProperties * wp_properties_copy (WpProperties * other);
 
@@ -120,6 +123,45 @@ gint wp_properties_add_keys_array (WpProperties * self, WpProperties * props,
 WP_API
 const gchar * wp_properties_get (WpProperties * self, const gchar * key);
 
+/*!
+ * \brief Atoms of well-known property keys
+ *
+ * These can be used with wp_properties_get_by_atom() to look up frequently
+ * used properties without comparing strings.
+ *
+ * \ingroup wpproperties
+ */
+typedef enum { /*< prefix=WP_PROP_KEY >*/
+  WP_PROP_KEY_NONE = 0, /*!< not a well-known key */
+  WP_PROP_KEY_OBJECT_ID, /*!< PW_KEY_OBJECT_ID */
+  WP_PROP_KEY_OBJECT_PATH, /*!< PW_KEY_OBJECT_PATH */
+  WP_PROP_KEY_NODE_ID, /*!< PW_KEY_NODE_ID */
+  WP_PROP_KEY_NODE_NAME, /*!< PW_KEY_NODE_NAME */
+  WP_PROP_KEY_NODE_DESCRIPTION, /*!< PW_KEY_NODE_DESCRIPTION */
+  WP_PROP_KEY_MEDIA_CLASS, /*!< PW_KEY_MEDIA_CLASS */
+  WP_PROP_KEY_MEDIA_TYPE, /*!< PW_KEY_MEDIA_TYPE */
+  WP_PROP_KEY_MEDIA_CATEGORY, /*!< PW_KEY_MEDIA_CATEGORY */
+  WP_PROP_KEY_MEDIA_ROLE, /*!< PW_KEY_MEDIA_ROLE */
+  WP_PROP_KEY_DEVICE_ID, /*!< PW_KEY_DEVICE_ID */
+  WP_PROP_KEY_DEVICE_NAME, /*!< PW_KEY_DEVICE_NAME */
+  WP_PROP_KEY_DEVICE_API, /*!< PW_KEY_DEVICE_API */
+  WP_PROP_KEY_PORT_NAME, /*!< PW_KEY_PORT_NAME */
+  WP_PROP_KEY_PORT_DIRECTION, /*!< PW_KEY_PORT_DIRECTION */
+  WP_PROP_KEY_CLIENT_ID, /*!< PW_KEY_CLIENT_ID */
+  WP_PROP_KEY_APP_NAME, /*!< PW_KEY_APP_NAME */
+  WP_PROP_KEY_FACTORY_NAME, /*!< PW_KEY_FACTORY_NAME */
+  WP_PROP_KEY_PRIORITY_SESSION, /*!< PW_KEY_PRIORITY_SESSION */
+} WpPropKey;
+
+WP_API
+WpPropKey wp_prop_key_from_string (const gchar * key);
+
+WP_API
+const gchar * wp_prop_key_to_string (WpPropKey key);
+
+WP_API
+const gchar * wp_properties_get_by_atom (WpProperties * self, WpPropKey key);
+
 WP_API
 gint wp_properties_set (WpProperties * self, const gchar * key,
     const gchar * value);
@@ -157,6 +199,21 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC (WpPropertiesItem, wp_properties_item_unref)
 WP_API
 WpIterator * wp_properties_new_iterator (WpProperties * self);
 
+/*!
+ * \brief A function that is called by wp_properties_foreach()
+ * \param key the property key
+ * \param value the property value
+ * \param data the data passed to wp_properties_foreach()
+ * \returns TRUE if the iteration should continue, FALSE if it should stop
+ * \ingroup wpproperties
+ */
+typedef gboolean (*WpPropertiesForeachFunc) (const gchar * key,
+    const gchar * value, gpointer data);
+
+WP_API
+gboolean wp_properties_foreach (WpProperties * self,
+    WpPropertiesForeachFunc func, gpointer data);
+
 WP_API
 G_DEPRECATED_FOR(wp_properties_item_get_key)
 const gchar * wp_properties_iterator_item_get_key (const GValue * item);
@@ -188,11 +245,79 @@ WP_API
 struct pw_properties * wp_properties_unref_and_take_pw_properties (
     WpProperties * self);
 
+/* builder */
+
+typedef struct _WpPropertiesBuilder WpPropertiesBuilder;
+
+WP_API
+WpPropertiesBuilder * wp_properties_builder_new (guint n_items);
+
+WP_API
+void wp_properties_builder_add (WpPropertiesBuilder * self, const gchar * key,
+    const gchar * value);
+
+WP_API
+void wp_properties_builder_add_dict (WpPropertiesBuilder * self,
+    const struct spa_dict * dict);
+
+WP_API
+WpProperties * wp_properties_builder_end (WpPropertiesBuilder * self);
+
+WP_API
+WpProperties * wp_properties_builder_end_intern (WpPropertiesBuilder * self);
+
+WP_API
+void wp_properties_builder_free (WpPropertiesBuilder * self);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (WpPropertiesBuilder, wp_properties_builder_free)
+
 /* comparison */
 
 WP_API
 gboolean wp_properties_matches (WpProperties * self, WpProperties *other);
 
+/*!
+ * \brief A function that is called by wp_properties_diff() for every property
+ *   that differs between the two sets
+ * \param key the property key
+ * \param old_value (nullable): the value in the old set, or NULL if the
+ *   property was added
+ * \param new_value (nullable): the value in the new set, or NULL if the
+ *   property was removed
+ * \param data the data passed to wp_properties_diff()
+ * \ingroup wpproperties
+ */
+typedef void (*WpPropertiesDiffFunc) (const gchar * key,
+    const gchar * old_value, const gchar * new_value, gpointer data);
+
+WP_API
+guint wp_properties_diff (WpProperties * old_props, WpProperties * new_props,
+    WpPropertiesDiffFunc func, gpointer data);
+
+/* string pool */
+
+typedef struct _WpPropertiesPoolStats WpPropertiesPoolStats;
+
+/*!
+ * \brief Statistics of the pool of interned property strings
+ * \ingroup wpproperties
+ */
+struct _WpPropertiesPoolStats
+{
+  /*! the number of distinct strings in the pool */
+  guint n_strings;
+  /*! the number of references to these strings */
+  guint n_refs;
+  /*! the number of bytes used by the distinct strings */
+  gsize size;
+  /*! the number of bytes that separate copies of the strings would use
+      in addition to \a size */
+  gsize saved;
+};
+
+WP_API
+void wp_properties_get_pool_stats (WpPropertiesPoolStats * stats);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC (WpProperties, wp_properties_unref)
 
 G_END_DECLS
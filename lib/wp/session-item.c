@@ -69,7 +69,10 @@ wp_session_item_default_reset (WpSessionItem * self)
 {
   WpSessionItemPrivate *priv = wp_session_item_get_instance_private (self);
 
-  g_clear_pointer (&priv->properties, wp_properties_unref);
+  if (priv->properties) {
+    g_clear_pointer (&priv->properties, wp_properties_unref);
+    g_object_notify (G_OBJECT (self), "properties");
+  }
 }
 
 static void
@@ -428,6 +431,8 @@ wp_session_item_set_properties (WpSessionItem * self,
   priv = wp_session_item_get_instance_private (self);
   g_clear_pointer (&priv->properties, wp_properties_unref);
   priv->properties = wp_properties_ensure_unique_owner (props);
+
+  g_object_notify (G_OBJECT (self), "properties");
 }
 
 static gboolean
@@ -297,6 +297,22 @@ wp_state_clear (WpState *self)
     wp_warning ("failed to remove %s: %s", self->location, g_strerror (errno));
 }
 
+struct save_data
+{
+  WpState *self;
+  GKeyFile *keyfile;
+};
+
+static gboolean
+save_property (const gchar * key, const gchar * val, gpointer data)
+{
+  struct save_data *sd = data;
+  g_autofree gchar *escaped_key = escape_string (key);
+  if (escaped_key)
+    g_key_file_set_string (sd->keyfile, sd->self->name, escaped_key, val);
+  return TRUE;
+}
+
 /*!
  * \brief Saves new properties in the state, overwriting all previous data.
  * \ingroup wpstate
@@ -309,8 +325,7 @@ gboolean
 wp_state_save (WpState *self, WpProperties *props, GError ** error)
 {
   g_autoptr (GKeyFile) keyfile = g_key_file_new ();
-  g_autoptr (WpIterator) it = NULL;
-  g_auto (GValue) item = G_VALUE_INIT;
+  struct save_data sd = { self, keyfile };
   GError *err = NULL;
 
   g_return_val_if_fail (WP_IS_STATE (self), FALSE);
@@ -320,16 +335,7 @@ wp_state_save (WpState *self, WpProperties *props, GError ** error)
   wp_info_object (self, "saving state into %s", self->location);
 
   /* Set the properties */
-  for (it = wp_properties_new_iterator (props);
-      wp_iterator_next (it, &item);
-      g_value_unset (&item)) {
-    WpPropertiesItem *pi = g_value_get_boxed (&item);
-    const gchar *key = wp_properties_item_get_key (pi);
-    const gchar *val = wp_properties_item_get_value (pi);
-    g_autofree gchar *escaped_key = escape_string (key);
-    if (escaped_key)
-      g_key_file_set_string (keyfile, self->name, escaped_key, val);
-  }
+  wp_properties_foreach (props, save_property, &sd);
 
   if (!g_key_file_save_to_file (keyfile, self->location, &err)) {
     g_propagate_prefixed_error (error, err, "could not save %s: ", self->name);
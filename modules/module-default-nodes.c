@@ -21,6 +21,9 @@
 #define DEFAULT_ECHO_CANCEL_SOURCE_NAME "echo-cancel-source"
 #define N_PREV_CONFIGS 16
 
+/* nodes are looked at in descending order of priority */
+static const gchar * const NODE_SORT_KEYS[] = { PW_KEY_PRIORITY_SESSION, NULL };
+
 enum {
   PROP_0,
   PROP_SAVE_INTERVAL_MS,
@@ -265,29 +268,56 @@ find_best_media_class_node (WpDefaultNodes * self, const gchar *media_class,
   g_autoptr (WpIterator) it = NULL;
   g_auto (GValue) val = G_VALUE_INIT;
   gint highest_prio = 0;
+  gint max_bonus = 0;
   WpNode *res = NULL;
 
   g_return_val_if_fail (media_class, NULL);
 
-  it = wp_object_manager_new_filtered_iterator (self->rescan_om, WP_TYPE_NODE,
-      WP_CONSTRAINT_TYPE_PW_PROPERTY, PW_KEY_MEDIA_CLASS, "=s", media_class,
-      NULL);
+  /* the most that echo-cancel and the configured names can add to the
+     priority of a node */
+  if (self->auto_echo_cancel)
+    max_bonus += 10000;
+  if (def->config_value) {
+    max_bonus += 20000 * (N_PREV_CONFIGS + 1);
+  } else {
+    for (gint i = 0; i < N_PREV_CONFIGS; ++i) {
+      if (def->prev_config_value[i]) {
+        max_bonus += (N_PREV_CONFIGS - i) * 20000;
+        break;
+      }
+    }
+  }
+
+  it = wp_object_manager_new_sorted_iterator (self->rescan_om,
+      WP_CONSTRAINT_TYPE_PW_PROPERTY, NODE_SORT_KEYS,
+      WP_SORTED_VIEW_FLAG_INTEGER,
+      wp_object_interest_new (WP_TYPE_NODE,
+          WP_CONSTRAINT_TYPE_PW_PROPERTY, PW_KEY_MEDIA_CLASS, "=s", media_class,
+          NULL));
 
   for (; wp_iterator_next (it, &val); g_value_unset (&val)) {
     WpNode *node = g_value_get_object (&val);
-    g_autoptr (WpPort) port = wp_object_manager_lookup (self->rescan_om,
+    const gchar *name = wp_pipewire_object_get_property (
+        WP_PIPEWIRE_OBJECT (node), PW_KEY_NODE_NAME);
+    const gchar *prio_str = wp_pipewire_object_get_property (
+        WP_PIPEWIRE_OBJECT (node), PW_KEY_PRIORITY_SESSION);
+    gint prio = prio_str ? atoi (prio_str) : -1;
+    g_autoptr (WpPort) port = NULL;
+
+    /* the view parses the priorities like atoi() does, so nodes come in
+       descending order of priority (missing is sorted as 0); once a node
+       cannot win even with all the bonuses, neither can any of the
+       remaining ones */
+    if (res && MAX (prio, 0) + max_bonus <= highest_prio)
+      break;
+
+    port = wp_object_manager_lookup (self->rescan_om,
           WP_TYPE_PORT, WP_CONSTRAINT_TYPE_PW_PROPERTY, PW_KEY_NODE_ID,
           "=u", wp_proxy_get_bound_id (WP_PROXY (node)),
           WP_CONSTRAINT_TYPE_PW_PROPERTY, PW_KEY_PORT_DIRECTION,
           "=s", direction == WP_DIRECTION_INPUT ? "in" : "out",
           NULL);
     if (port) {
-      const gchar *name = wp_pipewire_object_get_property (
-          WP_PIPEWIRE_OBJECT (node), PW_KEY_NODE_NAME);
-      const gchar *prio_str = wp_pipewire_object_get_property (
-          WP_PIPEWIRE_OBJECT (node), PW_KEY_PRIORITY_SESSION);
-      gint prio = prio_str ? atoi (prio_str) : -1;
-
       if (!node_has_available_routes (self, node))
         continue;
 
@@ -522,6 +552,9 @@ on_metadata_added (WpObjectManager *om, WpMetadata *metadata, gpointer d)
   wp_object_manager_add_interest (self->rescan_om, WP_TYPE_DEVICE, NULL);
   wp_object_manager_add_interest (self->rescan_om, WP_TYPE_NODE, NULL);
   wp_object_manager_add_interest (self->rescan_om, WP_TYPE_PORT, NULL);
+  wp_object_manager_add_sorted_view (self->rescan_om,
+      WP_CONSTRAINT_TYPE_PW_PROPERTY, NODE_SORT_KEYS,
+      WP_SORTED_VIEW_FLAG_INTEGER);
   wp_object_manager_request_object_features (self->rescan_om, WP_TYPE_DEVICE,
       WP_OBJECT_FEATURES_ALL);
   wp_object_manager_request_object_features (self->rescan_om, WP_TYPE_NODE,
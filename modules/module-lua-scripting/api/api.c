@@ -712,21 +712,227 @@ object_interest_matches (lua_State *L)
   if (wplua_isobject (L, 2, G_TYPE_OBJECT)) {
     matches = wp_object_interest_matches (interest, wplua_toobject (L, 2));
   }
-  else if (lua_istable (L, 2)) {
-    g_autoptr (WpProperties) props = wplua_table_to_properties (L, 2);
+  else if (lua_istable (L, 2) || wplua_isboxed (L, 2, WP_TYPE_PROPERTIES)) {
+    g_autoptr (WpProperties) props = wplua_checkproperties (L, 2);
     matches = wp_object_interest_matches (interest, props);
   } else
-    luaL_argerror (L, 2, "expected GObject or table");
+    luaL_argerror (L, 2, "expected GObject, Properties or table");
 
   lua_pushboolean (L, matches);
   return 1;
 }
 
+static int
+object_interest_explain (lua_State *L)
+{
+  WpObjectInterest *interest = wplua_checkboxed (L, 1, WP_TYPE_OBJECT_INTEREST);
+  g_autofree gchar *explanation = NULL;
+
+  if (wplua_isobject (L, 2, G_TYPE_OBJECT)) {
+    explanation = wp_object_interest_explain (interest, wplua_toobject (L, 2));
+  }
+  else if (lua_istable (L, 2) || wplua_isboxed (L, 2, WP_TYPE_PROPERTIES)) {
+    g_autoptr (WpProperties) props = wplua_checkproperties (L, 2);
+    explanation = wp_object_interest_explain (interest, props);
+  } else
+    luaL_argerror (L, 2, "expected GObject, Properties or table");
+
+  lua_pushstring (L, explanation);
+  return 1;
+}
+
+static int
+object_interest_get_stats (lua_State *L)
+{
+  WpObjectInterest *interest = wplua_checkboxed (L, 1, WP_TYPE_OBJECT_INTEREST);
+  WpObjectInterestStats stats;
+
+  wp_object_interest_get_stats (interest, &stats);
+  lua_createtable (L, 0, 6);
+  lua_pushinteger (L, stats.n_evaluations);
+  lua_setfield (L, -2, "evaluations");
+  lua_pushinteger (L, stats.n_matches);
+  lua_setfield (L, -2, "matches");
+  lua_pushinteger (L, stats.n_type_rejects);
+  lua_setfield (L, -2, "type_rejects");
+  lua_pushinteger (L, stats.time_ns);
+  lua_setfield (L, -2, "time_ns");
+  lua_pushinteger (L, stats.top_reject_constraint);
+  lua_setfield (L, -2, "top_reject_constraint");
+  lua_pushinteger (L, stats.n_top_rejects);
+  lua_setfield (L, -2, "top_rejects");
+  return 1;
+}
+
+static int
+object_interest_reset_stats (lua_State *L)
+{
+  WpObjectInterest *interest = wplua_checkboxed (L, 1, WP_TYPE_OBJECT_INTEREST);
+  wp_object_interest_reset_stats (interest);
+  return 0;
+}
+
 static const luaL_Reg object_interest_methods[] = {
   { "matches", object_interest_matches },
+  { "explain", object_interest_explain },
+  { "get_stats", object_interest_get_stats },
+  { "reset_stats", object_interest_reset_stats },
   { NULL, NULL }
 };
 
+/*
+ * Scripts often pass the interest as an inline table to iterate() & co, in
+ * loops, ex. om:iterate { type = "node", Constraint { "node.id", "=", id } }
+ * To avoid building, validating and compiling a new interest every time,
+ * interests are cached by a key that describes the contents of the table.
+ */
+
+#define INTEREST_CACHE_MAX_SIZE 256
+
+/* address used as the registry key of the interests cache */
+static const gchar interest_cache_key = 0;
+
+struct interest_key
+{
+  gchar str[512];
+  gsize len;
+};
+
+static gboolean
+interest_key_append (struct interest_key *key, gchar tag, const gchar *str,
+    gsize len)
+{
+  /* "<tag><len>:<str>" is unambiguous, regardless of the contents of str */
+  gint n = g_snprintf (key->str + key->len, sizeof (key->str) - key->len,
+      "%c%" G_GSIZE_FORMAT ":", tag, len);
+  if (n < 0 || key->len + n + len >= sizeof (key->str))
+    return FALSE;
+  key->len += n;
+  memcpy (key->str + key->len, str, len);
+  key->len += len;
+  key->str[key->len] = '\0';
+  return TRUE;
+}
+
+static gboolean
+interest_key_append_value (lua_State *L, int idx, struct interest_key *key)
+{
+  switch (lua_type (L, idx)) {
+  case LUA_TNUMBER:
+    if (!lua_isinteger (L, idx)) {
+      /* lua_tolstring() formats floats with "%.14g", which gives the same
+         key to numbers that differ in the last digits; "%.17g" does not */
+      gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+      g_ascii_formatd (buf, sizeof (buf), "%.17g", lua_tonumber (L, idx));
+      return interest_key_append (key, 'd', buf, strlen (buf));
+    }
+    /* fall through */
+  case LUA_TSTRING: {
+    gchar tag = (lua_type (L, idx) == LUA_TSTRING) ? 's' : 'i';
+    gsize len;
+    /* idx is a copy, so converting numbers to strings in place is fine */
+    const gchar *str = lua_tolstring (L, idx, &len);
+    return interest_key_append (key, tag, str, len);
+  }
+  case LUA_TBOOLEAN:
+    return interest_key_append (key, 'b',
+        lua_toboolean (L, idx) ? "1" : "0", 1);
+  case LUA_TNIL:
+    return interest_key_append (key, 'n', "", 0);
+  default:
+    return FALSE;
+  }
+}
+
+/* returns FALSE if the table cannot be described by a key; in this case,
+   building the interest the normal way will also report the error */
+static gboolean
+make_interest_key (lua_State *L, int idx, GType def_type,
+    struct interest_key *key)
+{
+  const gchar *def_type_name = g_type_name (def_type);
+  gboolean ret = TRUE;
+  int top = lua_gettop (L);
+
+  key->len = 0;
+  key->str[0] = '\0';
+
+  lua_getfield (L, idx, "type");
+  ret = interest_key_append_value (L, -1, key) &&
+      interest_key_append (key, 'g', def_type_name, strlen (def_type_name));
+  lua_pop (L, 1);
+
+  lua_pushnil (L);
+  while (ret && lua_next (L, idx)) {
+    int constraint_idx = lua_absindex (L, -1);
+
+    if (lua_type (L, -2) == LUA_TSTRING &&
+        !g_strcmp0 ("type", lua_tostring (L, -2))) {
+      lua_pop (L, 1);
+      continue;
+    }
+
+    /* only Constraint{} tables are valid */
+    if (lua_type (L, constraint_idx) != LUA_TTABLE ||
+        luaL_getmetafield (L, constraint_idx, "__name") != LUA_TSTRING ||
+        g_strcmp0 (lua_tostring (L, -1), "Constraint") != 0) {
+      ret = FALSE;
+      break;
+    }
+    lua_pop (L, 1);
+
+    /* the constraint's type and all of its array items */
+    lua_getfield (L, constraint_idx, "type");
+    ret = interest_key_append_value (L, -1, key) &&
+        interest_key_append (key, 'c', "", 0);
+    for (lua_Integer i = 1; ret && lua_geti (L, constraint_idx, i) != LUA_TNIL;
+         i++) {
+      ret = interest_key_append_value (L, -1, key);
+    }
+    lua_settop (L, constraint_idx - 1);
+  }
+
+  lua_settop (L, top);
+  return ret;
+}
+
+static WpObjectInterest *
+get_cached_object_interest (lua_State *L, int idx, GType def_type)
+{
+  struct interest_key key;
+  GHashTable *cache;
+  WpObjectInterest *interest;
+
+  if (lua_rawgetp (L, LUA_REGISTRYINDEX, &interest_cache_key) == LUA_TNIL) {
+    lua_pop (L, 1);
+    cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) wp_object_interest_unref);
+    wplua_pushboxed (L, G_TYPE_HASH_TABLE, cache);
+    lua_pushvalue (L, -1);
+    lua_rawsetp (L, LUA_REGISTRYINDEX, &interest_cache_key);
+  }
+  cache = wplua_toboxed (L, -1);
+  lua_pop (L, 1);
+
+  if (!make_interest_key (L, idx, def_type, &key)) {
+    object_interest_new_index (L, idx, def_type);
+    return wplua_toboxed (L, -1);
+  }
+
+  if ((interest = g_hash_table_lookup (cache, key.str)))
+    return interest;
+
+  /* raises an error if the table is not a valid interest */
+  object_interest_new_index (L, idx, def_type);
+  interest = wplua_toboxed (L, -1);
+
+  if (g_hash_table_size (cache) >= INTEREST_CACHE_MAX_SIZE)
+    g_hash_table_remove_all (cache);
+  g_hash_table_insert (cache, g_strndup (key.str, key.len),
+      wp_object_interest_ref (interest));
+  return interest;
+}
+
 static WpObjectInterest *
 get_optional_object_interest (lua_State *L, int idx, GType def_type)
 {
@@ -735,8 +941,7 @@ get_optional_object_interest (lua_State *L, int idx, GType def_type)
   else if (lua_isuserdata (L, idx))
     return wplua_checkboxed (L, idx, WP_TYPE_OBJECT_INTEREST);
   else if (lua_istable (L, idx)) {
-    object_interest_new_index (L, idx, def_type);
-    return wplua_toboxed (L, -1);
+    return get_cached_object_interest (L, lua_absindex (L, idx), def_type);
   } else {
     luaL_error (L, "expected Interest or none/nil");
     return NULL;
@@ -759,9 +964,19 @@ object_manager_new (lua_State *L)
 
   lua_pushnil (L);
   while (lua_next (L, 1)) {
-    WpObjectInterest *interest =
-        wplua_checkboxed (L, -1, WP_TYPE_OBJECT_INTEREST);
-    wp_object_manager_add_interest_full (om, wp_object_interest_ref (interest));
+    /* named fields are options, the rest are interests */
+    if (lua_type (L, -2) == LUA_TSTRING) {
+      const gchar *key = lua_tostring (L, -2);
+      if (!g_strcmp0 (key, "passive"))
+        wp_object_manager_set_passive (om, lua_toboolean (L, -1));
+      else
+        luaL_error (L, "ObjectManager: unknown option '%s'", key);
+    } else {
+      WpObjectInterest *interest =
+          wplua_checkboxed (L, -1, WP_TYPE_OBJECT_INTEREST);
+      wp_object_manager_add_interest_full (om,
+          wp_object_interest_ref (interest));
+    }
     lua_pop (L, 1);
   }
 
@@ -788,6 +1003,102 @@ object_manager_get_n_objects (lua_State *L)
   return 1;
 }
 
+static void
+push_object_list (lua_State *L, GPtrArray *objects)
+{
+  lua_createtable (L, (int) objects->len, 0);
+  for (guint i = 0; i < objects->len; i++) {
+    wplua_pushobject (L, g_object_ref (g_ptr_array_index (objects, i)));
+    lua_rawseti (L, -2, i + 1);
+  }
+}
+
+static int
+object_manager_get_pending_changes (lua_State *L)
+{
+  WpObjectManager *om = wplua_checkobject (L, 1, WP_TYPE_OBJECT_MANAGER);
+  GPtrArray *added = NULL, *removed = NULL;
+
+  if (!wp_object_manager_get_pending_changes (om, &added, &removed)) {
+    lua_pushnil (L);
+    lua_pushnil (L);
+  } else {
+    push_object_list (L, added);
+    push_object_list (L, removed);
+  }
+  return 2;
+}
+
+static int
+object_manager_add_index (lua_State *L)
+{
+  static const gchar *const types[] = { "pw-global", "pw", "gobject", NULL };
+  WpObjectManager *om = wplua_checkobject (L, 1, WP_TYPE_OBJECT_MANAGER);
+  const gchar *key = luaL_checkstring (L, 2);
+  /* same order as WpConstraintType, starting from PW_GLOBAL_PROPERTY */
+  int type = luaL_checkoption (L, 3, "pw-global", types);
+
+  wp_object_manager_add_index (om,
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY + type, key);
+  return 0;
+}
+
+/* converts the table of property names at idx to a NULL-terminated array */
+static GStrv
+get_sort_keys (lua_State *L, int idx)
+{
+  GStrv keys;
+  lua_Integer n;
+
+  luaL_checktype (L, idx, LUA_TTABLE);
+  n = luaL_len (L, idx);
+  luaL_argcheck (L, n > 0, idx, "expected at least one key");
+
+  /* validate before allocating, luaL_argerror() does not return */
+  for (lua_Integer i = 1; i <= n; i++) {
+    if (lua_geti (L, idx, i) != LUA_TSTRING)
+      luaL_argerror (L, idx, "expected a list of strings");
+    lua_pop (L, 1);
+  }
+
+  keys = g_new0 (gchar *, n + 1);
+  for (lua_Integer i = 1; i <= n; i++) {
+    lua_geti (L, idx, i);
+    keys[i - 1] = g_strdup (lua_tostring (L, -1));
+    lua_pop (L, 1);
+  }
+  return keys;
+}
+
+static int
+object_manager_add_sorted_view (lua_State *L)
+{
+  static const gchar *const types[] = { "pw-global", "pw", "gobject", NULL };
+  WpObjectManager *om = wplua_checkobject (L, 1, WP_TYPE_OBJECT_MANAGER);
+  int type = luaL_checkoption (L, 3, "pw-global", types);
+  g_auto (GStrv) keys = get_sort_keys (L, 2);
+
+  wp_object_manager_add_sorted_view (om,
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY + type,
+      (const gchar * const *) keys, WP_SORTED_VIEW_FLAGS_NONE);
+  return 0;
+}
+
+static int
+object_manager_iterate_sorted (lua_State *L)
+{
+  static const gchar *const types[] = { "pw-global", "pw", "gobject", NULL };
+  WpObjectManager *om = wplua_checkobject (L, 1, WP_TYPE_OBJECT_MANAGER);
+  WpObjectInterest *oi = get_optional_object_interest (L, 3, G_TYPE_OBJECT);
+  int type = luaL_checkoption (L, 4, "pw-global", types);
+  g_auto (GStrv) keys = get_sort_keys (L, 2);
+  WpIterator *it = wp_object_manager_new_sorted_iterator (om,
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY + type,
+      (const gchar * const *) keys, WP_SORTED_VIEW_FLAGS_NONE,
+      oi ? wp_object_interest_ref (oi) : NULL);
+  return push_wpiterator (L, it);
+}
+
 static int
 object_manager_iterate (lua_State *L)
 {
@@ -815,11 +1126,43 @@ object_manager_lookup (lua_State *L)
   return 0;
 }
 
+static int
+object_manager_get_stats (lua_State *L)
+{
+  WpObjectManager *om = wplua_checkobject (L, 1, WP_TYPE_OBJECT_MANAGER);
+  WpObjectManagerStats stats;
+
+  wp_object_manager_get_stats (om, &stats);
+  lua_createtable (L, 0, 3);
+  lua_pushinteger (L, stats.n_evaluations);
+  lua_setfield (L, -2, "evaluations");
+  lua_pushinteger (L, stats.n_matches);
+  lua_setfield (L, -2, "matches");
+  lua_pushinteger (L, stats.time_ns);
+  lua_setfield (L, -2, "time_ns");
+  return 1;
+}
+
+static int
+object_manager_dump_stats (lua_State *L)
+{
+  WpObjectManager *om = wplua_checkobject (L, 1, WP_TYPE_OBJECT_MANAGER);
+  g_autofree gchar *stats = wp_object_manager_dump_stats (om);
+  lua_pushstring (L, stats);
+  return 1;
+}
+
 static const luaL_Reg object_manager_methods[] = {
   { "activate", object_manager_activate },
   { "get_n_objects", object_manager_get_n_objects },
+  { "get_pending_changes", object_manager_get_pending_changes },
+  { "add_index", object_manager_add_index },
+  { "add_sorted_view", object_manager_add_sorted_view },
   { "iterate", object_manager_iterate },
+  { "iterate_sorted", object_manager_iterate_sorted },
   { "lookup", object_manager_lookup },
+  { "get_stats", object_manager_get_stats },
+  { "dump_stats", object_manager_dump_stats },
   { NULL, NULL }
 };
 
@@ -874,8 +1217,7 @@ impl_metadata_new (lua_State *L)
   WpProperties *properties = NULL;
 
   if (lua_type (L, 2) != LUA_TNONE && lua_type (L, 2) != LUA_TNIL) {
-    luaL_checktype (L, 2, LUA_TTABLE);
-    properties = wplua_table_to_properties (L, 2);
+    properties = wplua_checkproperties (L, 2);
   }
 
   WpImplMetadata *m = wp_impl_metadata_new_full (get_wp_core (L),
@@ -900,8 +1242,7 @@ device_new (lua_State *L)
   WpProperties *properties = NULL;
 
   if (lua_type (L, 2) != LUA_TNONE && lua_type (L, 2) != LUA_TNIL) {
-    luaL_checktype (L, 2, LUA_TTABLE);
-    properties = wplua_table_to_properties (L, 2);
+    properties = wplua_checkproperties (L, 2);
   }
 
   WpDevice *d = wp_device_new_from_factory (get_wp_export_core (L),
@@ -920,8 +1261,7 @@ spa_device_new (lua_State *L)
   WpProperties *properties = NULL;
 
   if (lua_type (L, 2) != LUA_TNONE && lua_type (L, 2) != LUA_TNIL) {
-    luaL_checktype (L, 2, LUA_TTABLE);
-    properties = wplua_table_to_properties (L, 2);
+    properties = wplua_checkproperties (L, 2);
   }
 
   WpSpaDevice *d = wp_spa_device_new_from_spa_factory (get_wp_export_core (L),
@@ -978,8 +1318,7 @@ node_new (lua_State *L)
   WpProperties *properties = NULL;
 
   if (lua_type (L, 2) != LUA_TNONE && lua_type (L, 2) != LUA_TNIL) {
-    luaL_checktype (L, 2, LUA_TTABLE);
-    properties = wplua_table_to_properties (L, 2);
+    properties = wplua_checkproperties (L, 2);
   }
 
   WpNode *d = wp_node_new_from_factory (get_wp_export_core (L),
@@ -1087,8 +1426,7 @@ impl_node_new (lua_State *L)
   WpProperties *properties = NULL;
 
   if (lua_type (L, 2) != LUA_TNONE && lua_type (L, 2) != LUA_TNIL) {
-    luaL_checktype (L, 2, LUA_TTABLE);
-    properties = wplua_table_to_properties (L, 2);
+    properties = wplua_checkproperties (L, 2);
   }
 
   WpImplNode *d = wp_impl_node_new_from_pw_factory (get_wp_export_core (L),
@@ -1123,8 +1461,7 @@ link_new (lua_State *L)
   WpProperties *properties = NULL;
 
   if (lua_type (L, 2) != LUA_TNONE && lua_type (L, 2) != LUA_TNIL) {
-    luaL_checktype (L, 2, LUA_TTABLE);
-    properties = wplua_table_to_properties (L, 2);
+    properties = wplua_checkproperties (L, 2);
   }
 
   WpLink *l = wp_link_new_from_factory (get_wp_core (L), factory, properties);
@@ -1249,11 +1586,20 @@ static int
 session_item_configure (lua_State *L)
 {
   WpSessionItem *si = wplua_checkobject (L, 1, WP_TYPE_SESSION_ITEM);
-  WpProperties *props = wp_properties_new_empty ();
+  WpPropertiesBuilder *b = NULL;
+
+  /* read-only properties userdata hold only strings; pass a copy as is */
+  if (wplua_isboxed (L, 2, WP_TYPE_PROPERTIES)) {
+    lua_pushboolean (L, wp_session_item_configure (si,
+            wplua_checkproperties (L, 2)));
+    return 1;
+  }
 
   /* validate arguments */
   luaL_checktype (L, 2, LUA_TTABLE);
 
+  b = wp_properties_builder_new (0);
+
   /* build the configuration properties */
   lua_pushnil (L);
   while (lua_next (L, 2)) {
@@ -1286,11 +1632,12 @@ session_item_configure (lua_State *L)
     }
 
     key = luaL_tolstring (L, -2, NULL);
-    wp_properties_set (props, key, var);
+    wp_properties_builder_add (b, key, var);
     lua_pop (L, 2);
   }
 
-  lua_pushboolean (L, wp_session_item_configure (si, props));
+  lua_pushboolean (L, wp_session_item_configure (si,
+          wp_properties_builder_end (b)));
   return 1;
 }
 
@@ -1406,6 +1753,121 @@ static const luaL_Reg pipewire_object_methods[] = {
   { NULL, NULL }
 };
 
+/* WpProperties */
+
+struct properties_diff_data
+{
+  lua_State *L;
+  int added;
+  int changed;
+  int removed;
+};
+
+static void
+properties_diff_push (const gchar * key, const gchar * old_value,
+    const gchar * new_value, gpointer data)
+{
+  struct properties_diff_data *d = data;
+  int table = !old_value ? d->added : (!new_value ? d->removed : d->changed);
+
+  lua_pushstring (d->L, key);
+  lua_pushstring (d->L, new_value ? new_value : old_value);
+  lua_settable (d->L, table);
+}
+
+static int
+properties_diff (lua_State *L)
+{
+  g_autoptr (WpProperties) old_props = NULL;
+  g_autoptr (WpProperties) new_props = NULL;
+  struct properties_diff_data d = { L, 0, 0, 0 };
+
+  if (!lua_isnoneornil (L, 1)) {
+    old_props = wplua_checkproperties (L, 1);
+  }
+  if (!lua_isnoneornil (L, 2)) {
+    new_props = wplua_checkproperties (L, 2);
+  }
+
+  lua_newtable (L);
+  d.added = lua_gettop (L);
+  lua_newtable (L);
+  d.changed = lua_gettop (L);
+  lua_newtable (L);
+  d.removed = lua_gettop (L);
+
+  wp_properties_diff (old_props, new_props, properties_diff_push, &d);
+  return 3;
+}
+
+static const luaL_Reg properties_funcs[] = {
+  { "diff", properties_diff },
+  { NULL, NULL }
+};
+
+static int
+properties_to_table (lua_State *L)
+{
+  WpProperties *props = wplua_checkboxed (L, 1, WP_TYPE_PROPERTIES);
+  wplua_properties_to_table (L, props);
+  return 1;
+}
+
+static const luaL_Reg properties_methods[] = {
+  { "to_table", properties_to_table },
+  { NULL, NULL }
+};
+
+/* Profiler */
+
+static int
+profiler_start (lua_State *L)
+{
+  gboolean sampling = lua_toboolean (L, 1);
+  wplua_profiler_start (L, sampling ? WP_LUA_PROFILER_SAMPLING : 0);
+  return 0;
+}
+
+static int
+profiler_stop (lua_State *L)
+{
+  wplua_profiler_stop (L);
+  return 0;
+}
+
+static int
+profiler_reset (lua_State *L)
+{
+  wplua_profiler_reset (L);
+  return 0;
+}
+
+static int
+profiler_dump (lua_State *L)
+{
+  gboolean folded = lua_toboolean (L, 1);
+  g_autofree gchar *str = folded ?
+      wplua_profiler_dump_folded (L) : wplua_profiler_dump (L);
+  lua_pushstring (L, str);
+  return 1;
+}
+
+static int
+profiler_get_stats (lua_State *L)
+{
+  wplua_profiler_push_stats (L);
+  return 1;
+}
+
+static const luaL_Reg profiler_funcs[] = {
+  { "start", profiler_start },
+  { "stop", profiler_stop },
+  { "reset", profiler_reset },
+  { "dump", profiler_dump },
+  { "get_stats", profiler_get_stats },
+  { NULL, NULL }
+};
+
 /* WpState */
 
 static int
@@ -1429,8 +1891,7 @@ static int
 state_save (lua_State *L)
 {
   WpState *state = wplua_checkobject (L, 1, WP_TYPE_STATE);
-  luaL_checktype (L, 2, LUA_TTABLE);
-  g_autoptr (WpProperties) props = wplua_table_to_properties (L, 2);
+  g_autoptr (WpProperties) props = wplua_checkproperties (L, 2);
   g_autoptr (GError) error = NULL;
   gboolean saved = wp_state_save (state, props, &error);
   lua_pushboolean (L, saved);
@@ -1468,8 +1929,7 @@ impl_module_new (lua_State *L)
     args = luaL_checkstring (L, 2);
 
   if (lua_type (L, 3) != LUA_TNONE && lua_type (L, 3) != LUA_TNIL) {
-    luaL_checktype (L, 3, LUA_TTABLE);
-    properties = wplua_table_to_properties (L, 3);
+    properties = wplua_checkproperties (L, 3);
   }
 
   bool load_file = false; // Load args as file path
@@ -1515,6 +1975,12 @@ wp_lua_scripting_api_init (lua_State *L)
   luaL_newlib (L, plugin_funcs);
   lua_setglobal (L, "WpPlugin");
 
+  luaL_newlib (L, properties_funcs);
+  lua_setglobal (L, "WpProperties");
+
+  luaL_newlib (L, profiler_funcs);
+  lua_setglobal (L, "WpProfiler");
+
   wp_lua_scripting_pod_init (L);
   wp_lua_scripting_json_init (L);
 
@@ -1526,6 +1992,8 @@ wp_lua_scripting_api_init (lua_State *L)
       NULL, proxy_methods);
   wplua_register_type_methods (L, WP_TYPE_GLOBAL_PROXY,
       NULL, global_proxy_methods);
+  wplua_register_type_methods (L, WP_TYPE_PROPERTIES,
+      NULL, properties_methods);
   wplua_register_type_methods (L, WP_TYPE_OBJECT_INTEREST,
       object_interest_new, object_interest_methods);
   wplua_register_type_methods (L, WP_TYPE_OBJECT_MANAGER,
@@ -196,6 +196,8 @@ SANDBOX_EXPORT = {
   Log = WpLog,
   Core = WpCore,
   Plugin = WpPlugin,
+  Properties = WpProperties,
+  Profiler = WpProfiler,
   ObjectManager = WpObjectManager_new,
   Interest = WpObjectInterest_new,
   SessionItem = WpSessionItem_new,
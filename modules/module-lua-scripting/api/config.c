@@ -133,6 +133,7 @@ wp_lua_scripting_load_configuration (const gchar * conf_file,
   g_auto (GValue) fold_ret = G_VALUE_INIT;
   gint nfiles = 0;
 
+  wplua_enable_bytecode_cache (L, NULL);
   wplua_enable_sandbox (L, 0);
 
   /* load conf_file itself */
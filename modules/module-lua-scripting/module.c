@@ -127,6 +127,7 @@ wp_lua_scripting_plugin_enable (WpPlugin * plugin, WpTransition * transition)
 
   wp_lua_scripting_api_init (self->L);
   wp_lua_scripting_enable_package_searcher (self->L);
+  wplua_enable_bytecode_cache (self->L, NULL);
   wplua_enable_sandbox (self->L, WP_LUA_SANDBOX_ISOLATE_ENV);
 
   /* register scripts that were queued in for loading */
@@ -218,6 +219,37 @@ wp_lua_scripting_plugin_load (WpComponentLoader * cl, const gchar * component,
   g_return_val_if_reached (FALSE);
 }
 
+static void
+wp_lua_scripting_plugin_profiler_start (WpLuaScriptingPlugin * self,
+    gboolean sampling)
+{
+  g_return_if_fail (self->L);
+  wplua_profiler_start (self->L, sampling ? WP_LUA_PROFILER_SAMPLING : 0);
+}
+
+static void
+wp_lua_scripting_plugin_profiler_stop (WpLuaScriptingPlugin * self)
+{
+  g_return_if_fail (self->L);
+  wplua_profiler_stop (self->L);
+}
+
+static void
+wp_lua_scripting_plugin_profiler_reset (WpLuaScriptingPlugin * self)
+{
+  g_return_if_fail (self->L);
+  wplua_profiler_reset (self->L);
+}
+
+static gchar *
+wp_lua_scripting_plugin_profiler_dump (WpLuaScriptingPlugin * self,
+    gboolean folded)
+{
+  g_return_val_if_fail (self->L, NULL);
+  return folded ?
+      wplua_profiler_dump_folded (self->L) : wplua_profiler_dump (self->L);
+}
+
 static void
 wp_lua_scripting_plugin_class_init (WpLuaScriptingPluginClass * klass)
 {
@@ -232,6 +264,34 @@ wp_lua_scripting_plugin_class_init (WpLuaScriptingPluginClass * klass)
 
   cl_class->supports_type = wp_lua_scripting_plugin_supports_type;
   cl_class->load = wp_lua_scripting_plugin_load;
+
+  /* void profiler-start (gboolean sampling) */
+  g_signal_new_class_handler ("profiler-start", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      (GCallback) wp_lua_scripting_plugin_profiler_start,
+      NULL, NULL, NULL,
+      G_TYPE_NONE, 1, G_TYPE_BOOLEAN);
+
+  /* void profiler-stop () */
+  g_signal_new_class_handler ("profiler-stop", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      (GCallback) wp_lua_scripting_plugin_profiler_stop,
+      NULL, NULL, NULL,
+      G_TYPE_NONE, 0);
+
+  /* void profiler-reset () */
+  g_signal_new_class_handler ("profiler-reset", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      (GCallback) wp_lua_scripting_plugin_profiler_reset,
+      NULL, NULL, NULL,
+      G_TYPE_NONE, 0);
+
+  /* gchar * profiler-dump (gboolean folded) */
+  g_signal_new_class_handler ("profiler-dump", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      (GCallback) wp_lua_scripting_plugin_profiler_dump,
+      NULL, NULL, NULL,
+      G_TYPE_STRING, 1, G_TYPE_BOOLEAN);
 }
 
 WP_PLUGIN_EXPORT gboolean
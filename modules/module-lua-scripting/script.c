@@ -195,7 +195,8 @@ wp_lua_script_sandbox (lua_State *L)
   /* anything remaining on the stack are function arguments */
   int nargs = lua_gettop (L) - 3;
 
-  /* execute script */
+  /* execute script; errors propagate to the caller's message handler,
+     which sees the stack of the script */
   lua_call (L, nargs, 0);
   return 0;
 }
@@ -205,6 +206,8 @@ wp_lua_script_enable (WpPlugin * plugin, WpTransition * transition)
 {
   WpLuaScript *self = WP_LUA_SCRIPT (plugin);
   g_autoptr (GError) error = NULL;
+  WpLuaProfilerMark mark;
+  gboolean profiling, ret;
   int top, nargs = 3;
 
   if (!self->L) {
@@ -232,8 +235,14 @@ wp_lua_script_enable (WpPlugin * plugin, WpTransition * transition)
     nargs++;
   }
 
-  /* execute script */
-  if (!wplua_pcall (self->L, nargs, 0, &error)) {
+  /* execute script, measuring it if the profiler is enabled; this is done
+     here, so that the measurement also ends when the script fails */
+  profiling = wplua_profiler_begin (self->L, top + 4, &mark);
+  ret = wplua_pcall (self->L, nargs, 0, &error);
+  if (profiling)
+    wplua_profiler_end (self->L, &mark);
+
+  if (!ret) {
     lua_settop (self->L, top);
     wp_transition_return_error (transition, g_steal_pointer (&error));
     wp_lua_script_cleanup (self);
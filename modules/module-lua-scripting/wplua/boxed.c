@@ -10,19 +10,6 @@
 #include "private.h"
 #include <wp/wp.h>
 
-static lua_CFunction
-find_method_in_luaL_Reg (luaL_Reg *reg, const gchar *method)
-{
-  if (reg) {
-    while (reg->name) {
-      if (!g_strcmp0 (method, reg->name))
-        return reg->func;
-      reg++;
-    }
-  }
-  return NULL;
-}
-
 static int
 _wplua_gboxed___index (lua_State *L)
 {
@@ -30,31 +17,85 @@ _wplua_gboxed___index (lua_State *L)
       "expected userdata storing GValue<GBoxed>");
   GValue *obj_v = lua_touserdata (L, 1);
   const gchar *key = luaL_checkstring (L, 2);
-  lua_CFunction func = NULL;
-  GHashTable *vtables;
-
-  lua_pushliteral (L, "wplua_vtables");
-  lua_gettable (L, LUA_REGISTRYINDEX);
-  vtables = wplua_toboxed (L, -1);
-  lua_pop (L, 1);
+  const WpLuaMember *m;
 
   /* search in registered vtables */
-  if (!func) {
-    GType type = G_VALUE_TYPE (obj_v);
-    while (!func && type) {
-      luaL_Reg *reg = g_hash_table_lookup (vtables, GUINT_TO_POINTER (type));
-      func = find_method_in_luaL_Reg (reg, key);
-      type = g_type_parent (type);
-    }
+  m = _wplua_lookup_member (L, G_VALUE_TYPE (obj_v), key);
+  if (m && m->func) {
+    lua_pushcfunction (L, m->func);
+    return 1;
   }
+  return 0;
+}
+
+/* WpProperties are pushed read-only, with their own metatable, so that
+   reading a few keys does not need to convert the whole set to a table */
 
-  if (func) {
-    lua_pushcfunction (L, func);
+static int
+_wplua_properties___index (lua_State *L)
+{
+  WpProperties *props = wplua_checkboxed (L, 1, WP_TYPE_PROPERTIES);
+  const gchar *value;
+
+  /* there are only string keys */
+  if (lua_type (L, 2) != LUA_TSTRING)
+    return 0;
+
+  if ((value = wp_properties_get (props, lua_tostring (L, 2)))) {
+    lua_pushstring (L, value);
     return 1;
   }
+
+  /* not a property; maybe a method, like to_table() */
+  return _wplua_gboxed___index (L);
+}
+
+static int
+_wplua_properties___newindex (lua_State *L)
+{
+  return luaL_error (L, "attempted to modify read-only properties; "
+      "use to_table() to get a copy that can be modified");
+}
+
+static int
+_wplua_properties_next (lua_State *L)
+{
+  WpProperties *props = wplua_toboxed (L, lua_upvalueindex (1));
+  const struct spa_dict *dict = wp_properties_peek_dict (props);
+  lua_Integer i = lua_tointeger (L, lua_upvalueindex (2));
+
+  /* the set does not change, since only a copy of it is pushed to Lua */
+  for (; dict && i < dict->n_items; i++) {
+    if (dict->items[i].value) {
+      lua_pushinteger (L, i + 1);
+      lua_replace (L, lua_upvalueindex (2));
+      lua_pushstring (L, dict->items[i].key);
+      lua_pushstring (L, dict->items[i].value);
+      return 2;
+    }
+  }
   return 0;
 }
 
+static int
+_wplua_properties___pairs (lua_State *L)
+{
+  luaL_argcheck (L, wplua_isboxed (L, 1, WP_TYPE_PROPERTIES), 1,
+      "expected userdata storing GValue<WpProperties>");
+  lua_pushvalue (L, 1);
+  lua_pushinteger (L, 0);
+  lua_pushcclosure (L, _wplua_properties_next, 2);
+  return 1;
+}
+
+static int
+_wplua_properties___len (lua_State *L)
+{
+  WpProperties *props = wplua_checkboxed (L, 1, WP_TYPE_PROPERTIES);
+  lua_pushinteger (L, wp_properties_get_count (props));
+  return 1;
+}
+
 void
 _wplua_init_gboxed (lua_State *L)
 {
@@ -65,9 +106,23 @@ _wplua_init_gboxed (lua_State *L)
     { NULL, NULL }
   };
 
+  static const luaL_Reg properties_meta[] = {
+    { "__gc", _wplua_gvalue_userdata___gc },
+    { "__eq", _wplua_gvalue_userdata___eq },
+    { "__index", _wplua_properties___index },
+    { "__newindex", _wplua_properties___newindex },
+    { "__pairs", _wplua_properties___pairs },
+    { "__len", _wplua_properties___len },
+    { NULL, NULL }
+  };
+
   luaL_newmetatable (L, "GBoxed");
   luaL_setfuncs (L, gboxed_meta, 0);
   lua_pop (L, 1);
+
+  luaL_newmetatable (L, "WpProperties");
+  luaL_setfuncs (L, properties_meta, 0);
+  lua_pop (L, 1);
 }
 
 void
@@ -83,6 +138,16 @@ wplua_pushboxed (lua_State * L, GType type, gpointer object)
   lua_setmetatable (L, -2);
 }
 
+void
+wplua_pushproperties (lua_State * L, WpProperties * props)
+{
+  GValue *v = _wplua_pushgvalue_userdata (L, WP_TYPE_PROPERTIES);
+  g_value_take_boxed (v, props ? props : wp_properties_new_empty ());
+
+  luaL_getmetatable (L, "WpProperties");
+  lua_setmetatable (L, -2);
+}
+
 gpointer
 wplua_toboxed (lua_State *L, int idx)
 {
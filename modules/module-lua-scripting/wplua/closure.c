@@ -65,6 +65,21 @@ struct _WpLuaClosure
   GPtrArray *closures;
 };
 
+/* the batch signals of WpObjectManager carry arrays of objects; other
+   GPtrArray values are opaque and are passed as boxed userdata */
+static gboolean
+_wplua_closure_param_is_objects (gpointer invocation_hint, const GValue *v)
+{
+  GSignalInvocationHint *hint = invocation_hint;
+  GSignalQuery query;
+
+  if (!hint || !G_VALUE_HOLDS (v, G_TYPE_PTR_ARRAY))
+    return FALSE;
+
+  g_signal_query (hint->signal_id, &query);
+  return g_type_is_a (query.itype, WP_TYPE_OBJECT_MANAGER);
+}
+
 static void
 _wplua_closure_marshal (GClosure *closure, GValue *return_value,
     guint n_param_values, const GValue *param_values,
@@ -85,15 +100,26 @@ _wplua_closure_marshal (GClosure *closure, GValue *return_value,
   /* push the function */
   lua_rawgeti (L, LUA_REGISTRYINDEX, func_ref);
 
+  /* start measuring, if the profiler is enabled */
+  WpLuaProfilerMark mark;
+  gboolean profiling = wplua_profiler_begin (L, -1, &mark);
+
   /* push arguments */
-  for (guint i = 0; i < n_param_values; i++)
-    wplua_gvalue_to_lua (L, &param_values[i]);
+  for (guint i = 0; i < n_param_values; i++) {
+    if (_wplua_closure_param_is_objects (invocation_hint, &param_values[i]))
+      wplua_objects_to_table (L, g_value_get_boxed (&param_values[i]));
+    else
+      wplua_gvalue_to_lua (L, &param_values[i]);
+  }
 
   /* call in protected mode */
   reentrant++;
   int res = _wplua_pcall (L, n_param_values, return_value ? 1 : 0);
   reentrant--;
 
+  if (profiling)
+    wplua_profiler_end (L, &mark);
+
   /* handle the result */
   if (res == LUA_OK && return_value) {
     wplua_lua_to_gvalue (L, -1, return_value);
@@ -85,73 +85,43 @@ _wplua_gobject_connect (lua_State *L)
   return 1;
 }
 
-static lua_CFunction
-find_method_in_luaL_Reg (luaL_Reg *reg, const gchar *method)
-{
-  if (reg) {
-    while (reg->name) {
-      if (!g_strcmp0 (method, reg->name))
-        return reg->func;
-      reg++;
-    }
-  }
-  return NULL;
-}
-
 static int
 _wplua_gobject___index (lua_State *L)
 {
   GObject *obj = wplua_checkobject (L, 1, G_TYPE_OBJECT);
   const gchar *key = luaL_checkstring (L, 2);
-  lua_CFunction func = NULL;
-  GHashTable *vtables;
+  const WpLuaMember *m;
 
-  lua_pushliteral (L, "wplua_vtables");
-  lua_gettable (L, LUA_REGISTRYINDEX);
-  vtables = wplua_toboxed (L, -1);
-  lua_pop (L, 1);
-
-  if (!g_strcmp0 (key, "call"))
-    func = _wplua_gobject_call;
-  else if (!g_strcmp0 (key, "connect"))
-    func = _wplua_gobject_connect;
-
-  /* search in registered vtables */
-  if (!func) {
-    GType type = G_TYPE_FROM_INSTANCE (obj);
-    while (!func && type) {
-      luaL_Reg *reg = g_hash_table_lookup (vtables, GUINT_TO_POINTER (type));
-      func = find_method_in_luaL_Reg (reg, key);
-      type = g_type_parent (type);
-    }
+  if (!g_strcmp0 (key, "call")) {
+    lua_pushcfunction (L, _wplua_gobject_call);
+    return 1;
   }
-
-  /* search in registered vtables of interfaces */
-  if (!func) {
-    g_autofree GType *interfaces =
-        g_type_interfaces (G_TYPE_FROM_INSTANCE (obj), NULL);
-    GType *type = interfaces;
-    while (!func && *type) {
-      luaL_Reg *reg = g_hash_table_lookup (vtables, GUINT_TO_POINTER (*type));
-      func = find_method_in_luaL_Reg (reg, key);
-      type++;
-    }
+  else if (!g_strcmp0 (key, "connect")) {
+    lua_pushcfunction (L, _wplua_gobject_connect);
+    return 1;
   }
 
-  if (func) {
-    lua_pushcfunction (L, func);
+  /* search in registered vtables and properties */
+  m = _wplua_lookup_member (L, G_TYPE_FROM_INSTANCE (obj), key);
+  if (!m)
+    return 0;
+
+  if (m->func) {
+    lua_pushcfunction (L, m->func);
     return 1;
   }
-  else {
-    /* search in properties */
-    GObjectClass *klass = G_OBJECT_GET_CLASS (obj);
-    GParamSpec *pspec = g_object_class_find_property (klass, key);
-    if (pspec && (pspec->flags & G_PARAM_READABLE)) {
-      g_auto (GValue) v = G_VALUE_INIT;
-      g_value_init (&v, pspec->value_type);
-      g_object_get_property (obj, key, &v);
-      return wplua_gvalue_to_lua (L, &v);
+  else if (m->pspec->flags & G_PARAM_READABLE) {
+    g_auto (GValue) v = G_VALUE_INIT;
+    g_value_init (&v, m->pspec->value_type);
+    g_object_get_property (obj, m->pspec->name, &v);
+
+    /* properties are read-only in Lua; to_table() makes a table of them */
+    if (G_VALUE_TYPE (&v) == WP_TYPE_PROPERTIES) {
+      WpProperties *props = g_value_get_boxed (&v);
+      wplua_pushproperties (L, props ? wp_properties_copy (props) : NULL);
+      return 1;
     }
+    return wplua_gvalue_to_lua (L, &v);
   }
 
   return 0;
@@ -164,13 +134,14 @@ _wplua_gobject___newindex (lua_State *L)
   const gchar *key = luaL_checkstring (L, 2);
 
   /* search in properties */
-  GObjectClass *klass = G_OBJECT_GET_CLASS (obj);
-  GParamSpec *pspec = g_object_class_find_property (klass, key);
+  const WpLuaMember *m = _wplua_lookup_member (L, G_TYPE_FROM_INSTANCE (obj),
+      key);
+  GParamSpec *pspec = m ? m->pspec : NULL;
   if (pspec && (pspec->flags & G_PARAM_WRITABLE)) {
     g_auto (GValue) v = G_VALUE_INIT;
     g_value_init (&v, pspec->value_type);
     wplua_lua_to_gvalue (L, 3, &v);
-    g_object_set_property (obj, key, &v);
+    g_object_set_property (obj, pspec->name, &v);
   } else {
     luaL_error (L, "attempted to assign unknown or non-writable property '%s'",
         key);
@@ -191,6 +162,9 @@ _wplua_gobject__tostring (lua_State *L)
   return 1;
 }
 
+/* address used as the registry key of the table of pushed objects */
+static const gchar objects_key = 0;
+
 void
 _wplua_init_gobject (lua_State *L)
 {
@@ -206,6 +180,15 @@ _wplua_init_gobject (lua_State *L)
   luaL_newmetatable (L, "GObject");
   luaL_setfuncs (L, gobject_meta, 0);
   lua_pop (L, 1);
+
+  /* object pointer -> userdata, with weak values, so that pushing an object
+     that Lua already holds does not need to allocate a new userdata */
+  lua_newtable (L);
+  lua_createtable (L, 0, 1);
+  lua_pushliteral (L, "v");
+  lua_setfield (L, -2, "__mode");
+  lua_setmetatable (L, -2);
+  lua_rawsetp (L, LUA_REGISTRYINDEX, &objects_key);
 }
 
 void
@@ -213,12 +196,27 @@ wplua_pushobject (lua_State * L, gpointer object)
 {
   g_return_if_fail (G_IS_OBJECT (object));
 
+  /* reuse the userdata if the object is already in Lua; userdata that are
+     being collected are removed from the table before their __gc runs */
+  lua_rawgetp (L, LUA_REGISTRYINDEX, &objects_key);
+  if (lua_rawgetp (L, -1, object) == LUA_TUSERDATA) {
+    lua_remove (L, -2);
+    g_object_unref (object);
+    return;
+  }
+  lua_pop (L, 1);
+
   GValue *v = _wplua_pushgvalue_userdata (L, G_TYPE_FROM_INSTANCE (object));
   wp_trace_object (object, "pushing to Lua, v=%p", v);
   g_value_take_object (v, object);
 
   luaL_getmetatable (L, "GObject");
   lua_setmetatable (L, -2);
+
+  /* objects[object] = userdata */
+  lua_pushvalue (L, -1);
+  lua_rawsetp (L, -3, object);
+  lua_remove (L, -2);
 }
 
 gpointer
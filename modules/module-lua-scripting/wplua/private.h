@@ -30,7 +30,16 @@ int _wplua_gvalue_userdata___gc (lua_State *L);
 int _wplua_gvalue_userdata___eq (lua_State *L);
 
 /* wplua.c */
+typedef struct _WpLuaMember WpLuaMember;
+struct _WpLuaMember
+{
+  lua_CFunction func;
+  GParamSpec *pspec;
+};
+
 int _wplua_pcall (lua_State *L, int nargs, int nret);
+const WpLuaMember * _wplua_lookup_member (lua_State *L, GType type,
+    const gchar *key);
 
 G_END_DECLS
 
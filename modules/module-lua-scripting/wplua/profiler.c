@@ -0,0 +1,419 @@
+/* WirePlumber
+ *
+ * Copyright © 2026 Collabora Ltd.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "wplua.h"
+#include "private.h"
+#include <wp/wp.h>
+#include <time.h>
+
+/*
+ * The profiler measures every call that goes from C into Lua through a
+ * closure (signal handlers, idle/timeout callbacks, etc) and every script's
+ * main chunk. The measurements are accumulated per Lua function, which is
+ * identified by its source file and the line where it is defined.
+ *
+ * Optionally, it also samples the Lua stack using a count hook and
+ * attributes the CPU time between two samples to the stack that was running,
+ * producing "folded" stacks that can be fed directly into flamegraph tools.
+ */
+
+#define SAMPLING_INSTRUCTIONS 1000
+#define SAMPLING_MAX_DEPTH 64
+
+/* address used as the registry key of the profiler */
+static const gchar profiler_key = 0;
+
+typedef struct _WpLuaProfilerEntry WpLuaProfilerEntry;
+struct _WpLuaProfilerEntry
+{
+  gchar *source;
+  gint line;
+  guint64 calls;
+  gint64 wall_time;
+  gint64 cpu_time;
+  gint64 memory;
+};
+
+typedef struct _WpLuaProfiler WpLuaProfiler;
+struct _WpLuaProfiler
+{
+  WpLuaProfilerFlags flags;
+  GHashTable *entries; // "source:line" -> WpLuaProfilerEntry*
+  GHashTable *samples; // "frame;frame;..." -> gint64 cpu time in usec
+  gint64 last_sample;
+  guint depth; // nesting of the calls that are being measured
+  guint generation; // incremented on reset, invalidating pending marks
+};
+
+static void
+wp_lua_profiler_entry_free (WpLuaProfilerEntry * e)
+{
+  g_free (e->source);
+  g_free (e);
+}
+
+static WpLuaProfiler *
+wp_lua_profiler_new (void)
+{
+  WpLuaProfiler *self = g_rc_box_new0 (WpLuaProfiler);
+  self->entries = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify) wp_lua_profiler_entry_free);
+  self->samples = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      g_free);
+  return self;
+}
+
+static void
+wp_lua_profiler_finalize (WpLuaProfiler * self)
+{
+  g_clear_pointer (&self->entries, g_hash_table_unref);
+  g_clear_pointer (&self->samples, g_hash_table_unref);
+}
+
+static WpLuaProfiler *
+wp_lua_profiler_ref (WpLuaProfiler * self)
+{
+  return g_rc_box_acquire (self);
+}
+
+static void
+wp_lua_profiler_unref (WpLuaProfiler * self)
+{
+  g_rc_box_release_full (self, (GDestroyNotify) wp_lua_profiler_finalize);
+}
+
+G_DEFINE_BOXED_TYPE (WpLuaProfiler, wp_lua_profiler,
+    wp_lua_profiler_ref, wp_lua_profiler_unref)
+
+static inline gint64
+get_cpu_time (void)
+{
+  struct timespec ts;
+  if (clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts) < 0)
+    return 0;
+  return (gint64) ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+}
+
+static inline gint64
+get_memory (lua_State *L)
+{
+  return (gint64) lua_gc (L, LUA_GCCOUNT, 0) * 1024 +
+      lua_gc (L, LUA_GCCOUNTB, 0);
+}
+
+static WpLuaProfiler *
+get_profiler (lua_State *L)
+{
+  WpLuaProfiler *self = NULL;
+  if (lua_rawgetp (L, LUA_REGISTRYINDEX, &profiler_key) == LUA_TUSERDATA)
+    self = wplua_toboxed (L, -1);
+  lua_pop (L, 1);
+  return self;
+}
+
+static void
+sampling_hook (lua_State *L, lua_Debug *ar)
+{
+  WpLuaProfiler *self = get_profiler (L);
+  g_autoptr (GString) stack = NULL;
+  gint64 now, *cpu_time;
+  lua_Debug frame;
+  gint depth;
+
+  if (!self)
+    return;
+
+  now = get_cpu_time ();
+
+  /* find the bottom of the stack; folded stacks start from the root */
+  for (depth = 0; depth < SAMPLING_MAX_DEPTH &&
+          lua_getstack (L, depth, &frame); depth++);
+
+  stack = g_string_new (NULL);
+  while (depth-- > 0) {
+    if (!lua_getstack (L, depth, &frame) || !lua_getinfo (L, "Sn", &frame))
+      continue;
+    if (stack->len > 0)
+      g_string_append_c (stack, ';');
+    g_string_append_printf (stack, "%s:%d(%s)", frame.short_src,
+        frame.linedefined, frame.name ? frame.name : frame.what);
+  }
+
+  if (!(cpu_time = g_hash_table_lookup (self->samples, stack->str))) {
+    cpu_time = g_new0 (gint64, 1);
+    g_hash_table_insert (self->samples, g_strdup (stack->str), cpu_time);
+  }
+  *cpu_time += now - self->last_sample;
+
+  /* do not count the time spent in the hook itself */
+  self->last_sample = get_cpu_time ();
+}
+
+void
+wplua_profiler_start (lua_State * L, WpLuaProfilerFlags flags)
+{
+  WpLuaProfiler *self;
+
+  g_return_if_fail (L != NULL);
+
+  if (!(self = get_profiler (L))) {
+    self = wp_lua_profiler_new ();
+    wplua_pushboxed (L, wp_lua_profiler_get_type (), self);
+    lua_rawsetp (L, LUA_REGISTRYINDEX, &profiler_key);
+  }
+
+  wp_info ("starting Lua profiler%s",
+      (flags & WP_LUA_PROFILER_SAMPLING) ? " with sampling" : "");
+
+  /* calls are always measured; sampling is optional */
+  self->flags = flags | WP_LUA_PROFILER_CALLBACKS;
+  if (flags & WP_LUA_PROFILER_SAMPLING) {
+    self->last_sample = get_cpu_time ();
+    lua_sethook (L, sampling_hook, LUA_MASKCOUNT, SAMPLING_INSTRUCTIONS);
+  } else {
+    lua_sethook (L, NULL, 0, 0);
+  }
+}
+
+void
+wplua_profiler_stop (lua_State * L)
+{
+  WpLuaProfiler *self;
+
+  g_return_if_fail (L != NULL);
+
+  if ((self = get_profiler (L))) {
+    wp_info ("stopping Lua profiler");
+    lua_sethook (L, NULL, 0, 0);
+    self->flags = 0;
+  }
+}
+
+void
+wplua_profiler_reset (lua_State * L)
+{
+  WpLuaProfiler *self;
+
+  g_return_if_fail (L != NULL);
+
+  if ((self = get_profiler (L))) {
+    g_hash_table_remove_all (self->entries);
+    g_hash_table_remove_all (self->samples);
+    self->last_sample = get_cpu_time ();
+    self->generation++;
+  }
+}
+
+gboolean
+wplua_profiler_begin (lua_State * L, int idx, WpLuaProfilerMark * mark)
+{
+  WpLuaProfiler *self = get_profiler (L);
+  WpLuaProfilerEntry *e;
+  g_autofree gchar *key = NULL;
+  lua_Debug ar;
+
+  mark->entry = NULL;
+  if (!self || !self->flags)
+    return FALSE;
+
+  lua_pushvalue (L, idx);
+  lua_getinfo (L, ">S", &ar);
+
+  key = g_strdup_printf ("%s:%d", ar.short_src, ar.linedefined);
+  if (!(e = g_hash_table_lookup (self->entries, key))) {
+    e = g_new0 (WpLuaProfilerEntry, 1);
+    e->source = g_strdup (ar.short_src);
+    e->line = ar.linedefined;
+    g_hash_table_insert (self->entries, g_steal_pointer (&key), e);
+  }
+
+  mark->entry = e;
+  mark->generation = self->generation;
+  mark->wall_time = g_get_monotonic_time ();
+  mark->cpu_time = get_cpu_time ();
+  mark->memory = get_memory (L);
+
+  /* the time since the last sample was spent outside Lua, ex. in the
+     main loop; do not charge it to the first sample of this call */
+  if (self->depth++ == 0)
+    self->last_sample = mark->cpu_time;
+  return TRUE;
+}
+
+void
+wplua_profiler_end (lua_State * L, WpLuaProfilerMark * mark)
+{
+  WpLuaProfiler *self = get_profiler (L);
+  WpLuaProfilerEntry *e = mark->entry;
+
+  if (!e || !self)
+    return;
+
+  /* back to C; the time until Lua runs again is not spent in Lua */
+  if (--self->depth == 0)
+    self->last_sample = get_cpu_time ();
+
+  /* the entry is gone if the profiler was reset during the call */
+  if (self->generation != mark->generation) {
+    mark->entry = NULL;
+    return;
+  }
+
+  e->calls++;
+  e->wall_time += g_get_monotonic_time () - mark->wall_time;
+  e->cpu_time += get_cpu_time () - mark->cpu_time;
+  e->memory += get_memory (L) - mark->memory;
+  mark->entry = NULL;
+}
+
+static gint
+compare_cpu_time (gconstpointer a, gconstpointer b)
+{
+  const WpLuaProfilerEntry *ea = *(const WpLuaProfilerEntry **) a;
+  const WpLuaProfilerEntry *eb = *(const WpLuaProfilerEntry **) b;
+  return (ea->cpu_time < eb->cpu_time) - (ea->cpu_time > eb->cpu_time);
+}
+
+/* returns the entries, sorted by CPU time, most expensive first */
+static GPtrArray *
+get_sorted_entries (GHashTable *entries)
+{
+  GPtrArray *arr = g_ptr_array_sized_new (g_hash_table_size (entries));
+  GHashTableIter iter;
+  gpointer value;
+
+  g_hash_table_iter_init (&iter, entries);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    g_ptr_array_add (arr, value);
+  g_ptr_array_sort (arr, compare_cpu_time);
+  return arr;
+}
+
+static void
+append_entry (GString *str, const WpLuaProfilerEntry *e, const gchar *name)
+{
+  g_string_append_printf (str,
+      "%10" G_GUINT64_FORMAT " %12.3f %12.3f %12.1f  %s\n",
+      e->calls, e->wall_time / 1000.0, e->cpu_time / 1000.0,
+      e->memory / 1024.0, name);
+}
+
+gchar *
+wplua_profiler_dump (lua_State * L)
+{
+  WpLuaProfiler *self;
+  g_autoptr (GPtrArray) entries = NULL;
+  g_autoptr (GPtrArray) scripts = NULL;
+  g_autoptr (GHashTable) per_script = NULL;
+  GString *str;
+  static const gchar header[] =
+      "     calls     wall(ms)      cpu(ms)     mem(KiB)  %s\n";
+
+  g_return_val_if_fail (L != NULL, NULL);
+
+  str = g_string_new (NULL);
+  if (!(self = get_profiler (L)))
+    return g_string_free (str, FALSE);
+
+  entries = get_sorted_entries (self->entries);
+
+  /* sum up the entries of each source file */
+  per_script = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+      (GDestroyNotify) g_free);
+  for (guint i = 0; i < entries->len; i++) {
+    WpLuaProfilerEntry *e = g_ptr_array_index (entries, i);
+    WpLuaProfilerEntry *s = g_hash_table_lookup (per_script, e->source);
+    if (!s) {
+      s = g_new0 (WpLuaProfilerEntry, 1);
+      s->source = e->source;
+      g_hash_table_insert (per_script, e->source, s);
+    }
+    s->calls += e->calls;
+    s->wall_time += e->wall_time;
+    s->cpu_time += e->cpu_time;
+    s->memory += e->memory;
+  }
+  scripts = get_sorted_entries (per_script);
+
+  g_string_append (str, "Lua profile per script:\n");
+  g_string_append_printf (str, header, "script");
+  for (guint i = 0; i < scripts->len; i++) {
+    WpLuaProfilerEntry *s = g_ptr_array_index (scripts, i);
+    append_entry (str, s, s->source);
+  }
+
+  g_string_append (str, "\nLua profile per function:\n");
+  g_string_append_printf (str, header, "function");
+  for (guint i = 0; i < entries->len; i++) {
+    WpLuaProfilerEntry *e = g_ptr_array_index (entries, i);
+    g_autofree gchar *name = (e->line > 0) ?
+        g_strdup_printf ("%s:%d", e->source, e->line) :
+        g_strdup_printf ("%s (main chunk)", e->source);
+    append_entry (str, e, name);
+  }
+
+  return g_string_free (str, FALSE);
+}
+
+gchar *
+wplua_profiler_dump_folded (lua_State * L)
+{
+  WpLuaProfiler *self;
+  GHashTableIter iter;
+  gpointer key, value;
+  GString *str;
+
+  g_return_val_if_fail (L != NULL, NULL);
+
+  str = g_string_new (NULL);
+  if (!(self = get_profiler (L)))
+    return g_string_free (str, FALSE);
+
+  /* one line per stack: "frame;frame;frame <usec>" */
+  g_hash_table_iter_init (&iter, self->samples);
+  while (g_hash_table_iter_next (&iter, &key, &value)) {
+    gint64 cpu_time = *(gint64 *) value;
+    if (cpu_time > 0)
+      g_string_append_printf (str, "%s %" G_GINT64_FORMAT "\n",
+          (const gchar *) key, cpu_time);
+  }
+
+  return g_string_free (str, FALSE);
+}
+
+void
+wplua_profiler_push_stats (lua_State * L)
+{
+  WpLuaProfiler *self;
+  g_autoptr (GPtrArray) entries = NULL;
+
+  g_return_if_fail (L != NULL);
+
+  lua_newtable (L);
+  if (!(self = get_profiler (L)))
+    return;
+
+  entries = get_sorted_entries (self->entries);
+  for (guint i = 0; i < entries->len; i++) {
+    WpLuaProfilerEntry *e = g_ptr_array_index (entries, i);
+
+    lua_createtable (L, 0, 6);
+    lua_pushstring (L, e->source);
+    lua_setfield (L, -2, "source");
+    lua_pushinteger (L, e->line);
+    lua_setfield (L, -2, "line");
+    lua_pushinteger (L, e->calls);
+    lua_setfield (L, -2, "calls");
+    lua_pushinteger (L, e->wall_time);
+    lua_setfield (L, -2, "wall_time");
+    lua_pushinteger (L, e->cpu_time);
+    lua_setfield (L, -2, "cpu_time");
+    lua_pushinteger (L, e->memory);
+    lua_setfield (L, -2, "memory");
+    lua_rawseti (L, -2, i + 1);
+  }
+}
@@ -13,46 +13,72 @@
 WpProperties *
 wplua_table_to_properties (lua_State *L, int idx)
 {
-  WpProperties *p = wp_properties_new_empty ();
+  g_autoptr (WpPropertiesBuilder) b = NULL;
   const gchar *key, *value;
   int table = lua_absindex (L, idx);
 
+  b = wp_properties_builder_new (0);
+
   lua_pushnil(L);
   while (lua_next (L, table) != 0) {
     /* copy key & value to convert them to string */
     key = luaL_tolstring (L, -2, NULL);
     value = luaL_tolstring (L, -2, NULL);
-    wp_properties_set (p, key, value);
+    wp_properties_builder_add (b, key, value);
     lua_pop (L, 3);
   }
 
-  /* sort, because the lua table has a random order and it's too messy to read */
-  wp_properties_sort (p);
+  /* the result is sorted, because the lua table has a random order
+     and it's too messy to read */
+  return wp_properties_builder_end (g_steal_pointer (&b));
+}
 
-  return p;
+static gboolean
+properties_to_table_item (const gchar * key, const gchar * value,
+    gpointer data)
+{
+  lua_State *L = data;
+  lua_pushstring (L, key);
+  lua_pushstring (L, value);
+  lua_settable (L, -3);
+  return TRUE;
 }
 
 void
 wplua_properties_to_table (lua_State *L, WpProperties *p)
 {
-  lua_newtable (L);
   if (p) {
-    g_autoptr (WpIterator) it = wp_properties_new_iterator (p);
-    GValue v = G_VALUE_INIT;
-    const gchar *key, *value;
+    lua_createtable (L, 0, wp_properties_get_count (p));
+    wp_properties_foreach (p, properties_to_table_item, L);
+  } else {
+    lua_newtable (L);
+  }
+}
 
-    while (wp_iterator_next (it, &v)) {
-      WpPropertiesItem *pi = g_value_get_boxed (&v);
-      key = wp_properties_item_get_key (pi);
-      value = wp_properties_item_get_value (pi);
-      lua_pushstring (L, key);
-      lua_pushstring (L, value);
-      lua_settable (L, -3);
-      g_value_unset (&v);
-    }
+void
+wplua_objects_to_table (lua_State *L, GPtrArray *objects)
+{
+  guint len = objects ? objects->len : 0;
+
+  lua_createtable (L, (int) len, 0);
+  for (guint i = 0; i < len; i++) {
+    wplua_pushobject (L, g_object_ref (g_ptr_array_index (objects, i)));
+    lua_rawseti (L, -2, i + 1);
   }
 }
 
+WpProperties *
+wplua_checkproperties (lua_State *L, int idx)
+{
+  /* a copy, so that the caller can modify it; this is cheap, as the copy
+     shares the storage until it is modified */
+  if (wplua_isboxed (L, idx, WP_TYPE_PROPERTIES))
+    return wp_properties_copy (wplua_toboxed (L, idx));
+
+  luaL_checktype (L, idx, LUA_TTABLE);
+  return wplua_table_to_properties (L, idx);
+}
+
 GVariant *
 wplua_lua_to_gvariant (lua_State *L, int idx)
 {
@@ -239,7 +265,11 @@ wplua_lua_to_gvalue (lua_State *L, int idx, GValue *v)
       g_value_set_pointer (v, lua_touserdata (L, idx));
     break;
   case G_TYPE_BOXED:
-    if (_wplua_isgvalue_userdata (L, idx, G_VALUE_TYPE (v)))
+    /* read-only WpProperties -> a copy that the receiver may modify */
+    if (G_VALUE_TYPE (v) == WP_TYPE_PROPERTIES &&
+        _wplua_isgvalue_userdata (L, idx, WP_TYPE_PROPERTIES))
+      g_value_take_boxed (v, wp_properties_copy (wplua_toboxed (L, idx)));
+    else if (_wplua_isgvalue_userdata (L, idx, G_VALUE_TYPE (v)))
       g_value_set_boxed (v, wplua_toboxed (L, idx));
     /* table -> WpProperties */
     else if (lua_istable (L, idx) && G_VALUE_TYPE (v) == WP_TYPE_PROPERTIES)
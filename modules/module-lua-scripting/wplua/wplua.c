@@ -9,6 +9,10 @@
 #include "wplua.h"
 #include "private.h"
 #include <wp/wp.h>
+#include <glib/gstdio.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
 
 #define URI_SANDBOX "resource:///org/freedesktop/pipewire/wireplumber/wplua/sandbox.lua"
 
@@ -16,6 +20,22 @@ extern void _wplua_register_resource (void);
 
 G_DEFINE_QUARK (wplua, wp_domain_lua);
 
+/* address used as the registry key of the members cache */
+static const gchar members_cache_key = 0;
+
+/* address used as the registry key of the bytecode cache directory */
+static const gchar bytecode_cache_key = 0;
+
+static GHashTable *
+_wplua_get_members_cache (lua_State *L)
+{
+  GHashTable *cache;
+  lua_rawgetp (L, LUA_REGISTRYINDEX, &members_cache_key);
+  cache = wplua_toboxed (L, -1);
+  lua_pop (L, 1);
+  return cache;
+}
+
 static void
 _wplua_openlibs (lua_State *L)
 {
@@ -101,6 +121,13 @@ wplua_new (void)
     lua_settable (L, LUA_REGISTRYINDEX);
   }
 
+  {
+    GHashTable *t = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+        NULL, (GDestroyNotify) g_hash_table_unref);
+    wplua_pushboxed (L, G_TYPE_HASH_TABLE, t);
+    lua_rawsetp (L, LUA_REGISTRYINDEX, &members_cache_key);
+  }
+
   /* refcount */
   lua_pushinteger (L, 1);
   lua_rawsetp (L, LUA_REGISTRYINDEX, L);
@@ -189,6 +216,9 @@ wplua_register_type_methods (lua_State * L, GType type,
     }
 
     g_hash_table_insert (vtables, GUINT_TO_POINTER (type), (gpointer) methods);
+
+    /* the new methods may override the ones that were cached for subtypes */
+    g_hash_table_remove_all (_wplua_get_members_cache (L));
   }
 
   /* register constructor */
@@ -208,6 +238,98 @@ wplua_register_type_methods (lua_State * L, GType type,
   }
 }
 
+static void
+_wplua_member_free (WpLuaMember *m)
+{
+  g_clear_pointer (&m->pspec, g_param_spec_unref);
+  g_free (m);
+}
+
+static lua_CFunction
+find_method_in_luaL_Reg (const luaL_Reg *reg, const gchar *method)
+{
+  if (reg) {
+    while (reg->name) {
+      if (!g_strcmp0 (method, reg->name))
+        return reg->func;
+      reg++;
+    }
+  }
+  return NULL;
+}
+
+static lua_CFunction
+find_method_in_vtables (lua_State *L, GType type, const gchar *method)
+{
+  lua_CFunction func = NULL;
+  GHashTable *vtables;
+
+  lua_pushliteral (L, "wplua_vtables");
+  lua_gettable (L, LUA_REGISTRYINDEX);
+  vtables = wplua_toboxed (L, -1);
+  lua_pop (L, 1);
+
+  /* search in the vtables of the type and its parents */
+  for (GType t = type; !func && t; t = g_type_parent (t)) {
+    const luaL_Reg *reg = g_hash_table_lookup (vtables, GUINT_TO_POINTER (t));
+    func = find_method_in_luaL_Reg (reg, method);
+  }
+
+  /* search in the vtables of the interfaces */
+  if (!func && G_TYPE_IS_INSTANTIATABLE (type)) {
+    g_autofree GType *interfaces = g_type_interfaces (type, NULL);
+    for (GType *t = interfaces; !func && *t; t++) {
+      const luaL_Reg *reg =
+          g_hash_table_lookup (vtables, GUINT_TO_POINTER (*t));
+      func = find_method_in_luaL_Reg (reg, method);
+    }
+  }
+
+  return func;
+}
+
+/*
+ * Looks up a method or (for GObject types) a property of @type by name.
+ * The result is cached per GType, so that repeated accesses from Lua do not
+ * need to walk the type hierarchy and scan the vtables again.
+ * Returns NULL if there is no such member.
+ */
+const WpLuaMember *
+_wplua_lookup_member (lua_State *L, GType type, const gchar *key)
+{
+  GHashTable *cache = _wplua_get_members_cache (L);
+  GHashTable *members;
+  WpLuaMember *m;
+  lua_CFunction func;
+  GParamSpec *pspec = NULL;
+
+  members = g_hash_table_lookup (cache, GUINT_TO_POINTER (type));
+  if (members && (m = g_hash_table_lookup (members, key)))
+    return m;
+
+  func = find_method_in_vtables (L, type, key);
+  if (G_TYPE_FUNDAMENTAL (type) == G_TYPE_OBJECT) {
+    GObjectClass *klass = g_type_class_peek (type);
+    if (klass)
+      pspec = g_object_class_find_property (klass, key);
+  }
+
+  if (!func && !pspec)
+    return NULL;
+
+  if (!members) {
+    members = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) _wplua_member_free);
+    g_hash_table_insert (cache, GUINT_TO_POINTER (type), members);
+  }
+
+  m = g_new0 (WpLuaMember, 1);
+  m->func = func;
+  m->pspec = pspec ? g_param_spec_ref (pspec) : NULL;
+  g_hash_table_insert (members, g_strdup (key), m);
+  return m;
+}
+
 static gboolean
 _wplua_load_buffer (lua_State * L, const gchar *buf, gsize size,
     const gchar * name, GError **error)
@@ -268,11 +390,232 @@ wplua_load_uri (lua_State * L, const gchar *uri, GError **error)
   return _wplua_load_buffer (L, data, size, name, error);
 }
 
+/*
+ * The cached chunks are stored in files named after the checksum of the
+ * script's path. Each file starts with a line that has the Lua release, the
+ * modification time (in nanoseconds), size and inode of the script, the
+ * length and hash of the bytecode that follows it, which is the output of
+ * lua_dump(), and the path of the script. The bytecode is used only if all
+ * of these match: Lua does not verify binary chunks, so a damaged one could
+ * crash the process.
+ */
+#define BYTECODE_CACHE_PREFIX "WPLUA " LUA_RELEASE " "
+
+/* FNV-1a; this only needs to catch truncated or damaged files */
+static guint32
+_wplua_bytecode_hash (const guint8 *data, gsize len)
+{
+  guint32 hash = 2166136261u;
+
+  for (gsize i = 0; i < len; i++)
+    hash = (hash ^ data[i]) * 16777619u;
+  return hash;
+}
+
+static gchar *
+_wplua_bytecode_cache_key (const GStatBuf *st)
+{
+  return g_strdup_printf (BYTECODE_CACHE_PREFIX "%" G_GINT64_FORMAT ".%09ld "
+      "%" G_GINT64_FORMAT " %" G_GUINT64_FORMAT " ",
+      (gint64) st->st_mtim.tv_sec, (long) st->st_mtim.tv_nsec,
+      (gint64) st->st_size, (guint64) st->st_ino);
+}
+
+/* returns the bytecode in the \a contents of a cache file, if they were
+   made from \a path as it is now, as described by \a key, and are intact */
+static const gchar *
+_wplua_bytecode_cache_check (const gchar *contents, gsize len,
+    const gchar *key, const gchar *path, gsize *chunk_len)
+{
+  const gchar *end = contents + len;
+  const gchar *p = contents;
+  gsize key_len = strlen (key);
+  gsize path_len = strlen (path);
+  gchar *next;
+  guint64 n;
+  guint32 hash;
+
+  if (len <= key_len || memcmp (p, key, key_len) != 0)
+    return NULL;
+  p += key_len;
+
+  /* contents are nul-terminated by g_file_get_contents() */
+  n = g_ascii_strtoull (p, &next, 10);
+  if (next == p || *next != ' ')
+    return NULL;
+  p = next + 1;
+  hash = (guint32) g_ascii_strtoull (p, &next, 16);
+  if (next == p || *next != ' ')
+    return NULL;
+  p = next + 1;
+
+  if ((gsize) (end - p) <= path_len || memcmp (p, path, path_len) != 0 ||
+      p[path_len] != '\n')
+    return NULL;
+  p += path_len + 1;
+
+  if ((guint64) (end - p) != n ||
+      _wplua_bytecode_hash ((const guint8 *) p, n) != hash)
+    return NULL;
+
+  *chunk_len = n;
+  return p;
+}
+
+/* removes the cached chunks of scripts that were deleted or moved, as well
+   as the ones of other Lua releases, which would never be used again */
+static void
+_wplua_prune_bytecode_cache (const gchar *dir)
+{
+  g_autoptr (GDir) d = g_dir_open (dir, 0, NULL);
+  const gchar *fname;
+
+  if (!d)
+    return;
+
+  while ((fname = g_dir_read_name (d))) {
+    g_autofree gchar *cache_path = NULL;
+    gchar line[PATH_MAX + 128];
+    gboolean stale = TRUE;
+    FILE *f;
+
+    if (!g_str_has_suffix (fname, ".luac"))
+      continue;
+
+    cache_path = g_build_filename (dir, fname, NULL);
+    if ((f = g_fopen (cache_path, "rb"))) {
+      if (fgets (line, sizeof (line), f) &&
+          g_str_has_prefix (line, BYTECODE_CACHE_PREFIX)) {
+        gchar *p = line + strlen (BYTECODE_CACHE_PREFIX);
+        gchar *nl;
+
+        /* skip the modification time, size, inode, length and hash */
+        for (gint i = 0; p && i < 5; i++)
+          if ((p = strchr (p, ' ')))
+            p++;
+        if (p && (nl = strchr (p, '\n'))) {
+          *nl = '\0';
+          stale = !g_file_test (p, G_FILE_TEST_IS_REGULAR);
+        }
+      }
+      fclose (f);
+    }
+
+    if (stale) {
+      wp_debug ("removing stale cached bytecode %s", cache_path);
+      g_unlink (cache_path);
+    }
+  }
+}
+
+void
+wplua_enable_bytecode_cache (lua_State * L, const gchar *dir)
+{
+  static gsize pruned = 0;
+  g_autofree gchar *default_dir = NULL;
+
+  g_return_if_fail (L != NULL);
+
+  if (!dir)
+    dir = default_dir = g_build_filename (g_get_user_cache_dir (),
+        "wireplumber", "lua", NULL);
+
+  wp_debug ("caching Lua bytecode in %s", dir);
+
+  /* once per process is enough; scripts do not go away while running */
+  if (g_once_init_enter (&pruned)) {
+    _wplua_prune_bytecode_cache (dir);
+    g_once_init_leave (&pruned, 1);
+  }
+
+  lua_pushstring (L, dir);
+  lua_rawsetp (L, LUA_REGISTRYINDEX, &bytecode_cache_key);
+}
+
+static int
+_wplua_bytecode_writer (lua_State *L, const void *p, size_t sz, void *ud)
+{
+  g_byte_array_append ((GByteArray *) ud, p, sz);
+  return 0;
+}
+
+static gboolean
+_wplua_load_cached_path (lua_State * L, const gchar *dir, const gchar *path,
+    const gchar *uri, GError **error)
+{
+  g_autofree gchar *key = NULL;
+  g_autofree gchar *checksum = NULL;
+  g_autofree gchar *cache_path = NULL;
+  g_autofree gchar *contents = NULL;
+  g_autofree gchar *source = NULL;
+  g_autofree gchar *name = NULL;
+  g_autoptr (GByteArray) bytecode = NULL;
+  g_autoptr (GError) err = NULL;
+  const gchar *chunk;
+  gsize len = 0, chunk_len = 0, source_len = 0;
+  GStatBuf st;
+
+  /* let wplua_load_uri() report the error */
+  if (g_stat (path, &st) < 0 || !S_ISREG (st.st_mode))
+    return wplua_load_uri (L, uri, error);
+
+  key = _wplua_bytecode_cache_key (&st);
+  name = g_path_get_basename (path);
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, path, -1);
+  cache_path = g_strdup_printf ("%s/%s.luac", dir, checksum);
+
+  /* try the cached chunk first */
+  if (g_file_get_contents (cache_path, &contents, &len, NULL)) {
+    chunk = _wplua_bytecode_cache_check (contents, len, key, path, &chunk_len);
+    if (!chunk) {
+      wp_debug ("stale or damaged cached bytecode for %s", path);
+    } else if (luaL_loadbufferx (L, chunk, chunk_len, name, "b") == LUA_OK) {
+      wp_trace ("loaded %s from the bytecode cache", path);
+      return TRUE;
+    } else {
+      wp_debug ("invalid cached bytecode for %s: %s", path,
+          lua_tostring (L, -1));
+      lua_pop (L, 1);
+    }
+  }
+
+  if (!g_file_get_contents (path, &source, &source_len, NULL) ||
+      source_len == 0)
+    return wplua_load_uri (L, uri, error);
+
+  if (!_wplua_load_buffer (L, source, source_len, name, error))
+    return FALSE;
+
+  /* the path ends the header line */
+  if (strchr (path, '\n'))
+    return TRUE;
+
+  /* save the compiled chunk, keeping debug info for tracebacks */
+  bytecode = g_byte_array_new ();
+  if (lua_dump (L, _wplua_bytecode_writer, bytecode, 0) == 0) {
+    g_autofree gchar *header = g_strdup_printf ("%s%u %08x %s\n", key,
+        bytecode->len, _wplua_bytecode_hash (bytecode->data, bytecode->len),
+        path);
+
+    g_byte_array_prepend (bytecode, (const guint8 *) header, strlen (header));
+    if (g_mkdir_with_parents (dir, 0700) < 0 ||
+        !g_file_set_contents (cache_path, (const gchar *) bytecode->data,
+            bytecode->len, &err)) {
+      wp_debug ("failed to cache the bytecode of %s: %s", path,
+          err ? err->message : g_strerror (errno));
+    }
+  }
+
+  return TRUE;
+}
+
 gboolean
 wplua_load_path (lua_State * L, const gchar *path, GError **error)
 {
   g_autofree gchar *abs_path = NULL;
   g_autofree gchar *uri = NULL;
+  const gchar *cache_dir;
+  gboolean ret;
 
   g_return_val_if_fail (L != NULL, FALSE);
   g_return_val_if_fail (path != NULL, FALSE);
@@ -280,12 +623,19 @@ wplua_load_path (lua_State * L, const gchar *path, GError **error)
   if (!g_path_is_absolute (path)) {
     g_autofree gchar *cwd = g_get_current_dir ();
     abs_path = g_build_filename (cwd, path, NULL);
+    path = abs_path;
   }
 
-  if (!(uri = g_filename_to_uri (abs_path ? abs_path : path, NULL, error)))
+  if (!(uri = g_filename_to_uri (path, NULL, error)))
     return FALSE;
 
-  return wplua_load_uri (L, uri, error);
+  lua_rawgetp (L, LUA_REGISTRYINDEX, &bytecode_cache_key);
+  cache_dir = lua_tostring (L, -1);
+  ret = cache_dir ?
+      _wplua_load_cached_path (L, cache_dir, path, uri, error) :
+      wplua_load_uri (L, uri, error);
+  lua_remove (L, ret ? -2 : -1);
+  return ret;
 }
 
 gboolean
@@ -87,13 +87,52 @@ void wplua_gvariant_to_lua (lua_State *L, GVariant *p);
 WpProperties * wplua_table_to_properties (lua_State *L, int idx);
 void wplua_properties_to_table (lua_State *L, WpProperties *p);
 
+/* objects: (element-type GObject) */
+void wplua_objects_to_table (lua_State *L, GPtrArray *objects);
+
+/* read-only userdata; push -> transfer full, check -> table or userdata,
+   returns a new reference */
+void wplua_pushproperties (lua_State * L, WpProperties * props);
+WpProperties * wplua_checkproperties (lua_State *L, int idx);
+
 gboolean wplua_load_buffer (lua_State * L, const gchar *buf, gsize size,
     GError **error);
 gboolean wplua_load_uri (lua_State * L, const gchar *uri, GError **error);
 gboolean wplua_load_path (lua_State * L, const gchar *path, GError **error);
 
+/* dir = NULL -> $XDG_CACHE_HOME/wireplumber/lua */
+void wplua_enable_bytecode_cache (lua_State * L, const gchar *dir);
+
 gboolean wplua_pcall (lua_State * L, int nargs, int nres, GError **error);
 
+typedef enum {
+  WP_LUA_PROFILER_CALLBACKS = (1 << 0),
+  WP_LUA_PROFILER_SAMPLING = (1 << 1),
+} WpLuaProfilerFlags;
+
+typedef struct _WpLuaProfilerMark WpLuaProfilerMark;
+struct _WpLuaProfilerMark
+{
+  gpointer entry;
+  guint generation;
+  gint64 wall_time;
+  gint64 cpu_time;
+  gint64 memory;
+};
+
+void wplua_profiler_start (lua_State * L, WpLuaProfilerFlags flags);
+void wplua_profiler_stop (lua_State * L);
+void wplua_profiler_reset (lua_State * L);
+
+/* measures a call to the function at @idx, until wplua_profiler_end() */
+gboolean wplua_profiler_begin (lua_State * L, int idx, WpLuaProfilerMark * mark);
+void wplua_profiler_end (lua_State * L, WpLuaProfilerMark * mark);
+
+/* transfer full */
+gchar * wplua_profiler_dump (lua_State * L);
+gchar * wplua_profiler_dump_folded (lua_State * L);
+void wplua_profiler_push_stats (lua_State * L);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(lua_State, wplua_unref)
 
 G_END_DECLS
@@ -231,7 +231,7 @@ collect_node_info (WpMixerApi * self, struct node_info *info,
   }
 }
 
-static void on_objects_changed (WpObjectManager * om, WpMixerApi * self);
+static void rescan_all (WpMixerApi * self);
 
 static void
 on_sync_done (WpCore * core, GAsyncResult * res, WpMixerApi * self)
@@ -240,7 +240,7 @@ on_sync_done (WpCore * core, GAsyncResult * res, WpMixerApi * self)
   if (!wp_core_sync_finish (core, res, &error))
     wp_warning_object (core, "sync error: %s", error->message);
   if (self->om) {
-    on_objects_changed (self->om, self);
+    rescan_all (self);
   }
 }
 
@@ -256,37 +256,34 @@ on_params_changed (WpPipewireObject * obj, const gchar * param_name,
 }
 
 static void
-on_objects_changed (WpObjectManager * om, WpMixerApi * self)
+update_node_info (WpMixerApi * self, WpPipewireObject * node)
 {
-  g_autoptr (WpIterator) it =
-      wp_object_manager_new_filtered_iterator (om, WP_TYPE_NODE, NULL);
-  g_auto (GValue) val = G_VALUE_INIT;
-  GHashTableIter infos_it;
+  guint id = wp_proxy_get_bound_id (WP_PROXY (node));
   struct node_info *info;
   struct node_info old;
 
-  self->seq++;
-
-  for (; wp_iterator_next (it, &val); g_value_unset (&val)) {
-    WpPipewireObject *node = g_value_get_object (&val);
-    guint id = wp_proxy_get_bound_id (WP_PROXY (node));
-
-    info = g_hash_table_lookup (self->node_infos, GUINT_TO_POINTER (id));
-    if (!info) {
-      info = g_slice_new0 (struct node_info);
-      g_hash_table_insert (self->node_infos, GUINT_TO_POINTER (id), info);
-    }
-    info->seq = self->seq;
+  info = g_hash_table_lookup (self->node_infos, GUINT_TO_POINTER (id));
+  if (!info) {
+    info = g_slice_new0 (struct node_info);
+    g_hash_table_insert (self->node_infos, GUINT_TO_POINTER (id), info);
+  }
+  info->seq = self->seq;
 
-    old = *info;
-    collect_node_info (self, info, node);
-    if (memcmp (&old, info, sizeof (struct node_info)) != 0) {
-      wp_debug_object (self, "node %u changed volume props", id);
-      g_signal_emit (self, signals[SIGNAL_CHANGED], 0, id);
-    }
+  old = *info;
+  collect_node_info (self, info, node);
+  if (memcmp (&old, info, sizeof (struct node_info)) != 0) {
+    wp_debug_object (self, "node %u changed volume props", id);
+    g_signal_emit (self, signals[SIGNAL_CHANGED], 0, id);
   }
+}
+
+/* remove node_info of nodes that were removed from the object manager */
+static void
+prune_node_infos (WpMixerApi * self)
+{
+  GHashTableIter infos_it;
+  struct node_info *info;
 
-  /* remove node_info of nodes that were removed from the object manager */
   g_hash_table_iter_init (&infos_it, self->node_infos);
   while (g_hash_table_iter_next (&infos_it, NULL, (gpointer *) &info)) {
     if (info->seq != self->seq)
@@ -294,6 +291,73 @@ on_objects_changed (WpObjectManager * om, WpMixerApi * self)
   }
 }
 
+static void
+rescan_all (WpMixerApi * self)
+{
+  g_autoptr (WpIterator) it =
+      wp_object_manager_new_filtered_iterator (self->om, WP_TYPE_NODE, NULL);
+  g_auto (GValue) val = G_VALUE_INIT;
+
+  self->seq++;
+
+  for (; wp_iterator_next (it, &val); g_value_unset (&val))
+    update_node_info (self, g_value_get_object (&val));
+
+  prune_node_infos (self);
+}
+
+static gboolean
+has_devices (GPtrArray * objects)
+{
+  for (guint i = 0; i < objects->len; i++) {
+    if (WP_IS_DEVICE (g_ptr_array_index (objects, i)))
+      return TRUE;
+  }
+  return FALSE;
+}
+
+static void
+on_objects_changed (WpObjectManager * om, WpMixerApi * self)
+{
+  GPtrArray *added = NULL, *removed = NULL;
+
+  /* devices affect the volumes of all their nodes (through routes),
+     so changes in the set of devices need a full rescan */
+  if (!wp_object_manager_get_pending_changes (om, &added, &removed) ||
+      has_devices (added) || has_devices (removed)) {
+    rescan_all (self);
+    return;
+  }
+
+  /* otherwise, only collect the info of the new nodes */
+  for (guint i = 0; i < added->len; i++) {
+    gpointer obj = g_ptr_array_index (added, i);
+    if (WP_IS_NODE (obj))
+      update_node_info (self, obj);
+  }
+
+  /* and drop the info of the removed ones; these may not be bound anymore,
+     so mark the nodes that are still there, which does not involve any
+     round trips to the server */
+  if (removed->len > 0) {
+    g_autoptr (WpIterator) it =
+        wp_object_manager_new_filtered_iterator (om, WP_TYPE_NODE, NULL);
+    g_auto (GValue) val = G_VALUE_INIT;
+
+    self->seq++;
+
+    for (; wp_iterator_next (it, &val); g_value_unset (&val)) {
+      guint id = wp_proxy_get_bound_id (WP_PROXY (g_value_get_object (&val)));
+      struct node_info *info =
+          g_hash_table_lookup (self->node_infos, GUINT_TO_POINTER (id));
+      if (info)
+        info->seq = self->seq;
+    }
+
+    prune_node_infos (self);
+  }
+}
+
 static void
 on_object_added (WpObjectManager * om, WpProxy * obj, WpMixerApi * self)
 {
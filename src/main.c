@@ -392,6 +392,15 @@ signal_handler_term (gpointer data)
   return signal_handler (SIGTERM, data);
 }
 
+static gboolean
+signal_handler_usr1 (gpointer data)
+{
+  WpDaemon *d = data;
+  g_autofree gchar *stats = wp_core_dump_object_manager_stats (d->core);
+  wp_message ("object manager statistics:\n%s", stats);
+  return G_SOURCE_CONTINUE;
+}
+
 
 static gboolean
 init_start (WpTransition * transition)
@@ -472,6 +481,7 @@ main (gint argc, gchar **argv)
   g_unix_signal_add (SIGINT, signal_handler_int, &d);
   g_unix_signal_add (SIGTERM, signal_handler_term, &d);
   g_unix_signal_add (SIGHUP, signal_handler_hup, &d);
+  g_unix_signal_add (SIGUSR1, signal_handler_usr1, &d);
 
   /* initialization transition */
   g_idle_add ((GSourceFunc) init_start,
@@ -458,17 +458,16 @@ function findBestLinkable (si)
   local target_direction = getTargetDirection(si_props)
   local target_picked = nil
   local target_can_passthrough = false
-  local target_priority = 0
-  local target_plugged = 0
 
-  for si_target in linkables_om:iterate {
+  -- linkables come sorted by priority and then by plug time, so the first
+  -- acceptable one is the highest priority, latest plugged target
+  for si_target in linkables_om:iterate_sorted (LINKABLE_SORT_KEYS, {
     Constraint { "item.node.type", "=", "device" },
     Constraint { "item.node.direction", "=", target_direction },
     Constraint { "media.type", "=", si_props["media.type"] },
-  } do
+  }) do
     local si_target_props = si_target.properties
     local si_target_node_id = si_target_props["node.id"]
-    local priority = tonumber(si_target_props["priority.session"]) or 0
 
     Log.debug(string.format("Looking at: %s (%s)",
         tostring(si_target_props["node.name"]),
@@ -491,24 +490,13 @@ function findBestLinkable (si)
       goto skip_linkable
     end
 
-    local plugged = tonumber(si_target_props["item.plugged.usec"]) or 0
+    Log.debug("... priority:"..tostring(si_target_props["priority.session"])..
+        ", plugged:"..tostring(si_target_props["item.plugged.usec"]))
+    Log.debug("... picked")
+    target_picked = si_target
+    target_can_passthrough = can_passthrough
+    break
 
-    Log.debug("... priority:"..tostring(priority)..", plugged:"..tostring(plugged))
-
-    -- (target_picked == NULL) --> make sure atleast one target is picked.
-    -- (priority > target_priority) --> pick the highest priority linkable(node)
-    -- target.
-    -- (priority == target_priority and plugged > target_plugged) --> pick the
-    -- latest connected/plugged(in time) linkable(node) target.
-    if (target_picked == nil or
-        priority > target_priority or
-        (priority == target_priority and plugged > target_plugged)) then
-          Log.debug("... picked")
-          target_picked = si_target
-          target_can_passthrough = can_passthrough
-          target_priority = priority
-          target_plugged = plugged
-    end
     ::skip_linkable::
   end
 
@@ -852,6 +840,10 @@ linkables_om = ObjectManager {
   }
 }
 
+-- keeps findBestLinkable() from having to look at every linkable
+LINKABLE_SORT_KEYS = { "priority.session", "item.plugged.usec" }
+linkables_om:add_sorted_view (LINKABLE_SORT_KEYS)
+
 pending_linkables_om = ObjectManager {
   Interest {
     type = "SiLinkable",
@@ -137,7 +137,7 @@ function saveTarget(subject, target_key, type, value)
     return
   end
 
-  local stream_props = node.properties
+  local stream_props = node.properties:to_table()
   rulesApplyProperties(stream_props)
 
   if stream_props["state.restore-target"] == false then
@@ -285,7 +285,7 @@ end
 
 
 function saveStream(node)
-  local stream_props = node.properties
+  local stream_props = node.properties:to_table()
   rulesApplyProperties(stream_props)
 
   if config_restore_props and stream_props["state.restore-props"] ~= false then
@@ -349,7 +349,7 @@ function build_default_channel_volumes (node)
 end
 
 function restoreStream(node)
-  local stream_props = node.properties
+  local stream_props = node.properties:to_table()
   rulesApplyProperties(stream_props)
 
   local key_base = findSuitableKey(stream_props)
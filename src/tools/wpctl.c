@@ -654,6 +654,15 @@ property_item_compare (gconstpointer a, gconstpointer b)
       ((struct property_item *) b)->key);
 }
 
+static gboolean
+append_property_item (const gchar * key, const gchar * value, gpointer data)
+{
+  GArray *array = data;
+  struct property_item prop_item = { .key = key, .value = value };
+  g_array_append_val (array, prop_item);
+  return TRUE;
+}
+
 static void
 inspect_print_object (WpCtl * self, WpProxy * proxy, guint nest_level)
 {
@@ -678,21 +687,7 @@ inspect_print_object (WpCtl * self, WpProxy * proxy, guint nest_level)
   wp_properties_set (properties, "object.id", NULL);
 
   /* copy key/value pointers to an array for sorting */
-  {
-    g_autoptr (WpIterator) it = NULL;
-    g_auto (GValue) item = G_VALUE_INIT;
-
-    for (it = wp_properties_new_iterator (properties);
-          wp_iterator_next (it, &item);
-          g_value_unset (&item)) {
-      WpPropertiesItem *pi = g_value_get_boxed (&item);
-      struct property_item prop_item = {
-        .key = wp_properties_item_get_key (pi),
-        .value = wp_properties_item_get_value (pi),
-      };
-      g_array_append_val (array, prop_item);
-    }
-  }
+  wp_properties_foreach (properties, append_property_item, array);
 
   /* sort */
   g_array_sort (array, property_item_compare);
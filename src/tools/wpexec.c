@@ -25,6 +25,8 @@ enum WpExitCode
 };
 
 static gchar * exec_script = NULL;
+static gboolean profile = FALSE;
+static gchar * profile_folded = NULL;
 static GVariantBuilder exec_args_b =
     G_VARIANT_BUILDER_INIT (G_VARIANT_TYPE_VARDICT);
 
@@ -53,6 +55,12 @@ parse_exec_script_arg (const gchar *option_name, const gchar *value,
 
 static GOptionEntry entries[] =
 {
+  { "profile", 'p', G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE, &profile,
+    "Print the time spent in each Lua function on exit", NULL },
+  { "profile-folded", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_FILENAME,
+    &profile_folded,
+    "Sample the Lua stack and write folded stacks for flamegraphs to FILE",
+    "FILE" },
   { G_OPTION_REMAINING, 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_CALLBACK,
     parse_exec_script_arg, NULL, NULL },
   { NULL }
@@ -156,6 +164,13 @@ wp_init_transition_execute_step (WpTransition * transition, guint step)
   case STEP_ACTIVATE_SCRIPT: {
     g_autofree gchar *name = g_strdup_printf ("script:%s", exec_script);
     g_autoptr (WpPlugin) p = wp_plugin_find (core, name);
+
+    /* start profiling before the script runs, to include its main chunk */
+    if (profile || profile_folded) {
+      g_autoptr (WpPlugin) engine = wp_plugin_find (core, "lua-scripting");
+      g_signal_emit_by_name (engine, "profiler-start", profile_folded != NULL);
+    }
+
     wp_object_activate (WP_OBJECT (p), WP_PLUGIN_FEATURE_ENABLED, NULL,
         (GAsyncReadyCallback) on_plugin_activated, self);
     break;
@@ -223,6 +238,30 @@ init_done (WpCore * core, GAsyncResult * res, WpExec * d)
   }
 }
 
+static void
+dump_profile (WpCore * core)
+{
+  g_autoptr (WpPlugin) engine = wp_plugin_find (core, "lua-scripting");
+  g_autoptr (GError) error = NULL;
+
+  if (!engine || !(wp_object_get_active_features (WP_OBJECT (engine)) &
+          WP_PLUGIN_FEATURE_ENABLED))
+    return;
+
+  if (profile) {
+    g_autofree gchar *str = NULL;
+    g_signal_emit_by_name (engine, "profiler-dump", FALSE, &str);
+    fprintf (stderr, "%s", str);
+  }
+
+  if (profile_folded) {
+    g_autofree gchar *str = NULL;
+    g_signal_emit_by_name (engine, "profiler-dump", TRUE, &str);
+    if (!g_file_set_contents (profile_folded, str, -1, &error))
+      fprintf (stderr, "%s\n", error->message);
+  }
+}
+
 gint
 main (gint argc, gchar **argv)
 {
@@ -267,6 +306,8 @@ main (gint argc, gchar **argv)
 
   /* run */
   g_main_loop_run (d.loop);
+  if (profile || profile_folded)
+    dump_profile (d.core);
   wp_core_disconnect (d.core);
   return d.exit_code;
 }
@@ -0,0 +1,161 @@
+/* WirePlumber
+ *
+ * Copyright © 2021 Collabora Ltd.
+ *    @author George Kiagiadakis <george.kiagiadakis@collabora.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../common/base-test-fixture.h"
+
+typedef struct {
+  WpBaseTestFixture base;
+  WpPlugin *mixer_api;
+  guint32 changed_id;
+} TestFixture;
+
+static void
+test_mixer_api_setup (TestFixture * f, gconstpointer user_data)
+{
+  wp_base_test_fixture_setup (&f->base, 0);
+
+  /* load modules */
+  {
+    g_autoptr (WpTestServerLocker) lock =
+        wp_test_server_locker_new (&f->base.server);
+
+    g_assert_cmpint (pw_context_add_spa_lib (f->base.server.context,
+            "audiotestsrc", "audiotestsrc/libspa-audiotestsrc"), ==, 0);
+    g_assert_nonnull (pw_context_load_module (f->base.server.context,
+            "libpipewire-module-adapter", NULL, NULL));
+  }
+  {
+    g_autoptr (GError) error = NULL;
+    wp_core_load_component (f->base.core,
+        "libwireplumber-module-mixer-api", "module", NULL, &error);
+    g_assert_no_error (error);
+  }
+
+  f->mixer_api = wp_plugin_find (f->base.core, "mixer-api");
+  g_assert_nonnull (f->mixer_api);
+  wp_object_activate (WP_OBJECT (f->mixer_api), WP_PLUGIN_FEATURE_ENABLED,
+      NULL, (GAsyncReadyCallback) test_object_activate_finish_cb, f);
+  g_main_loop_run (f->base.loop);
+}
+
+static void
+test_mixer_api_teardown (TestFixture * f, gconstpointer user_data)
+{
+  g_clear_object (&f->mixer_api);
+  wp_base_test_fixture_teardown (&f->base);
+}
+
+static void
+on_mixer_changed (WpPlugin * mixer_api, guint32 id, TestFixture * f)
+{
+  f->changed_id = id;
+  g_main_loop_quit (f->base.loop);
+}
+
+static gboolean
+quit_loop_idle (TestFixture * f)
+{
+  g_main_loop_quit (f->base.loop);
+  return G_SOURCE_REMOVE;
+}
+
+static WpNode *
+test_mixer_api_create_node (TestFixture * f, const gchar * name)
+{
+  WpNode *node = wp_node_new_from_factory (f->base.core,
+      "adapter",
+      wp_properties_new (
+          "factory.name", "audiotestsrc",
+          "node.name", name,
+          "media.class", "Audio/Source",
+          NULL));
+  g_assert_nonnull (node);
+  wp_object_activate (WP_OBJECT (node), WP_PIPEWIRE_OBJECT_FEATURES_MINIMAL,
+      NULL, (GAsyncReadyCallback) test_object_activate_finish_cb, f);
+  g_main_loop_run (f->base.loop);
+
+  /* the mixer collects the volume of the node when it is reported as added */
+  while (f->changed_id != wp_proxy_get_bound_id (WP_PROXY (node)))
+    g_main_loop_run (f->base.loop);
+  return node;
+}
+
+static GVariant *
+test_mixer_api_get_volume (TestFixture * f, guint32 id)
+{
+  GVariant *v = NULL;
+  g_signal_emit_by_name (f->mixer_api, "get-volume", id, &v);
+  return v;
+}
+
+static void
+test_mixer_api_objects_changed (TestFixture * f, gconstpointer user_data)
+{
+  g_autoptr (WpNode) node1 = NULL;
+  g_autoptr (WpNode) node2 = NULL;
+  guint32 id1, id2;
+
+  /* skip test if audiotestsrc is not installed */
+  if (!test_is_spa_lib_installed (&f->base, "audiotestsrc")) {
+    g_test_skip ("The pipewire audiotestsrc factory was not found");
+    return;
+  }
+
+  g_signal_connect (f->mixer_api, "changed", G_CALLBACK (on_mixer_changed), f);
+
+  /* nodes that are added after the mixer is enabled are picked up
+     from the pending changes of the object manager */
+  node1 = test_mixer_api_create_node (f, "audiotestsrc.1");
+  node2 = test_mixer_api_create_node (f, "audiotestsrc.2");
+  id1 = wp_proxy_get_bound_id (WP_PROXY (node1));
+  id2 = wp_proxy_get_bound_id (WP_PROXY (node2));
+
+  {
+    g_autoptr (GVariant) v1 = test_mixer_api_get_volume (f, id1);
+    g_autoptr (GVariant) v2 = test_mixer_api_get_volume (f, id2);
+    gdouble volume = 0.0;
+
+    g_assert_nonnull (v1);
+    g_assert_true (g_variant_lookup (v1, "volume", "d", &volume));
+    g_assert_nonnull (v2);
+    g_assert_true (g_variant_lookup (v2, "volume", "d", &volume));
+  }
+
+  /* remove node1 on the server and wait until objects-changed has been
+     emitted for it; idle callbacks are dispatched in order */
+  wp_global_proxy_request_destroy (WP_GLOBAL_PROXY (node1));
+  wp_core_sync (f->base.core, NULL, (GAsyncReadyCallback) test_core_done_cb,
+      f);
+  g_main_loop_run (f->base.loop);
+  wp_core_idle_add (f->base.core, NULL, (GSourceFunc) quit_loop_idle, f, NULL);
+  g_main_loop_run (f->base.loop);
+
+  /* only the removed node is forgotten */
+  {
+    g_autoptr (GVariant) v1 = test_mixer_api_get_volume (f, id1);
+    g_autoptr (GVariant) v2 = test_mixer_api_get_volume (f, id2);
+
+    g_assert_null (v1);
+    g_assert_nonnull (v2);
+  }
+}
+
+gint
+main (gint argc, gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  wp_init (WP_INIT_ALL);
+
+  g_test_add ("/modules/mixer-api/objects-changed",
+      TestFixture, NULL,
+      test_mixer_api_setup,
+      test_mixer_api_objects_changed,
+      test_mixer_api_teardown);
+
+  return g_test_run ();
+}
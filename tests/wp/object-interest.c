@@ -871,6 +871,107 @@ test_object_interest_validate (TestFixture * f, gconstpointer data)
   TEST_EXPECT_VALIDATION_ERROR (i);
 }
 
+static void
+test_object_interest_reuse (TestFixture * f, gconstpointer data)
+{
+  g_autoptr (WpObjectInterest) i = NULL;
+  g_autoptr (GObject) a = NULL;
+  g_autoptr (GObject) plain = NULL;
+  g_autoptr (GError) error = NULL;
+
+  a = g_object_new (TEST_TYPE_A, "test-string", "egg", "test-uint", 150, NULL);
+  plain = g_object_new (G_TYPE_OBJECT, NULL);
+
+  /* the same interest is matched repeatedly, against different classes */
+  i = wp_object_interest_new (G_TYPE_OBJECT,
+      WP_CONSTRAINT_TYPE_G_PROPERTY, "test-string", "#s", "t*st", NULL);
+  g_assert_true (wp_object_interest_validate (i, &error));
+  g_assert_no_error (error);
+
+  for (guint n = 0; n < 3; n++) {
+    g_assert_true (wp_object_interest_matches (i, f->object));
+    g_assert_false (wp_object_interest_matches (i, a));
+    g_assert_false (wp_object_interest_matches (i, plain));
+  }
+
+  /* adding a constraint after the interest was used takes effect */
+  wp_object_interest_add_constraint (i, WP_CONSTRAINT_TYPE_G_PROPERTY,
+      "test-uint", WP_CONSTRAINT_VERB_IN_LIST, g_variant_new ("(uu)", 10, 50));
+  g_assert_true (wp_object_interest_validate (i, &error));
+  g_assert_no_error (error);
+  g_assert_true (wp_object_interest_matches (i, f->object));
+
+  g_object_set (f->object, "test-uint", 11, NULL);
+  g_assert_false (wp_object_interest_matches (i, f->object));
+}
+
+static void
+test_object_interest_stats (TestFixture * f, gconstpointer data)
+{
+  g_autoptr (WpObjectInterest) i = NULL;
+  g_autoptr (WpObjectInterest) ia = NULL;
+  g_autoptr (WpProperties) good = NULL;
+  g_autoptr (WpProperties) bad_class = NULL;
+  g_autoptr (WpProperties) bad_both = NULL;
+  g_autoptr (GObject) plain = NULL;
+  g_autofree gchar *explanation = NULL;
+  WpObjectInterestStats stats;
+
+  i = wp_object_interest_new (WP_TYPE_PROPERTIES,
+      WP_CONSTRAINT_TYPE_PW_PROPERTY, "media.class", "=s", "Audio/Sink",
+      WP_CONSTRAINT_TYPE_PW_PROPERTY, "node.name", "+",
+      NULL);
+  good = wp_properties_new ("media.class", "Audio/Sink",
+      "node.name", "sink", NULL);
+  bad_class = wp_properties_new ("media.class", "Audio/Source",
+      "node.name", "source", NULL);
+  bad_both = wp_properties_new ("media.class", "Video/Source", NULL);
+
+  g_assert_true (wp_object_interest_matches (i, good));
+  g_assert_false (wp_object_interest_matches (i, bad_class));
+  g_assert_false (wp_object_interest_matches (i, bad_both));
+  g_assert_false (wp_object_interest_matches (i, bad_both));
+
+  wp_object_interest_get_stats (i, &stats);
+  g_assert_cmpuint (stats.n_evaluations, ==, 4);
+  g_assert_cmpuint (stats.n_matches, ==, 1);
+  g_assert_cmpuint (stats.n_type_rejects, ==, 0);
+  g_assert_cmpuint (stats.top_reject_constraint, ==, 1);
+  g_assert_cmpuint (stats.n_top_rejects, ==, 3);
+
+  /* explain checks all the constraints, without affecting the stats */
+  g_assert_null (wp_object_interest_explain (i, good));
+  explanation = wp_object_interest_explain (i, bad_both);
+  g_assert_cmpstr (explanation, ==,
+      "constraint 1 (pw media.class = 'Audio/Sink') failed: "
+          "media.class is 'Video/Source'\n"
+      "constraint 2 (pw node.name +) failed: node.name is absent\n");
+  g_clear_pointer (&explanation, g_free);
+
+  wp_object_interest_get_stats (i, &stats);
+  g_assert_cmpuint (stats.n_evaluations, ==, 4);
+
+  wp_object_interest_reset_stats (i);
+  wp_object_interest_get_stats (i, &stats);
+  g_assert_cmpuint (stats.n_evaluations, ==, 0);
+  g_assert_cmpuint (stats.n_matches, ==, 0);
+  g_assert_cmpuint (stats.top_reject_constraint, ==, 0);
+  g_assert_cmpuint (stats.n_top_rejects, ==, 0);
+
+  /* type mismatches */
+  ia = wp_object_interest_new_type (TEST_TYPE_A);
+  plain = g_object_new (G_TYPE_OBJECT, NULL);
+  g_assert_false (wp_object_interest_matches (ia, plain));
+
+  wp_object_interest_get_stats (ia, &stats);
+  g_assert_cmpuint (stats.n_evaluations, ==, 1);
+  g_assert_cmpuint (stats.n_type_rejects, ==, 1);
+  g_assert_cmpuint (stats.top_reject_constraint, ==, 0);
+
+  explanation = wp_object_interest_explain (ia, plain);
+  g_assert_cmpstr (explanation, ==, "type GObject is not a TestObjA\n");
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -931,5 +1032,17 @@ main (int argc, char *argv[])
       test_object_interest_validate,
       test_object_interest_teardown);
 
+  g_test_add ("/wp/object-interest/reuse",
+      TestFixture, NULL,
+      test_object_interest_setup,
+      test_object_interest_reuse,
+      test_object_interest_teardown);
+
+  g_test_add ("/wp/object-interest/stats",
+      TestFixture, NULL,
+      test_object_interest_setup,
+      test_object_interest_stats,
+      test_object_interest_teardown);
+
   return g_test_run ();
 }
@@ -88,6 +88,25 @@ test_om_interest_on_pw_props (TestFixture *f, gconstpointer user_data)
   wp_core_sync (f->base.core, NULL, (GAsyncReadyCallback) test_core_done_cb, f);
   g_main_loop_run (f->base.loop);
 
+  /* a passive object manager exposes it without binding it */
+  om = wp_object_manager_new ();
+  wp_object_manager_set_passive (om, TRUE);
+  wp_object_manager_add_interest (om, WP_TYPE_NODE,
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, "node.name", "=s", "Test Source",
+      NULL);
+  test_ensure_object_manager_is_installed (om, f->base.core, f->base.loop);
+
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om), ==, 1);
+  {
+    g_autoptr (WpGlobalProxy) proxy =
+        wp_object_manager_lookup (om, WP_TYPE_NODE, NULL);
+    g_assert_nonnull (proxy);
+    g_assert_cmphex (wp_object_get_active_features (WP_OBJECT (proxy)), ==, 0);
+    g_assert_cmpuint (wp_global_proxy_get_global_id (proxy), ==,
+        wp_proxy_get_bound_id (WP_PROXY (node)));
+  }
+  g_clear_object (&om);
+
   /* request that node from the base core */
   om = wp_object_manager_new ();
   wp_object_manager_add_interest (om, WP_TYPE_NODE,
@@ -143,7 +162,9 @@ test_om_iterate_remove (TestFixture *f, gconstpointer user_data)
   {
     g_autoptr (WpIterator) it = wp_object_manager_new_iterator (om);
     g_auto (GValue) value = G_VALUE_INIT;
+    guint n_items = 0;
     while (wp_iterator_next (it, &value)) {
+      n_items++;
       si = g_value_get_object (&value);
       g_assert_true (WP_IS_SESSION_ITEM (si));
       if (!g_strcmp0 (wp_session_item_get_property (si, "property1"), "1234")) {
@@ -151,6 +172,17 @@ test_om_iterate_remove (TestFixture *f, gconstpointer user_data)
       }
       g_value_unset (&value);
     }
+    /* removals do not disturb an iteration that is in progress */
+    g_assert_cmpuint (n_items, ==, 4);
+
+    /* a reset starts over from the current set of objects */
+    wp_iterator_reset (it);
+    n_items = 0;
+    while (wp_iterator_next (it, &value)) {
+      n_items++;
+      g_value_unset (&value);
+    }
+    g_assert_cmpuint (n_items, ==, 2);
   }
 
   g_assert_cmpint (wp_object_manager_get_n_objects (om), ==, 2);
@@ -158,6 +190,635 @@ test_om_iterate_remove (TestFixture *f, gconstpointer user_data)
       WP_CONSTRAINT_TYPE_PW_PROPERTY, "property1", "=s", "1234", NULL));
 }
 
+static WpSessionItem *
+register_si_dummy (TestFixture *f, const gchar *property1)
+{
+  WpSessionItem *si = g_object_new (si_dummy_get_type (),
+      "core", f->base.core, NULL);
+  g_assert_true (wp_session_item_configure (si,
+      wp_properties_new ("property1", property1, NULL)));
+  wp_session_item_register (si);
+  return si;
+}
+
+static void
+test_om_dispatch (TestFixture *f, gconstpointer user_data)
+{
+  g_autoptr (WpObjectManager) om1 = NULL;
+  g_autoptr (WpObjectManager) om2 = NULL;
+  g_autoptr (WpObjectManager) om3 = NULL;
+  g_autoptr (WpSessionItem) found = NULL;
+
+  om1 = wp_object_manager_new ();
+  wp_object_manager_add_interest (om1, si_dummy_get_type (), NULL);
+  test_ensure_object_manager_is_installed (om1, f->base.core, f->base.loop);
+
+  /* adding an object caches the object managers that are interested
+     in its type */
+  register_si_dummy (f, "1");
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om1), ==, 1);
+
+  /* installing an object manager while that is cached */
+  om2 = wp_object_manager_new ();
+  wp_object_manager_add_interest (om2, si_dummy_get_type (),
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, "property1", "!s", "none", NULL);
+  test_ensure_object_manager_is_installed (om2, f->base.core, f->base.loop);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om2), ==, 1);
+
+  register_si_dummy (f, "2");
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om1), ==, 2);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om2), ==, 2);
+
+  /* an interest on a parent type gets the objects of its subtypes */
+  om3 = wp_object_manager_new ();
+  wp_object_manager_add_interest (om3, WP_TYPE_SESSION_ITEM, NULL);
+  test_ensure_object_manager_is_installed (om3, f->base.core, f->base.loop);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om3), ==, 2);
+
+  register_si_dummy (f, "3");
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om1), ==, 3);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om2), ==, 3);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om3), ==, 3);
+  found = wp_object_manager_lookup (om3, si_dummy_get_type (),
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, "property1", "=s", "3", NULL);
+  g_assert_nonnull (found);
+
+  /* object managers that are gone are not dispatched to anymore */
+  g_clear_object (&om2);
+  register_si_dummy (f, "4");
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om1), ==, 4);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om3), ==, 4);
+}
+
+static void
+test_om_remove_middle (TestFixture *f, gconstpointer user_data)
+{
+  static const gchar *const values[] = { "1", "2", "3", "4", "5" };
+  g_autoptr (WpObjectManager) om = NULL;
+  g_autoptr (WpIterator) it = NULL;
+  g_auto (GValue) value = G_VALUE_INIT;
+  WpSessionItem *items[G_N_ELEMENTS (values)];
+  guint seen = 0;
+
+  for (guint i = 0; i < G_N_ELEMENTS (values); i++)
+    items[i] = register_si_dummy (f, values[i]);
+
+  om = wp_object_manager_new ();
+  wp_object_manager_add_interest (om, si_dummy_get_type (), NULL);
+  test_ensure_object_manager_is_installed (om, f->base.core, f->base.loop);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om), ==, 5);
+
+  /* remove an object from the middle while iterating; the iteration still
+     returns every object once, including the one that was removed */
+  it = wp_object_manager_new_iterator (om);
+  for (; wp_iterator_next (it, &value); g_value_unset (&value)) {
+    const gchar *v = wp_session_item_get_property (
+        g_value_get_object (&value), "property1");
+    guint bit = 1 << (g_ascii_strtoull (v, NULL, 10) - 1);
+
+    g_assert_cmphex (seen & bit, ==, 0);
+    if (seen == 0)
+      wp_session_item_remove (items[2]);
+    seen |= bit;
+  }
+  g_assert_cmphex (seen, ==, 0x1f);
+  g_clear_pointer (&it, wp_iterator_unref);
+
+  /* the last object took its place; removing it must still work */
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om), ==, 4);
+  wp_session_item_remove (items[4]);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om), ==, 3);
+
+  seen = 0;
+  it = wp_object_manager_new_iterator (om);
+  for (; wp_iterator_next (it, &value); g_value_unset (&value)) {
+    const gchar *v = wp_session_item_get_property (
+        g_value_get_object (&value), "property1");
+    seen |= 1 << (g_ascii_strtoull (v, NULL, 10) - 1);
+  }
+  g_assert_cmphex (seen, ==, 0x0b);
+  g_assert_null (wp_object_manager_lookup (om, si_dummy_get_type (),
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, "property1", "=s", "3", NULL));
+  g_assert_null (wp_object_manager_lookup (om, si_dummy_get_type (),
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, "property1", "=s", "5", NULL));
+}
+
+static void
+test_om_index (TestFixture *f, gconstpointer user_data)
+{
+  g_autoptr (WpObjectManager) om = NULL;
+  g_autoptr (WpSessionItem) found = NULL;
+  WpSessionItem *si = NULL, *si_1234 = NULL;
+
+  si = g_object_new (si_dummy_get_type (), "core", f->base.core, NULL);
+  g_assert_true (wp_session_item_configure (si,
+      wp_properties_new ("property1", "4321", NULL)));
+  wp_session_item_register (si);
+
+  si_1234 = si = g_object_new (si_dummy_get_type (), "core", f->base.core, NULL);
+  g_assert_true (wp_session_item_configure (si,
+      wp_properties_new ("property1", "1234", NULL)));
+  wp_session_item_register (si);
+
+  om = wp_object_manager_new ();
+  wp_object_manager_add_interest (om, si_dummy_get_type (), NULL);
+  wp_object_manager_add_index (om,
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, "property1");
+  test_ensure_object_manager_is_installed (om, f->base.core, f->base.loop);
+  g_assert_cmpint (wp_object_manager_get_n_objects (om), ==, 2);
+
+  /* string and integer values both use the index */
+  found = wp_object_manager_lookup (om, si_dummy_get_type (),
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, "property1", "=s", "1234", NULL);
+  g_assert_true (found == si_1234);
+  g_clear_object (&found);
+
+  found = wp_object_manager_lookup (om, si_dummy_get_type (),
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, "property1", "=i", 1234, NULL);
+  g_assert_true (found == si_1234);
+  g_clear_object (&found);
+
+  g_assert_null (wp_object_manager_lookup (om, si_dummy_get_type (),
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, "property1", "=s", "5678", NULL));
+
+  /* the index follows property changes */
+  g_assert_true (wp_session_item_configure (si_1234,
+      wp_properties_new ("property1", "5678", NULL)));
+  g_assert_null (wp_object_manager_lookup (om, si_dummy_get_type (),
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, "property1", "=s", "1234", NULL));
+  found = wp_object_manager_lookup (om, si_dummy_get_type (),
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, "property1", "=u", 5678, NULL);
+  g_assert_true (found == si_1234);
+  g_clear_object (&found);
+
+  /* and object removals */
+  wp_session_item_remove (si_1234);
+  g_assert_cmpint (wp_object_manager_get_n_objects (om), ==, 1);
+  g_assert_null (wp_object_manager_lookup (om, si_dummy_get_type (),
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, "property1", "=s", "5678", NULL));
+}
+
+static void
+test_om_sorted_view (TestFixture *f, gconstpointer user_data)
+{
+  static const gchar * const keys[] = { "priority", "plugged", NULL };
+  static const gchar *const props[][3] = {
+    { "a", "10.5", "1" },
+    { "b", "20", NULL },
+    { "c", NULL, "5" },
+    { "d", "20", "3" },
+    { "e", "1.025e1", NULL },
+  };
+  g_autoptr (WpObjectManager) om = NULL;
+  g_autoptr (WpIterator) it = NULL;
+  g_auto (GValue) value = G_VALUE_INIT;
+  WpSessionItem *items[G_N_ELEMENTS (props)];
+  GString *order = g_string_new (NULL);
+
+  for (guint i = 0; i < G_N_ELEMENTS (items); i++) {
+    items[i] = g_object_new (si_dummy_get_type (), "core", f->base.core, NULL);
+    WpProperties *p = wp_properties_new ("name", props[i][0], NULL);
+    wp_properties_set (p, "priority", props[i][1]);
+    wp_properties_set (p, "plugged", props[i][2]);
+    g_assert_true (wp_session_item_configure (items[i], p));
+    wp_session_item_register (items[i]);
+  }
+
+  om = wp_object_manager_new ();
+  wp_object_manager_add_interest (om, si_dummy_get_type (), NULL);
+  wp_object_manager_add_sorted_view (om,
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, keys, WP_SORTED_VIEW_FLAGS_NONE);
+  test_ensure_object_manager_is_installed (om, f->base.core, f->base.loop);
+
+  /* highest values first; missing values count as 0
+     and fractional values are not truncated */
+  it = wp_object_manager_new_sorted_iterator (om,
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, keys, WP_SORTED_VIEW_FLAGS_NONE,
+      NULL);
+  for (; wp_iterator_next (it, &value); g_value_unset (&value)) {
+    g_autoptr (WpProperties) p =
+        wp_session_item_get_properties (g_value_get_object (&value));
+    g_string_append (order, wp_properties_get (p, "name"));
+  }
+  g_assert_cmpstr (order->str, ==, "dbaec");
+  g_clear_pointer (&it, wp_iterator_unref);
+
+  /* the order follows property changes */
+  g_assert_true (wp_session_item_configure (items[2],
+      wp_properties_new ("name", "c", "priority", "30", NULL)));
+
+  /* and can be filtered with an interest */
+  it = wp_object_manager_new_sorted_iterator (om,
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, keys, WP_SORTED_VIEW_FLAGS_NONE,
+      wp_object_interest_new (si_dummy_get_type (),
+          WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, "name", "!s", "d", NULL));
+  g_string_truncate (order, 0);
+  for (; wp_iterator_next (it, &value); g_value_unset (&value)) {
+    g_autoptr (WpProperties) p =
+        wp_session_item_get_properties (g_value_get_object (&value));
+    g_string_append (order, wp_properties_get (p, "name"));
+
+    /* removing objects during the iteration is fine */
+    if (order->len == 1)
+      wp_session_item_remove (items[1]);
+  }
+  g_assert_cmpstr (order->str, ==, "cae");
+  g_clear_pointer (&it, wp_iterator_unref);
+
+  /* integer views parse the values like atoi() does */
+  it = wp_object_manager_new_sorted_iterator (om,
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, keys,
+      WP_SORTED_VIEW_FLAG_INTEGER, NULL);
+  g_string_truncate (order, 0);
+  for (; wp_iterator_next (it, &value); g_value_unset (&value)) {
+    g_autoptr (WpProperties) p =
+        wp_session_item_get_properties (g_value_get_object (&value));
+    g_string_append (order, wp_properties_get (p, "name"));
+  }
+  g_assert_cmpstr (order->str, ==, "cdae");
+  g_clear_pointer (&it, wp_iterator_unref);
+
+  g_string_free (order, TRUE);
+}
+
+static void
+on_objects_batch (WpObjectManager * om, GPtrArray * objects, guint * counts)
+{
+  counts[0]++;
+  counts[1] += objects->len;
+}
+
+static void
+test_om_batch (TestFixture *f, gconstpointer user_data)
+{
+  g_autoptr (WpObjectManager) om = NULL;
+  WpSessionItem *items[3];
+  guint added[2] = { 0, 0 };
+  guint removed[2] = { 0, 0 };
+
+  for (guint i = 0; i < G_N_ELEMENTS (items); i++) {
+    items[i] = g_object_new (si_dummy_get_type (), "core", f->base.core, NULL);
+    g_assert_true (wp_session_item_configure (items[i],
+        wp_properties_new ("property1", "1234", NULL)));
+    wp_session_item_register (items[i]);
+  }
+
+  om = wp_object_manager_new ();
+  wp_object_manager_add_interest (om, si_dummy_get_type (), NULL);
+  g_signal_connect (om, "objects-added", G_CALLBACK (on_objects_batch), added);
+  g_signal_connect (om, "objects-removed", G_CALLBACK (on_objects_batch),
+      removed);
+  test_ensure_object_manager_is_installed (om, f->base.core, f->base.loop);
+
+  /* the initial objects are delivered at once */
+  g_assert_cmpuint (added[0], ==, 1);
+  g_assert_cmpuint (added[1], ==, 3);
+  g_assert_cmpuint (removed[0], ==, 0);
+
+  /* and so are removals */
+  wp_session_item_remove (items[0]);
+  wp_session_item_remove (items[1]);
+  g_signal_connect_swapped (om, "objects-changed",
+      G_CALLBACK (g_main_loop_quit), f->base.loop);
+  g_main_loop_run (f->base.loop);
+
+  g_assert_cmpuint (removed[0], ==, 1);
+  g_assert_cmpuint (removed[1], ==, 2);
+  g_assert_cmpuint (added[0], ==, 1);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om), ==, 1);
+}
+
+static void
+on_object_added_count (WpObjectManager * om, GObject * object, guint * count)
+{
+  (*count)++;
+}
+
+static void
+test_om_shared (TestFixture *f, gconstpointer user_data)
+{
+  g_autoptr (WpObjectManager) om1 = NULL;
+  g_autoptr (WpObjectManager) om2 = NULL;
+  g_autoptr (WpObjectManager) om3 = NULL;
+  WpSessionItem *si = NULL;
+  guint added1 = 0, added2 = 0;
+
+  si = g_object_new (si_dummy_get_type (), "core", f->base.core, NULL);
+  g_assert_true (wp_session_item_configure (si,
+      wp_properties_new ("property1", "1234", NULL)));
+  wp_session_item_register (si);
+
+  om1 = wp_object_manager_new ();
+  wp_object_manager_add_interest (om1, si_dummy_get_type (),
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, "property1", "=s", "1234", NULL);
+  g_signal_connect (om1, "object-added",
+      G_CALLBACK (on_object_added_count), &added1);
+  test_ensure_object_manager_is_installed (om1, f->base.core, f->base.loop);
+
+  /* an object manager with the same interest joins the same set
+     and still gets its own signals */
+  om2 = wp_object_manager_new ();
+  wp_object_manager_add_interest (om2, si_dummy_get_type (),
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, "property1", "=s", "1234", NULL);
+  g_signal_connect (om2, "object-added",
+      G_CALLBACK (on_object_added_count), &added2);
+  test_ensure_object_manager_is_installed (om2, f->base.core, f->base.loop);
+
+  g_assert_cmpuint (added1, ==, 1);
+  g_assert_cmpuint (added2, ==, 1);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om1), ==, 1);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om2), ==, 1);
+
+  /* a different interest does not */
+  om3 = wp_object_manager_new ();
+  wp_object_manager_add_interest (om3, si_dummy_get_type (),
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, "property1", "=s", "4321", NULL);
+  test_ensure_object_manager_is_installed (om3, f->base.core, f->base.loop);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om3), ==, 0);
+
+  /* the set survives its first user */
+  g_clear_object (&om1);
+
+  si = g_object_new (si_dummy_get_type (), "core", f->base.core, NULL);
+  g_assert_true (wp_session_item_configure (si,
+      wp_properties_new ("property1", "1234", NULL)));
+  wp_session_item_register (si);
+
+  g_assert_cmpuint (added2, ==, 2);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om2), ==, 2);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om3), ==, 0);
+}
+
+typedef struct {
+  guint n_emissions;
+  guint n_added;
+  guint n_removed;
+  WpSessionItem *added_item;
+  WpSessionItem *removed_item;
+} PendingChanges;
+
+static void
+on_objects_changed_pending (WpObjectManager * om, PendingChanges * pc)
+{
+  GPtrArray *added = NULL, *removed = NULL;
+
+  g_assert_true (wp_object_manager_get_pending_changes (om, &added, &removed));
+  g_assert_nonnull (added);
+  g_assert_nonnull (removed);
+
+  pc->n_emissions++;
+  pc->n_added = added->len;
+  pc->n_removed = removed->len;
+  pc->added_item = added->len > 0 ? g_ptr_array_index (added, 0) : NULL;
+  pc->removed_item = removed->len > 0 ? g_ptr_array_index (removed, 0) : NULL;
+}
+
+static void
+test_om_pending_changes (TestFixture *f, gconstpointer user_data)
+{
+  g_autoptr (WpObjectManager) om = NULL;
+  g_autoptr (WpSessionItem) removed_ref = NULL;
+  WpSessionItem *items[3];
+  WpSessionItem *transient;
+  PendingChanges pc = { 0, };
+  GPtrArray *added = NULL, *removed = NULL;
+
+  for (guint i = 0; i < 2; i++) {
+    items[i] = g_object_new (si_dummy_get_type (), "core", f->base.core, NULL);
+    g_assert_true (wp_session_item_configure (items[i],
+        wp_properties_new ("property1", "1234", NULL)));
+    wp_session_item_register (items[i]);
+  }
+
+  om = wp_object_manager_new ();
+  wp_object_manager_add_interest (om, si_dummy_get_type (), NULL);
+  g_signal_connect (om, "objects-changed",
+      G_CALLBACK (on_objects_changed_pending), &pc);
+  test_ensure_object_manager_is_installed (om, f->base.core, f->base.loop);
+
+  /* the initial objects are all reported as added */
+  g_assert_cmpuint (pc.n_emissions, ==, 1);
+  g_assert_cmpuint (pc.n_added, ==, 2);
+  g_assert_cmpuint (pc.n_removed, ==, 0);
+
+  /* the sets are only available while objects-changed is emitted */
+  added = removed = (GPtrArray *) 0x1;
+  g_assert_false (wp_object_manager_get_pending_changes (om, &added, &removed));
+  g_assert_null (added);
+  g_assert_null (removed);
+
+  g_signal_connect_swapped (om, "objects-changed",
+      G_CALLBACK (g_main_loop_quit), f->base.loop);
+
+  /* an object that comes and goes in the same cycle is not reported */
+  items[2] = g_object_new (si_dummy_get_type (), "core", f->base.core, NULL);
+  g_assert_true (wp_session_item_configure (items[2],
+      wp_properties_new ("property1", "5678", NULL)));
+  wp_session_item_register (items[2]);
+  transient = g_object_new (si_dummy_get_type (), "core", f->base.core, NULL);
+  g_assert_true (wp_session_item_configure (transient,
+      wp_properties_new ("property1", "0", NULL)));
+  wp_session_item_register (transient);
+  wp_session_item_remove (transient);
+  removed_ref = g_object_ref (items[0]);
+  wp_session_item_remove (items[0]);
+  g_main_loop_run (f->base.loop);
+
+  g_assert_cmpuint (pc.n_emissions, ==, 2);
+  g_assert_cmpuint (pc.n_added, ==, 1);
+  g_assert_cmpuint (pc.n_removed, ==, 1);
+  g_assert_true (pc.added_item == items[2]);
+  g_assert_true (pc.removed_item == items[0]);
+
+  g_assert_false (wp_object_manager_get_pending_changes (om, &added, NULL));
+  g_assert_null (added);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om), ==, 2);
+}
+
+static void
+test_om_add_interest_installed (TestFixture *f, gconstpointer user_data)
+{
+  g_autoptr (WpObjectManager) om1 = NULL;
+  g_autoptr (WpObjectManager) om2 = NULL;
+  g_autoptr (WpObjectManager) om3 = NULL;
+  WpSessionItem *si = NULL;
+  guint added1 = 0, added2 = 0, added3 = 0, removed1 = 0;
+
+  si = g_object_new (si_dummy_get_type (), "core", f->base.core, NULL);
+  g_assert_true (wp_session_item_configure (si,
+      wp_properties_new ("property1", "1234", NULL)));
+  wp_session_item_register (si);
+
+  si = g_object_new (si_dummy_get_type (), "core", f->base.core, NULL);
+  g_assert_true (wp_session_item_configure (si,
+      wp_properties_new ("property1", "4321", NULL)));
+  wp_session_item_register (si);
+
+  om1 = wp_object_manager_new ();
+  wp_object_manager_add_interest (om1, si_dummy_get_type (),
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, "property1", "=s", "1234", NULL);
+  g_signal_connect (om1, "object-added",
+      G_CALLBACK (on_object_added_count), &added1);
+  g_signal_connect (om1, "object-removed",
+      G_CALLBACK (on_object_added_count), &removed1);
+  test_ensure_object_manager_is_installed (om1, f->base.core, f->base.loop);
+
+  om2 = wp_object_manager_new ();
+  wp_object_manager_add_interest (om2, si_dummy_get_type (),
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, "property1", "=s", "1234", NULL);
+  g_signal_connect (om2, "object-added",
+      G_CALLBACK (on_object_added_count), &added2);
+  test_ensure_object_manager_is_installed (om2, f->base.core, f->base.loop);
+
+  g_assert_cmpuint (added1, ==, 1);
+  g_assert_cmpuint (added2, ==, 1);
+
+  /* a new interest on an installed object manager applies to the objects
+     that appear from then on; the ones that it has stay as they are */
+  wp_object_manager_add_interest (om1, si_dummy_get_type (),
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, "property1", "=s", "4321", NULL);
+  g_assert_cmpuint (added1, ==, 1);
+  g_assert_cmpuint (removed1, ==, 0);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om1), ==, 1);
+  g_assert_true (wp_object_manager_is_installed (om1));
+
+  /* and the other users of its previous set are not affected */
+  g_assert_cmpuint (added2, ==, 1);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om2), ==, 1);
+
+  /* new objects are matched against all the interests */
+  si = g_object_new (si_dummy_get_type (), "core", f->base.core, NULL);
+  g_assert_true (wp_session_item_configure (si,
+      wp_properties_new ("property1", "4321", NULL)));
+  wp_session_item_register (si);
+
+  g_assert_cmpuint (added1, ==, 2);
+  g_assert_cmpuint (removed1, ==, 0);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om1), ==, 2);
+  g_assert_cmpuint (added2, ==, 1);
+
+  /* the previous set can still be shared */
+  om3 = wp_object_manager_new ();
+  wp_object_manager_add_interest (om3, si_dummy_get_type (),
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, "property1", "=s", "1234", NULL);
+  g_signal_connect (om3, "object-added",
+      G_CALLBACK (on_object_added_count), &added3);
+  test_ensure_object_manager_is_installed (om3, f->base.core, f->base.loop);
+  g_assert_cmpuint (added3, ==, 1);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om3), ==, 1);
+
+  /* removals reach the object manager that left the set */
+  wp_session_item_remove (si);
+  g_assert_cmpuint (removed1, ==, 1);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (om1), ==, 1);
+}
+
+typedef struct {
+  TestFixture *f;
+  guint *n_installed;
+  gint64 last_id;
+  guint n_objects;
+  gboolean installed;
+} ExposeData;
+
+static void
+on_expose_object_added (WpObjectManager * om, WpGlobalProxy * proxy,
+    ExposeData * d)
+{
+  gint64 id = wp_global_proxy_get_global_id (proxy);
+
+  /* in the order that the globals appeared and before "installed" */
+  g_assert_false (d->installed);
+  g_assert_cmpint (id, >, d->last_id);
+  d->last_id = id;
+  d->n_objects++;
+}
+
+static void
+on_expose_installed (WpObjectManager * om, ExposeData * d)
+{
+  g_assert_false (d->installed);
+  d->installed = TRUE;
+  if (++(*d->n_installed) == 2)
+    g_main_loop_quit (d->f->base.loop);
+}
+
+static void
+on_expose_object_added_drop (WpObjectManager * om, WpGlobalProxy * proxy,
+    WpObjectManager ** om_ptr)
+{
+  /* drop the object manager while its globals are still being exposed */
+  g_clear_object (om_ptr);
+}
+
+static void
+test_om_expose_budget_setup (TestFixture *self, gconstpointer user_data)
+{
+  wp_base_test_fixture_setup (&self->base, WP_BASE_TEST_FLAG_DONT_CONNECT);
+
+  /* a budget this small exposes one global per main loop iteration */
+  wp_core_update_properties (self->base.core, wp_properties_new (
+      "wireplumber.expose-budget-ms", "0.00001", NULL));
+}
+
+static void
+test_om_expose_budget (TestFixture *f, gconstpointer user_data)
+{
+  g_autoptr (WpObjectManager) dropped = NULL;
+  g_autoptr (WpObjectManager) factories = NULL;
+  g_autoptr (WpObjectManager) all = NULL;
+  g_autoptr (WpIterator) it = NULL;
+  g_auto (GValue) value = G_VALUE_INIT;
+  guint n_installed = 0, n_factories = 0;
+  ExposeData fd = { f, &n_installed, -1, 0, FALSE };
+  ExposeData ad = { f, &n_installed, -1, 0, FALSE };
+
+  /* install before connecting, so that all the initial globals are exposed
+     together; the first object manager is dropped on its first object */
+  dropped = wp_object_manager_new ();
+  wp_object_manager_set_passive (dropped, TRUE);
+  wp_object_manager_add_interest (dropped, WP_TYPE_FACTORY,
+      WP_CONSTRAINT_TYPE_PW_GLOBAL_PROPERTY, PW_KEY_OBJECT_ID, "+", NULL);
+  g_signal_connect (dropped, "object-added",
+      G_CALLBACK (on_expose_object_added_drop), &dropped);
+  wp_core_install_object_manager (f->base.core, dropped);
+
+  factories = wp_object_manager_new ();
+  wp_object_manager_set_passive (factories, TRUE);
+  wp_object_manager_add_interest (factories, WP_TYPE_FACTORY, NULL);
+  g_signal_connect (factories, "object-added",
+      G_CALLBACK (on_expose_object_added), &fd);
+  g_signal_connect (factories, "installed",
+      G_CALLBACK (on_expose_installed), &fd);
+  wp_core_install_object_manager (f->base.core, factories);
+
+  all = wp_object_manager_new ();
+  wp_object_manager_set_passive (all, TRUE);
+  wp_object_manager_add_interest (all, WP_TYPE_GLOBAL_PROXY, NULL);
+  g_signal_connect (all, "object-added",
+      G_CALLBACK (on_expose_object_added), &ad);
+  g_signal_connect (all, "installed",
+      G_CALLBACK (on_expose_installed), &ad);
+  wp_core_install_object_manager (f->base.core, all);
+
+  g_assert_true (wp_core_connect (f->base.core));
+  g_main_loop_run (f->base.loop);
+
+  g_assert_null (dropped);
+  g_assert_true (fd.installed);
+  g_assert_true (ad.installed);
+  g_assert_cmpuint (fd.n_objects, >, 1);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (factories), ==,
+      fd.n_objects);
+  g_assert_cmpuint (wp_object_manager_get_n_objects (all), ==, ad.n_objects);
+
+  /* no global was skipped after the first object manager was dropped */
+  it = wp_object_manager_new_filtered_iterator (all, WP_TYPE_FACTORY, NULL);
+  for (; wp_iterator_next (it, &value); g_value_unset (&value))
+    n_factories++;
+  g_assert_cmpuint (n_factories, ==, fd.n_objects);
+}
+
 gint
 main (gint argc, gchar *argv[])
 {
@@ -168,6 +829,24 @@ main (gint argc, gchar *argv[])
       test_om_setup, test_om_interest_on_pw_props, test_om_teardown);
   g_test_add ("/wp/om/iterate_remove", TestFixture, NULL,
       test_om_setup, test_om_iterate_remove, test_om_teardown);
+  g_test_add ("/wp/om/dispatch", TestFixture, NULL,
+      test_om_setup, test_om_dispatch, test_om_teardown);
+  g_test_add ("/wp/om/remove_middle", TestFixture, NULL,
+      test_om_setup, test_om_remove_middle, test_om_teardown);
+  g_test_add ("/wp/om/index", TestFixture, NULL,
+      test_om_setup, test_om_index, test_om_teardown);
+  g_test_add ("/wp/om/sorted_view", TestFixture, NULL,
+      test_om_setup, test_om_sorted_view, test_om_teardown);
+  g_test_add ("/wp/om/batch", TestFixture, NULL,
+      test_om_setup, test_om_batch, test_om_teardown);
+  g_test_add ("/wp/om/shared", TestFixture, NULL,
+      test_om_setup, test_om_shared, test_om_teardown);
+  g_test_add ("/wp/om/add_interest_installed", TestFixture, NULL,
+      test_om_setup, test_om_add_interest_installed, test_om_teardown);
+  g_test_add ("/wp/om/pending_changes", TestFixture, NULL,
+      test_om_setup, test_om_pending_changes, test_om_teardown);
+  g_test_add ("/wp/om/expose_budget", TestFixture, NULL,
+      test_om_expose_budget_setup, test_om_expose_budget, test_om_teardown);
 
   return g_test_run ();
 }
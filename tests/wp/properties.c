@@ -138,6 +138,17 @@ test_properties_to_pw_props (void)
   pw_properties_free (props);
 }
 
+static gboolean
+check_property (const gchar * key, const gchar * value, gpointer data)
+{
+  gint *i = data;
+  g_autofree gchar *expected_key = g_strdup_printf ("key%d", *i);
+  g_autofree gchar *expected_value = g_strdup_printf ("value%d", *i);
+  g_assert_cmpstr (expected_value, ==, value);
+  g_assert_cmpstr (expected_key, ==, key);
+  return (++(*i) < 3);
+}
+
 static void
 test_properties_iterate (void)
 {
@@ -165,6 +176,355 @@ test_properties_iterate (void)
     i++;
   }
   g_assert_cmpint (i, ==, 5);
+
+  /* foreach, stopping after 3 items */
+  i = 0;
+  g_assert_false (wp_properties_foreach (p, check_property, &i));
+  g_assert_cmpint (i, ==, 3);
+}
+
+static void
+test_properties_large (void)
+{
+  g_autoptr (WpProperties) p = wp_properties_new_empty ();
+  g_autoptr (WpProperties) u = wp_properties_new_empty ();
+  const gchar *keys[] = { "key.5", "key.99", "key.nonexistent", NULL };
+
+  for (guint i = 0; i < 100; i++) {
+    g_autofree gchar *key = g_strdup_printf ("key.%u", i);
+    g_autofree gchar *value = g_strdup_printf ("value.%u", i);
+    g_assert_cmpint (wp_properties_set (p, key, value), ==, 1);
+  }
+  g_assert_cmpuint (wp_properties_get_count (p), ==, 100);
+  g_assert_cmpstr (wp_properties_get (p, "key.0"), ==, "value.0");
+  g_assert_cmpstr (wp_properties_get (p, "key.77"), ==, "value.77");
+  g_assert_null (wp_properties_get (p, "key.100"));
+
+  /* same value, new value, new key */
+  g_assert_cmpint (wp_properties_set (p, "key.10", "value.10"), ==, 0);
+  g_assert_cmpint (wp_properties_set (p, "key.10", "changed"), ==, 1);
+  g_assert_cmpint (wp_properties_setf (p, "key.100", "value.%d", 100), ==, 1);
+  g_assert_cmpstr (wp_properties_get (p, "key.10"), ==, "changed");
+  g_assert_cmpstr (wp_properties_get (p, "key.100"), ==, "value.100");
+  g_assert_cmpuint (wp_properties_get_count (p), ==, 101);
+
+  /* removal moves the items that follow */
+  g_assert_cmpint (wp_properties_set (p, "key.3", NULL), ==, 1);
+  g_assert_null (wp_properties_get (p, "key.3"));
+  g_assert_cmpstr (wp_properties_get (p, "key.4"), ==, "value.4");
+  g_assert_cmpstr (wp_properties_get (p, "key.100"), ==, "value.100");
+
+  wp_properties_sort (p);
+  g_assert_cmpstr (wp_properties_get (p, "key.42"), ==, "value.42");
+
+  /* bulk updates */
+  wp_properties_set (u, "key.5", "updated");
+  wp_properties_set (u, "key.99", "value.99");
+  wp_properties_set (u, "key.3", "re-added");
+  g_assert_cmpint (wp_properties_update (p, u), ==, 2);
+  g_assert_cmpstr (wp_properties_get (p, "key.5"), ==, "updated");
+  g_assert_cmpstr (wp_properties_get (p, "key.3"), ==, "re-added");
+
+  wp_properties_set (u, "key.5", "not-added");
+  wp_properties_set (u, "key.101", "added");
+  g_assert_cmpint (wp_properties_add (p, u), ==, 1);
+  g_assert_cmpstr (wp_properties_get (p, "key.5"), ==, "updated");
+  g_assert_cmpstr (wp_properties_get (p, "key.101"), ==, "added");
+
+  g_assert_cmpint (wp_properties_update_keys_array (p, u, keys), ==, 1);
+  g_assert_cmpstr (wp_properties_get (p, "key.5"), ==, "not-added");
+  g_assert_cmpuint (wp_properties_get_count (p), ==, 102);
+}
+
+static void
+test_properties_copy_on_write (void)
+{
+  g_autoptr (WpProperties) p = NULL;
+  g_autoptr (WpProperties) c1 = NULL;
+  g_autoptr (WpProperties) c2 = NULL;
+  struct pw_properties *pw_p;
+
+  p = wp_properties_new ("key1", "value1", "key2", "value2", NULL);
+
+  /* copies share the storage until they are modified */
+  c1 = wp_properties_copy (p);
+  c2 = wp_properties_ensure_unique_owner (wp_properties_ref (p));
+  g_assert_true (c1 != p);
+  g_assert_true (c2 != p);
+  g_assert_true (wp_properties_peek_dict (c1) == wp_properties_peek_dict (p));
+  g_assert_true (wp_properties_peek_dict (c2) == wp_properties_peek_dict (p));
+
+  /* setting the same value is not a modification */
+  g_assert_cmpint (wp_properties_set (c1, "key1", "value1"), ==, 0);
+  g_assert_true (wp_properties_peek_dict (c1) == wp_properties_peek_dict (p));
+
+  g_assert_cmpint (wp_properties_set (c1, "key1", "changed"), ==, 1);
+  g_assert_true (wp_properties_peek_dict (c1) != wp_properties_peek_dict (p));
+  g_assert_cmpstr (wp_properties_get (c1, "key1"), ==, "changed");
+  g_assert_cmpstr (wp_properties_get (p, "key1"), ==, "value1");
+  g_assert_cmpstr (wp_properties_get (c2, "key1"), ==, "value1");
+
+  /* the original can go away while a copy still uses the storage */
+  g_clear_pointer (&p, wp_properties_unref);
+  g_assert_cmpstr (wp_properties_get (c2, "key2"), ==, "value2");
+  g_assert_cmpint (wp_properties_set (c2, "key3", "value3"), ==, 1);
+  g_assert_cmpuint (wp_properties_get_count (c2), ==, 3);
+
+  /* taking the pw_properties of a shared set gives a private copy */
+  p = wp_properties_copy (c1);
+  pw_p = wp_properties_unref_and_take_pw_properties (g_steal_pointer (&p));
+  g_assert_true (&pw_p->dict != wp_properties_peek_dict (c1));
+  g_assert_cmpstr (pw_properties_get (pw_p, "key1"), ==, "changed");
+  pw_properties_free (pw_p);
+  g_assert_cmpstr (wp_properties_get (c1, "key1"), ==, "changed");
+}
+
+static void
+test_properties_builder (void)
+{
+  g_autoptr (WpPropertiesBuilder) b = wp_properties_builder_new (4);
+  g_autoptr (WpProperties) p = NULL;
+  struct pw_properties *pw_p;
+  const struct spa_dict *dict;
+  const struct spa_dict_item dict_items[] = {
+    { "key.b", "from-dict" },
+    { "key.d", "value.d" },
+  };
+  const struct spa_dict d = SPA_DICT_INIT_ARRAY (dict_items);
+
+  wp_properties_builder_add (b, "key.c", "value.c");
+  wp_properties_builder_add (b, "key.b", "value.b");
+  wp_properties_builder_add_dict (b, &d);
+  wp_properties_builder_add (b, "key.a", "value.a");
+  wp_properties_builder_add (b, "key.d", "last");
+  wp_properties_builder_add (b, "key.e", NULL);
+  wp_properties_builder_add (b, "", "empty");
+
+  p = wp_properties_builder_end (g_steal_pointer (&b));
+  g_assert_nonnull (p);
+  g_assert_cmpuint (wp_properties_get_count (p), ==, 4);
+
+  /* sorted, with the last added value of each key */
+  dict = wp_properties_peek_dict (p);
+  g_assert_cmpstr (dict->items[0].key, ==, "key.a");
+  g_assert_cmpstr (dict->items[1].key, ==, "key.b");
+  g_assert_cmpstr (dict->items[1].value, ==, "from-dict");
+  g_assert_cmpstr (dict->items[2].key, ==, "key.c");
+  g_assert_cmpstr (dict->items[3].key, ==, "key.d");
+  g_assert_cmpstr (dict->items[3].value, ==, "last");
+  g_assert_null (wp_properties_get (p, "key.e"));
+
+  /* the result can be modified as usual */
+  g_assert_cmpint (wp_properties_set (p, "key.0", "appended"), ==, 1);
+  g_assert_cmpstr (wp_properties_get (p, "key.0"), ==, "appended");
+  g_assert_cmpstr (wp_properties_get (p, "key.c"), ==, "value.c");
+
+  /* removing an item does not hide the ones that are moved */
+  g_clear_pointer (&p, wp_properties_unref);
+  b = wp_properties_builder_new (4);
+  wp_properties_builder_add (b, "a", "1");
+  wp_properties_builder_add (b, "b", "2");
+  wp_properties_builder_add (b, "c", "3");
+  wp_properties_builder_add (b, "d", "4");
+  p = wp_properties_builder_end (g_steal_pointer (&b));
+  g_assert_cmpint (wp_properties_set (p, "a", NULL), ==, 1);
+  g_assert_null (wp_properties_get (p, "a"));
+  g_assert_cmpstr (wp_properties_get (p, "b"), ==, "2");
+  g_assert_cmpstr (wp_properties_get (p, "c"), ==, "3");
+  g_assert_cmpstr (wp_properties_get (p, "d"), ==, "4");
+  g_clear_pointer (&p, wp_properties_unref);
+
+  /* taking the pw_properties drops the sorted flag, as pw_properties_set()
+     may append to them without clearing it */
+  b = wp_properties_builder_new (2);
+  wp_properties_builder_add (b, "b", "2");
+  wp_properties_builder_add (b, "c", "3");
+  pw_p = wp_properties_unref_and_take_pw_properties (
+      wp_properties_builder_end (g_steal_pointer (&b)));
+  g_assert_cmpuint (pw_p->dict.flags & SPA_DICT_FLAG_SORTED, ==, 0);
+  pw_properties_set (pw_p, "a", "1");
+  g_assert_cmpstr (spa_dict_lookup (&pw_p->dict, "a"), ==, "1");
+  pw_properties_free (pw_p);
+}
+
+static void
+test_properties_atoms (void)
+{
+  g_autoptr (WpProperties) p = NULL;
+  g_autoptr (WpProperties) w = NULL;
+
+  g_assert_cmpint (wp_prop_key_from_string (PW_KEY_MEDIA_CLASS), ==,
+      WP_PROP_KEY_MEDIA_CLASS);
+  g_assert_cmpint (wp_prop_key_from_string ("not.well.known"), ==,
+      WP_PROP_KEY_NONE);
+  g_assert_cmpstr (wp_prop_key_to_string (WP_PROP_KEY_NODE_NAME), ==,
+      PW_KEY_NODE_NAME);
+
+  p = wp_properties_new (
+      PW_KEY_NODE_NAME, "test-node",
+      PW_KEY_MEDIA_CLASS, "Audio/Sink",
+      "foo", "bar",
+      NULL);
+  g_assert_cmpstr (wp_properties_get_by_atom (p, WP_PROP_KEY_MEDIA_CLASS), ==,
+      "Audio/Sink");
+  g_assert_null (wp_properties_get_by_atom (p, WP_PROP_KEY_OBJECT_ID));
+
+  /* the atoms follow modifications */
+  wp_properties_set (p, PW_KEY_OBJECT_ID, "10");
+  wp_properties_set (p, PW_KEY_MEDIA_CLASS, "Audio/Source");
+  g_assert_cmpstr (wp_properties_get_by_atom (p, WP_PROP_KEY_OBJECT_ID), ==,
+      "10");
+  g_assert_cmpstr (wp_properties_get_by_atom (p, WP_PROP_KEY_MEDIA_CLASS), ==,
+      "Audio/Source");
+
+  wp_properties_set (p, PW_KEY_NODE_NAME, NULL);
+  g_assert_null (wp_properties_get_by_atom (p, WP_PROP_KEY_NODE_NAME));
+  g_assert_cmpstr (wp_properties_get_by_atom (p, WP_PROP_KEY_OBJECT_ID), ==,
+      "10");
+
+  wp_properties_sort (p);
+  g_assert_cmpstr (wp_properties_get_by_atom (p, WP_PROP_KEY_MEDIA_CLASS), ==,
+      "Audio/Source");
+
+  /* wrapped dicts fall back to a string lookup */
+  w = wp_properties_new_wrap_dict (wp_properties_peek_dict (p));
+  g_assert_cmpstr (wp_properties_get_by_atom (w, WP_PROP_KEY_OBJECT_ID), ==,
+      "10");
+}
+
+static void
+count_diff (const gchar * key, const gchar * old_value,
+    const gchar * new_value, gpointer data)
+{
+  guint *counts = data;
+
+  if (!old_value) {
+    g_assert_cmpstr (key, ==, "added");
+    counts[0]++;
+  } else if (!new_value) {
+    g_assert_cmpstr (key, ==, "removed");
+    counts[2]++;
+  } else {
+    g_assert_cmpstr (key, ==, "changed");
+    g_assert_cmpstr (old_value, ==, "old");
+    g_assert_cmpstr (new_value, ==, "new");
+    counts[1]++;
+  }
+}
+
+static void
+test_properties_diff (void)
+{
+  g_autoptr (WpProperties) a = NULL;
+  g_autoptr (WpProperties) b = NULL;
+  guint counts[3] = { 0, 0, 0 };
+
+  a = wp_properties_new (
+      "same", "value", "changed", "old", "removed", "value", NULL);
+  b = wp_properties_new (
+      "changed", "new", "same", "value", "added", "value", NULL);
+
+  g_assert_cmpuint (wp_properties_diff (a, b, count_diff, counts), ==, 3);
+  g_assert_cmpuint (counts[0], ==, 1);
+  g_assert_cmpuint (counts[1], ==, 1);
+  g_assert_cmpuint (counts[2], ==, 1);
+
+  g_assert_cmpuint (wp_properties_diff (a, a, NULL, NULL), ==, 0);
+  g_assert_cmpuint (wp_properties_diff (NULL, b, NULL, NULL), ==, 3);
+  g_assert_cmpuint (wp_properties_diff (a, NULL, NULL, NULL), ==, 3);
+}
+
+static void
+test_properties_intern (void)
+{
+  g_autoptr (WpProperties) a = NULL;
+  g_autoptr (WpProperties) b = NULL;
+  g_autoptr (WpProperties) c = NULL;
+  g_autoptr (WpProperties) d = NULL;
+  g_autoptr (WpPropertiesBuilder) builder = NULL;
+  WpPropertiesPoolStats before, stats;
+  const struct spa_dict_item items_a[] = {
+    { "test.intern.key", "test-intern-shared" },
+    { "test.intern.a", "test-intern-a" },
+  };
+  const struct spa_dict_item items_b[] = {
+    { "test.intern.key", "test-intern-shared" },
+    { "test.intern.b", "test-intern-b" },
+  };
+  const struct spa_dict dict_a = SPA_DICT_INIT_ARRAY (items_a);
+  const struct spa_dict dict_b = SPA_DICT_INIT_ARRAY (items_b);
+
+  wp_properties_get_pool_stats (&before);
+
+  a = wp_properties_new_intern_dict (&dict_a);
+  b = wp_properties_new_intern_dict (&dict_b);
+  g_assert_cmpuint (wp_properties_get_count (a), ==, 2);
+  g_assert_cmpstr (wp_properties_get (a, "test.intern.a"), ==, "test-intern-a");
+  g_assert_cmpstr (wp_properties_get (b, "test.intern.b"), ==, "test-intern-b");
+
+  /* repeated keys and values are stored once */
+  g_assert_true (wp_properties_get (a, "test.intern.key") ==
+      wp_properties_get (b, "test.intern.key"));
+  g_assert_true (wp_properties_peek_dict (a)->items[0].key ==
+      wp_properties_peek_dict (b)->items[0].key);
+
+  wp_properties_get_pool_stats (&stats);
+  g_assert_cmpuint (stats.n_strings, ==, before.n_strings + 6);
+  g_assert_cmpuint (stats.n_refs, ==, before.n_refs + 8);
+  g_assert_cmpuint (stats.saved, ==, before.saved +
+      sizeof ("test.intern.key") + sizeof ("test-intern-shared"));
+
+  /* copies share the interned storage until they are modified */
+  c = wp_properties_copy (a);
+  g_assert_true (wp_properties_peek_dict (c) == wp_properties_peek_dict (a));
+  g_assert_cmpint (wp_properties_set (c, "test.intern.a", "test-intern-a"),
+      ==, 0);
+  g_assert_true (wp_properties_peek_dict (c) == wp_properties_peek_dict (a));
+  g_assert_cmpint (wp_properties_set (c, "test.intern.a", "changed"), ==, 1);
+  g_assert_cmpstr (wp_properties_get (c, "test.intern.a"), ==, "changed");
+  g_assert_cmpstr (wp_properties_get (a, "test.intern.a"), ==, "test-intern-a");
+
+  wp_properties_get_pool_stats (&stats);
+  g_assert_cmpuint (stats.n_refs, ==, before.n_refs + 8);
+
+  /* interned sets are immutable; they are modified through a copy, which
+     releases the interned strings when it is first modified */
+  {
+    WpProperties *orig = a;
+    a = wp_properties_ensure_unique_owner (wp_properties_ref (a));
+    g_assert_true (a != orig);
+    wp_properties_unref (orig);
+  }
+  g_assert_cmpint (wp_properties_set (a, "test.intern.c", "test-intern-c"),
+      ==, 1);
+  g_assert_cmpstr (wp_properties_get (a, "test.intern.a"), ==, "test-intern-a");
+  g_assert_cmpstr (wp_properties_get (a, "test.intern.c"), ==, "test-intern-c");
+
+  wp_properties_get_pool_stats (&stats);
+  g_assert_cmpuint (stats.n_strings, ==, before.n_strings + 4);
+  g_assert_cmpuint (stats.n_refs, ==, before.n_refs + 4);
+  g_assert_cmpuint (stats.saved, ==, before.saved);
+
+  /* the builder can also intern */
+  builder = wp_properties_builder_new (2);
+  wp_properties_builder_add (builder, "test.intern.key", "test-intern-shared");
+  wp_properties_builder_add (builder, "test.intern.b", "test-intern-b");
+  d = wp_properties_builder_end_intern (g_steal_pointer (&builder));
+  g_assert_true (wp_properties_get (d, "test.intern.b") ==
+      wp_properties_get (b, "test.intern.b"));
+  g_assert_cmpuint (wp_properties_peek_dict (d)->flags & SPA_DICT_FLAG_SORTED,
+      ==, SPA_DICT_FLAG_SORTED);
+
+  g_clear_pointer (&a, wp_properties_unref);
+  g_clear_pointer (&b, wp_properties_unref);
+  g_clear_pointer (&c, wp_properties_unref);
+  g_clear_pointer (&d, wp_properties_unref);
+
+  wp_properties_get_pool_stats (&stats);
+  g_assert_cmpuint (stats.n_strings, ==, before.n_strings);
+  g_assert_cmpuint (stats.n_refs, ==, before.n_refs);
+  g_assert_cmpuint (stats.size, ==, before.size);
+  g_assert_cmpuint (stats.saved, ==, before.saved);
 }
 
 int
@@ -180,6 +540,13 @@ main (int argc, char *argv[])
   g_test_add_func ("/wp/properties/take", test_properties_take);
   g_test_add_func ("/wp/properties/to_pw_props", test_properties_to_pw_props);
   g_test_add_func ("/wp/properties/iterate", test_properties_iterate);
+  g_test_add_func ("/wp/properties/large", test_properties_large);
+  g_test_add_func ("/wp/properties/copy-on-write",
+      test_properties_copy_on_write);
+  g_test_add_func ("/wp/properties/builder", test_properties_builder);
+  g_test_add_func ("/wp/properties/atoms", test_properties_atoms);
+  g_test_add_func ("/wp/properties/diff", test_properties_diff);
+  g_test_add_func ("/wp/properties/intern", test_properties_intern);
 
   return g_test_run ();
 }
@@ -200,6 +200,82 @@ test_node (TestFixture *f, gconstpointer data)
   g_main_loop_run (f->base.loop);
 }
 
+static WpNode *
+test_node_ports_create (TestFixture *f, const gchar *name)
+{
+  WpNode *node = wp_node_new_from_factory (f->base.core,
+      "spa-node-factory",
+      wp_properties_new (
+          "factory.name", "audiotestsrc",
+          "node.name", name,
+          NULL));
+  g_assert_nonnull (node);
+
+  /* the ports feature is requested together with the node, while the
+     ports of the node are still being announced by the server */
+  wp_object_activate (WP_OBJECT (node),
+      WP_PIPEWIRE_OBJECT_FEATURES_MINIMAL | WP_NODE_FEATURE_PORTS,
+      NULL, (GAsyncReadyCallback) test_object_activate_finish_cb, f);
+  g_main_loop_run (f->base.loop);
+
+  g_assert_cmphex (wp_object_get_active_features (WP_OBJECT (node)), ==,
+      WP_PIPEWIRE_OBJECT_FEATURES_MINIMAL | WP_NODE_FEATURE_PORTS);
+  return node;
+}
+
+static void
+test_node_ports_check (WpNode *node)
+{
+  g_autoptr (WpIterator) it = NULL;
+  g_auto (GValue) val = G_VALUE_INIT;
+  WpPort *port;
+
+  g_assert_cmpuint (wp_node_get_n_ports (node), ==, 1);
+  g_assert_cmpuint (wp_node_get_n_output_ports (node, NULL), ==, 1);
+
+  it = wp_node_new_ports_iterator (node);
+  g_assert_true (wp_iterator_next (it, &val));
+  port = g_value_get_object (&val);
+  g_assert_true (WP_IS_PORT (port));
+  g_assert_cmphex (wp_object_get_active_features (WP_OBJECT (port)) &
+      WP_PIPEWIRE_OBJECT_FEATURES_MINIMAL, ==,
+      WP_PIPEWIRE_OBJECT_FEATURES_MINIMAL);
+  g_assert_cmpint (wp_port_get_direction (port), ==, WP_DIRECTION_OUTPUT);
+}
+
+static void
+test_node_ports (TestFixture *f, gconstpointer data)
+{
+  g_autoptr (WpNode) node1 = NULL;
+  g_autoptr (WpNode) node2 = NULL;
+
+  /* load audiotestsrc on the server side */
+  {
+    g_autoptr (WpTestServerLocker) lock =
+        wp_test_server_locker_new (&f->base.server);
+
+    g_assert_cmpint (pw_context_add_spa_lib (f->base.server.context,
+            "audiotestsrc", "audiotestsrc/libspa-audiotestsrc"), ==, 0);
+    if (!test_is_spa_lib_installed (&f->base, "audiotestsrc")) {
+      g_test_skip ("The pipewire audiotestsrc factory was not found");
+      return;
+    }
+
+    g_assert_nonnull (pw_context_load_module (f->base.server.context,
+            "libpipewire-module-spa-node-factory", NULL, NULL));
+  }
+
+  /* the first node creates the port index */
+  node1 = test_node_ports_create (f, "audiotestsrc0");
+  test_node_ports_check (node1);
+
+  /* the second one is created after the index exists and must not
+     see its ports feature enabled before its port is ready */
+  node2 = test_node_ports_create (f, "audiotestsrc1");
+  test_node_ports_check (node2);
+  test_node_ports_check (node1);
+}
+
 static void
 activate_error_cb (WpObject * object, GAsyncResult * res,
     WpBaseTestFixture * f)
@@ -295,6 +371,8 @@ main (gint argc, gchar *argv[])
       test_proxy_setup, test_proxy_basic, test_proxy_teardown);
   g_test_add ("/wp/proxy/node", TestFixture, NULL,
       test_proxy_setup, test_node, test_proxy_teardown);
+  g_test_add ("/wp/proxy/node_ports", TestFixture, NULL,
+      test_proxy_setup, test_node_ports, test_proxy_teardown);
   g_test_add ("/wp/proxy/link_error", TestFixture, NULL,
       test_proxy_setup, test_link_error, test_proxy_teardown);
   g_test_add ("/wp/proxy/enum_params_error", TestFixture, NULL,
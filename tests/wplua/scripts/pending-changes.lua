@@ -0,0 +1,42 @@
+Script.async_activation = true
+
+local m = nil
+local step = 0
+
+local om = ObjectManager {
+  Interest {
+    type = "metadata",
+    Constraint { "metadata.name", "=", "test-pending", type = "pw-global" },
+  }
+}
+
+om:connect("installed", function (om)
+  m = ImplMetadata ("test-pending")
+  m:activate (Features.ALL, function (_, e)
+    assert (e == nil)
+  end)
+end)
+
+om:connect("objects-changed", function (om)
+  local added, removed = om:get_pending_changes ()
+  step = step + 1
+
+  if step == 1 then
+    assert (#added == 1)
+    assert (added[1] == m)
+    assert (#removed == 0)
+    m:deactivate (Features.ALL)
+  elseif step == 2 then
+    assert (#added == 0)
+    assert (#removed == 1)
+    assert (removed[1] == m)
+    Script:finish_activation ()
+  end
+end)
+
+om:activate ()
+
+-- the changes are only available while objects-changed is emitted
+local added, removed = om:get_pending_changes ()
+assert (added == nil)
+assert (removed == nil)
@@ -0,0 +1,59 @@
+local m = ImplMetadata ("test-props", {
+  ["test.answer"] = "42",
+  ["test.name"] = "test-props",
+})
+local props = m.properties
+
+-- properties of objects are read-only userdata
+assert (type (props) == "userdata")
+
+-- key lookup
+assert (props["test.answer"] == "42")
+assert (props["test.name"] == "test-props")
+assert (props["test.missing"] == nil)
+assert (props[1] == nil)
+
+-- length and iteration
+assert (#props == 2)
+local n = 0
+for k, v in pairs (props) do
+  assert (props[k] == v)
+  n = n + 1
+end
+assert (n == 2)
+
+-- methods are looked up after the keys
+local t = props:to_table ()
+assert (type (t) == "table")
+assert (t["test.answer"] == "42")
+assert (t["test.name"] == "test-props")
+t["test.answer"] = "43"
+assert (props["test.answer"] == "42")
+
+-- modifying raises an error and leaves the properties intact
+local ok, err = pcall (function () props["test.answer"] = "43" end)
+assert (not ok)
+assert (string.find (err, "read-only", 1, true) ~= nil)
+assert (props["test.answer"] == "42")
+
+-- the userdata can be passed where a properties table is expected
+local interest = Interest {
+  type = "properties",
+  Constraint { "test.answer", "=", "42" },
+}
+assert (interest:matches (props))
+interest = Interest {
+  type = "properties",
+  Constraint { "test.answer", "=", "43" },
+}
+assert (not interest:matches (props))
+assert (interest:matches (t))
+
+local added, changed, removed = Properties.diff (props, t)
+assert (next (added) == nil)
+assert (changed["test.answer"] == "43")
+assert (next (removed) == nil)
+
+local m2 = ImplMetadata ("test-props-2", props)
+assert (m2.properties["test.answer"] == "42")
+assert (m2.properties["test.name"] == "test-props")
@@ -0,0 +1,27 @@
+local old = {
+  ["node.name"] = "test-node",
+  ["node.description"] = "Test Node",
+  ["media.class"] = "Audio/Sink",
+}
+local new = {
+  ["node.name"] = "test-node",
+  ["node.description"] = "Renamed Node",
+  ["node.nick"] = "Test",
+}
+
+local added, changed, removed = Properties.diff (old, new)
+assert (added["node.nick"] == "Test")
+assert (changed["node.description"] == "Renamed Node")
+assert (removed["media.class"] == "Audio/Sink")
+assert (changed["node.name"] == nil)
+assert (added["node.name"] == nil)
+assert (removed["node.name"] == nil)
+
+added, changed, removed = Properties.diff (old, old)
+assert (next (added) == nil)
+assert (next (changed) == nil)
+assert (next (removed) == nil)
+
+added, changed, removed = Properties.diff (nil, old)
+assert (added["media.class"] == "Audio/Sink")
+assert (next (removed) == nil)
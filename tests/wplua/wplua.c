@@ -9,6 +9,8 @@
 #include "lua.h"
 #include <wplua/wplua.h>
 #include <wp/wp.h>
+#include <glib/gstdio.h>
+#include <utime.h>
 
 enum {
   PROP_0,
@@ -292,6 +294,33 @@ test_wplua_construct ()
   g_assert_cmpint (obj->ref_count, ==, 1);
 }
 
+static void
+test_wplua_object_identity ()
+{
+  g_autoptr (GObject) obj = NULL;
+  lua_State *L = wplua_new ();
+
+  obj = g_object_new (TEST_TYPE_OBJECT, NULL);
+
+  /* pushing the same object twice gives the same userdata */
+  wplua_pushobject (L, g_object_ref (obj));
+  wplua_pushobject (L, g_object_ref (obj));
+  g_assert_true (lua_rawequal (L, -1, -2));
+  g_assert_cmpint (obj->ref_count, ==, 2);
+
+  /* once collected, a new userdata is created */
+  lua_pop (L, 2);
+  lua_gc (L, LUA_GCCOLLECT, 0);
+  g_assert_cmpint (obj->ref_count, ==, 1);
+
+  wplua_pushobject (L, g_object_ref (obj));
+  g_assert_true (wplua_toobject (L, -1) == (gpointer) obj);
+  g_assert_cmpint (obj->ref_count, ==, 2);
+
+  wplua_unref (L);
+  g_assert_cmpint (obj->ref_count, ==, 1);
+}
+
 static void
 test_wplua_properties ()
 {
@@ -344,6 +373,54 @@ test_wplua_properties ()
   wplua_unref (L);
 }
 
+static int
+l_gobject_type_name (lua_State * L)
+{
+  GObject *obj = wplua_checkobject (L, 1, G_TYPE_OBJECT);
+  lua_pushstring (L, G_OBJECT_TYPE_NAME (obj));
+  return 1;
+}
+
+static const luaL_Reg l_gobject_methods[] = {
+  { "type_name", l_gobject_type_name },
+  { NULL, NULL }
+};
+
+static void
+test_wplua_methods ()
+{
+  g_autoptr (GError) error = NULL;
+  lua_State *L = wplua_new ();
+
+  wplua_register_type_methods(L, TEST_TYPE_OBJECT,
+      l_test_object_new, l_test_object_methods);
+
+  const gchar code[] =
+    "o = TestObject_new()\n"
+    "o['test-boolean'] = false\n"
+    "for i = 1, 3 do\n"
+    "  o:toggle()\n"
+    "end\n"
+    "assert (o['test-boolean'] == true)\n"
+    "assert (o.toggle == o.toggle)\n"
+    "assert (o.type_name == nil)\n"
+    "assert (o.nonexistent == nil)\n";
+  test_load_and_call (L, code, sizeof (code) - 1, 0, 0, &error);
+  g_assert_no_error (error);
+
+  /* methods registered later on a parent type are found as well */
+  wplua_register_type_methods(L, G_TYPE_OBJECT, NULL, l_gobject_methods);
+
+  const gchar code2[] =
+    "assert (o:type_name() == 'TestObject')\n"
+    "o:toggle()\n"
+    "assert (o['test-boolean'] == false)\n";
+  test_load_and_call (L, code2, sizeof (code2) - 1, 0, 0, &error);
+  g_assert_no_error (error);
+
+  wplua_unref (L);
+}
+
 static void
 test_wplua_closure ()
 {
@@ -423,6 +500,65 @@ test_wplua_signals ()
   wplua_unref (L);
 }
 
+static void
+test_wplua_profiler ()
+{
+  GClosure *closure;
+  g_autoptr (GError) error = NULL;
+  g_autofree gchar *report = NULL;
+  g_autofree gchar *folded = NULL;
+  lua_State *L = wplua_new ();
+
+  const gchar code[] =
+    "n = 0\n"
+    "function f()\n"
+    "  for i = 1, 100000 do n = n + 1 end\n"
+    "end\n";
+  test_load_and_call (L, code, sizeof (code) - 1, 0, 0, &error);
+  g_assert_no_error (error);
+
+  lua_getglobal (L, "f");
+  closure = wplua_function_to_closure (L, -1);
+  g_closure_ref (closure);
+  g_closure_sink (closure);
+  lua_pop (L, 1);
+
+  /* not measured, the profiler is not started */
+  g_closure_invoke (closure, NULL, 0, NULL, NULL);
+
+  wplua_profiler_start (L, WP_LUA_PROFILER_SAMPLING);
+  for (guint i = 0; i < 3; i++)
+    g_closure_invoke (closure, NULL, 0, NULL, NULL);
+  wplua_profiler_stop (L);
+
+  /* not measured, the profiler is stopped */
+  g_closure_invoke (closure, NULL, 0, NULL, NULL);
+
+  wplua_profiler_push_stats (L);
+  g_assert_cmpint (lua_rawlen (L, -1), ==, 1);
+  g_assert_cmpint (lua_rawgeti (L, -1, 1), ==, LUA_TTABLE);
+  g_assert_cmpint (lua_getfield (L, -1, "line"), ==, LUA_TNUMBER);
+  g_assert_cmpint (lua_tointeger (L, -1), ==, 2);
+  g_assert_cmpint (lua_getfield (L, -2, "calls"), ==, LUA_TNUMBER);
+  g_assert_cmpint (lua_tointeger (L, -1), ==, 3);
+  g_assert_cmpint (lua_getfield (L, -3, "wall_time"), ==, LUA_TNUMBER);
+  g_assert_cmpint (lua_tointeger (L, -1), >, 0);
+  lua_pop (L, 5);
+
+  report = wplua_profiler_dump (L);
+  g_assert_nonnull (g_strstr_len (report, -1, "Lua profile per function:"));
+  folded = wplua_profiler_dump_folded (L);
+  g_assert_nonnull (g_strstr_len (folded, -1, ":2("));
+
+  wplua_profiler_reset (L);
+  wplua_profiler_push_stats (L);
+  g_assert_cmpint (lua_rawlen (L, -1), ==, 0);
+  lua_pop (L, 1);
+
+  wplua_unref (L);
+  g_closure_unref (closure);
+}
+
 static void
 test_wplua_sandbox_script ()
 {
@@ -702,6 +838,106 @@ test_wplua_script_arguments ()
   wplua_unref (L);
 }
 
+static gint
+load_path_and_get_x (const gchar *path, const gchar *cache_dir)
+{
+  g_autoptr (GError) error = NULL;
+  lua_State *L = wplua_new ();
+  gint ret;
+
+  wplua_enable_bytecode_cache (L, cache_dir);
+  g_assert_true (wplua_load_path (L, path, &error));
+  g_assert_no_error (error);
+  g_assert_true (wplua_pcall (L, 0, 0, &error));
+  g_assert_no_error (error);
+
+  g_assert_cmpint (lua_getglobal (L, "x"), ==, LUA_TNUMBER);
+  ret = lua_tointeger (L, -1);
+  wplua_unref (L);
+  return ret;
+}
+
+static guint
+count_files (const gchar *path)
+{
+  g_autoptr (GDir) dir = g_dir_open (path, 0, NULL);
+  guint n = 0;
+  while (dir && g_dir_read_name (dir))
+    n++;
+  return n;
+}
+
+static void
+test_wplua_bytecode_cache ()
+{
+  g_autoptr (GError) error = NULL;
+  g_autofree gchar *tmp = g_dir_make_tmp ("wplua-XXXXXX", &error);
+  g_assert_no_error (error);
+  g_autofree gchar *cache_dir = g_build_filename (tmp, "cache", NULL);
+  g_autofree gchar *script = g_build_filename (tmp, "script.lua", NULL);
+
+  g_assert_true (g_file_set_contents (script, "x = 1\n", -1, NULL));
+
+  /* compiled from source, then stored in the cache */
+  g_assert_cmpint (load_path_and_get_x (script, cache_dir), ==, 1);
+  g_assert_cmpuint (count_files (cache_dir), ==, 1);
+
+  /* loaded from the cache */
+  g_assert_cmpint (load_path_and_get_x (script, cache_dir), ==, 1);
+  g_assert_cmpuint (count_files (cache_dir), ==, 1);
+
+  /* the source changed; the cached chunk is replaced */
+  g_assert_true (g_file_set_contents (script, "x = 42\n", -1, NULL));
+  g_assert_cmpint (load_path_and_get_x (script, cache_dir), ==, 42);
+  g_assert_cmpuint (count_files (cache_dir), ==, 1);
+
+  /* the same goes for an edit that keeps the size and the modification
+     time of the file */
+  {
+    GStatBuf st;
+    struct utimbuf times;
+
+    g_assert_cmpint (g_stat (script, &st), ==, 0);
+    g_assert_true (g_file_set_contents (script, "x = 43\n", -1, NULL));
+    times.actime = st.st_atime;
+    times.modtime = st.st_mtime;
+    g_assert_cmpint (g_utime (script, &times), ==, 0);
+    g_assert_cmpint (load_path_and_get_x (script, cache_dir), ==, 43);
+    g_assert_cmpuint (count_files (cache_dir), ==, 1);
+
+    g_assert_true (g_file_set_contents (script, "x = 42\n", -1, NULL));
+    g_assert_cmpint (g_utime (script, &times), ==, 0);
+    g_assert_cmpint (load_path_and_get_x (script, cache_dir), ==, 42);
+  }
+
+  /* a corrupted cache falls back to the source */
+  {
+    g_autoptr (GDir) dir = g_dir_open (cache_dir, 0, NULL);
+    g_autofree gchar *cached =
+        g_build_filename (cache_dir, g_dir_read_name (dir), NULL);
+    g_autofree gchar *contents = NULL;
+    gsize len = 0;
+
+    g_assert_true (g_file_get_contents (cached, &contents, &len, NULL));
+    g_assert_cmpuint (len, >, 8);
+    g_assert_true (g_file_set_contents (cached, contents, len - 8, NULL));
+    g_assert_cmpint (load_path_and_get_x (script, cache_dir), ==, 42);
+
+    /* damaged bytecode of the right size is not loaded either */
+    g_clear_pointer (&contents, g_free);
+    g_assert_true (g_file_get_contents (cached, &contents, &len, NULL));
+    contents[len - 8] ^= 0xff;
+    g_assert_true (g_file_set_contents (cached, contents, len, NULL));
+    g_assert_cmpint (load_path_and_get_x (script, cache_dir), ==, 42);
+
+    g_assert_cmpint (g_remove (cached), ==, 0);
+  }
+
+  g_assert_cmpint (g_remove (script), ==, 0);
+  g_assert_cmpint (g_rmdir (cache_dir), ==, 0);
+  g_assert_cmpint (g_rmdir (tmp), ==, 0);
+}
+
 gint
 main (gint argc, gchar *argv[])
 {
@@ -710,9 +946,12 @@ main (gint argc, gchar *argv[])
 
   g_test_add_func ("/wplua/basic", test_wplua_basic);
   g_test_add_func ("/wplua/construct", test_wplua_construct);
+  g_test_add_func ("/wplua/object_identity", test_wplua_object_identity);
   g_test_add_func ("/wplua/properties", test_wplua_properties);
+  g_test_add_func ("/wplua/methods", test_wplua_methods);
   g_test_add_func ("/wplua/closure", test_wplua_closure);
   g_test_add_func ("/wplua/signals", test_wplua_signals);
+  g_test_add_func ("/wplua/profiler", test_wplua_profiler);
   g_test_add_func ("/wplua/sandbox/script", test_wplua_sandbox_script);
   g_test_add_func ("/wplua/sandbox/config", test_wplua_sandbox_config);
   g_test_add_func ("/wplua/convert/asv", test_wplua_convert_asv);
@@ -721,6 +960,7 @@ main (gint argc, gchar *argv[])
   g_test_add_func ("/wplua/convert/wp_properties",
       test_wplua_convert_wp_properties);
   g_test_add_func ("/wplua/script_arguments", test_wplua_script_arguments);
+  g_test_add_func ("/wplua/bytecode_cache", test_wplua_bytecode_cache);
 
   return g_test_run ();
 }